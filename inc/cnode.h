@@ -17,9 +17,18 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 
+#define CNODE_MAX_PENDING_RESULTS 16 ///< Maximum number of GET_REXEC_RES queries waiting for their instance to complete
+#define CNODE_RESULT_WAIT_MS 30000 ///< A parked GET_REXEC_RES gets REXEC_ERR_TIMEOUT after this long, the instance can still be fetched later
+#define CNODE_MAX_WAITING 32 ///< Maximum number of REXECs waiting for a free instance slot, all tasks together
+#define CNODE_MAX_FINISHED 16 ///< Maximum number of finished instances moved out of their slot, kept until their result is fetched
+#define CNODE_RESULT_KEYEXPR_LEN 96 ///< Size of the key expression of the result queryable
+#define CNODE_BATCH_WINDOW_MS 5 ///< Replies published within this window are sent in one batch (needs Z_FEATURE_BATCHING)
+#define CNODE_BATCH_MAX_BYTES 1400 ///< A batch is sent once it holds this many bytes, to stay within one Wi-Fi/UDP frame
+#define CNODE_OUTBOX_LEN 16 ///< Replies kept while the zenoh session is lost, sent in order once it is restored
+
 /* STRUCTS & TYPEDEFS */
 
-/** @brief arguments structure created by process_args() 
+/** @brief arguments structure, read from the arguments of cnode_init() 
  */
 typedef struct _cnode_args_t {
     char *tags;
@@ -31,8 +40,25 @@ typedef struct _cnode_args_t {
     char *redhost;
     int snumber;
     int nexecs;
+    char *zmode;        ///< zenoh mode, "peer" or "client", NULL to keep the stored one
+    char *transport;    ///< zenoh transport to host:port, "udp-multicast", "udp" or "tcp" (see zenoh_transport_from_str()), "scout" to find the controller (see zenoh_init_discovered()), NULL to keep the stored locator
+    char *iface;        ///< network interface of a multicast transport, NULL for none
 } cnode_args_t;
 
+/** @brief REXEC waiting for a free instance slot of its task (see task_set_wait_queue())
+ */
+typedef struct _cnode_waiting_t {
+    command_t* cmd;         ///< the REXEC, owned by the cnode while it waits
+    int64_t queued_us;      ///< jam_time_us() when it started waiting
+} cnode_waiting_t;
+
+/** @brief Reply published while the zenoh session was lost, kept until the supervisor restores it
+ */
+typedef struct _cnode_outbox_t {
+    command_t* retcmd;      ///< the reply, held (see command_hold()) by the outbox
+    zenoh_pub_t* zenoh_pub; ///< publisher it goes out with
+} cnode_outbox_t;
+
 /** @brief CNode type, which contains CNode substructures and taskboard 
  */
 typedef struct _cnode_t 
@@ -40,13 +66,33 @@ typedef struct _cnode_t
     tboard_t* tboard;                       ///< pointer to tboard_t object. used to manage tasks
     system_manager_t* system_manager;       ///< pointer to system_manager_t object. used to initiate system & wifi
     char* node_id;                          ///< randomly generated (snowflakeid) ID
+    uint32_t node_hash;                     ///< command_node_hash() of node_id, matched against the target of received attachments
     zenoh_t* zenoh;                         ///< pointer to zenoh_t object. used to send messages over the network to other cnodes/controllers.
-    zenoh_pub_t* zenoh_pub_reply;           ///< This publisher is to send replies back to controller
+    zenoh_config_t zenoh_config;            ///< session parameters used by cnode_start(), read from NVS by cnode_init() (see cnode_apply_args())
+    zenoh_pub_t* zenoh_pub_reply;           ///< This publisher is to send replies (results) back to controller
+    zenoh_pub_t* zenoh_pub_ack;             ///< publisher of the ACKs and errors, on the reply key with the control QoS (express, high priority)
     zenoh_pub_t* zenoh_pub_request;         ///< This publisher is to send commands to controller
+    int zenoh_sub_requests;                 ///< subscription (see zenoh_subscribe()) receiving the commands of the controller
+    int zenoh_sub_replies;                  ///< subscription receiving the replies of the controller
+    char result_keyexpr[CNODE_RESULT_KEYEXPR_LEN]; ///< key expression of the result queryable, "app/results/<node_id>"
     QueueHandle_t commandQueue;             ///< Queue to hold commands
     corestate_t* core_state;                ///< pointer to corestate_t object. used to store the node_id and serial_id in ROM.
     bool initialized;                       ///< boolean representing if this cnode instance has been initialized with cnode_init() or not.
     volatile bool message_received;         ///< boolean representing if a message has been received, needs to be reset manually.    
+    volatile uint32_t filtered_messages;    ///< messages dropped from their attachment, without decoding (other target node or command type not handled)
+    command_t* pending_results[CNODE_MAX_PENDING_RESULTS]; ///< GET_REXEC_RES queries answered when the tboard reports their instance complete
+    int64_t pending_since_us[CNODE_MAX_PENDING_RESULTS]; ///< jam_time_us() when each pending result query was parked
+    uint32_t completion_overflows;          ///< tboard completion ring overflows already handled
+    uint32_t query_session;                 ///< zenoh session (zenoh_t.session_seq) the parked result queries were checked against
+    cnode_waiting_t waiting[CNODE_MAX_WAITING]; ///< REXECs waiting for a free instance slot, in arrival order
+    uint32_t num_waiting;                   ///< number of entries in waiting
+    task_instance_t* finished[CNODE_MAX_FINISHED]; ///< finished instances detached from their task (see task_instance_detach()) to free the slot, until their result is fetched
+    int64_t batch_started_us;               ///< jam_time_us() when the open send batch started
+    uint32_t batch_bytes;                   ///< bytes published in the open send batch
+    uint32_t batches_sent;                  ///< send batches sent so far
+    cnode_outbox_t outbox[CNODE_OUTBOX_LEN]; ///< replies waiting for the zenoh session, in order
+    uint32_t outbox_len;                    ///< number of entries in outbox
+    uint32_t outbox_drops;                  ///< replies dropped because the outbox was full
 } cnode_t;
 
 /* FUNCTION PROTOTYPES */
@@ -55,12 +101,24 @@ typedef struct _cnode_t
  * @brief Constructor. Initiates the cnode structure and initiates all of its components. E.g., we 
  * call system_manager_init(), zenoh_init(), ...
  * @param argc cmd line argument count
- * @param argv cmd line args
+ * @param argv cmd line args, argv[0] is the program name. "--zmode=", "--transport=", "--host=", "--port=" and
+ * "--iface=" set the fields of cnode_args_t applied with cnode_apply_args(), "--save" also stores them. Invalid
+ * arguments are reported and ignored, the stored parameters are then used.
  * @return pointer to cnode_t struct
- * @todo What should be expected from argv? e.g. Wi-Fi SSID & Password ?
 */
 cnode_t*    cnode_init(int argc, char** argv);
 
+/**
+ * @brief Overrides the stored zenoh session parameters with the arguments (zmode, transport, host, port, iface), for
+ * the next cnode_start().
+ * @param cn pointer to cnode_t struct, initialized and not started
+ * @param args arguments, the NULL fields keep the stored parameters
+ * @param save also store the resulting parameters in NVS, used from the next boot
+ * @retval true parameters applied (and saved)
+ * @retval false invalid mode or transport, or the save failed
+*/
+bool        cnode_apply_args(cnode_t* cn, const cnode_args_t* args, bool save);
+
 /**
  * @brief Destructor. Frees memory allocated during cnode_init().
  * @warning cnode_stop(cn) must have been called first
@@ -108,6 +166,15 @@ bool        cnode_send_cmd(cnode_t* cnode, command_t* cmd);
  */
 bool        cnode_send_error(cnode_t* cn, command_t* cmd);
 
+/**
+ * @brief Sends an error carrying an error code (single int argument) to the Zenoh network. 
+ * @param cnode Pointer to the cnode_t instance representing the current node.
+ * @param cmd Pointer to the command_t object the error refers to.
+ * @param error Error code, e.g. REXEC_ERR_DEADLINE_EXPIRED when the task was dropped without running.
+ * @return True if the command was successfully sent, false otherwise.
+ */
+bool        cnode_send_error_code(cnode_t* cn, command_t* cmd, rexec_error_t error);
+
 /**
  * @brief Sends an ack to the Zenoh network. 
  * @param cnode Pointer to the cnode_t instance representing the current node.
@@ -115,4 +182,14 @@ bool        cnode_send_error(cnode_t* cn, command_t* cmd);
  * @return True if the command was successfully sent, false otherwise.
  */
 bool        cnode_send_ack(cnode_t* cn, command_t* cmd);
+
+/**
+ * @brief Sends the ack of a REXEC that waited for a free instance slot. It carries one int argument: the time the REXEC
+ * waited, in milliseconds.
+ * @param cnode Pointer to the cnode_t instance representing the current node.
+ * @param cmd Pointer to the REXEC.
+ * @param waited_ms Time the REXEC waited before it started.
+ * @return True if the command was successfully sent, false otherwise.
+ */
+bool        cnode_send_ack_waited(cnode_t* cn, command_t* cmd, uint32_t waited_ms);
 #endif
\ No newline at end of file
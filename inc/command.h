@@ -47,10 +47,24 @@ typedef enum _jamcommand_t{
     CMD_REXEC_ERR,
     CMD_GET_REXEC_RES,
     CMD_CLOSE_PORT,
+    CMD_REXEC_BATCH,    ///< REXEC whose args field is an array of argument tuples (their number in the batch field), executed as one instance
+    CMD_REXEC_CANCEL,   ///< Cancel the instance started by the REXEC with the same fn_name and taskid
+    CMD_GET_STATS,      ///< Query the accounting of task fn_name, answered by a REXEC_RES with TASK_STATS_NUM_VALUES ints
 
 } jamcommand_t;
 // only most barebone commands right now
 
+/** @brief Error codes carried as the single int argument of a CMD_REXEC_ERR.
+ */
+typedef enum _rexec_error_t{
+    REXEC_ERR_NONE,             ///< No error
+    REXEC_ERR_FAILED,           ///< Unknown command, task could not be started or has no result
+    REXEC_ERR_DEADLINE_EXPIRED, ///< The deadline passed before the task could start, it was dropped without running
+    REXEC_ERR_TIMEOUT,          ///< The task ran longer than its execution timeout and was stopped
+    REXEC_ERR_CANCELLED,        ///< The task was cancelled (CMD_REXEC_CANCEL or tboard shutdown)
+    REXEC_ERR_BUSY,             ///< Every instance slot of the task was taken and the wait queue was full or timed out
+} rexec_error_t;
+
 // NOTE: These are past commands that aren't used right now
 // #define CmdNames_REGISTER 1001
 // #define CmdNames_REGISTER_ACK 1002
@@ -141,10 +155,30 @@ typedef struct _command_t {
     unsigned char buffer[HUGE_CMD_STR_LEN];     ///< CBOR serialized data
     int length;                                 ///< Length of CBOR data
     arg_t* args;                                ///< List of arguments
+    int batch_size;                             ///< Number of argument tuples in args for CMD_REXEC_BATCH, 0 otherwise
+    int64_t deadline_ms;                        ///< Optional relative deadline (ms after reception), 0 if none
+    int64_t deadline_at;                        ///< Optional absolute deadline (unix time in ms), 0 if none
+    int64_t deadline_us;                        ///< Local deadline on the jam_time_us() clock, set by the receiver, 0 if none
+    void* reply_query;                          ///< Zenoh query (z_owned_query_t) to answer instead of publishing the reply, set by the receiver, NULL if none
+    uint32_t reply_session;                     ///< Session reply_query was received on (zenoh_t.session_seq), set by the receiver
     int refcount;                               ///< Reference counter for memory management
     long id;                                    ///< Unique command ID
 } command_t;
 
+#define COMMAND_ATTACHMENT_LEN 16 ///< Length of an encoded command attachment (bytes)
+#define COMMAND_ATTACHMENT_VERSION 1 ///< Version of the attachment layout, first byte of the attachment
+
+/** @brief Routing metadata sent as a zenoh attachment next to the CBOR body of a command, so that a receiver can
+ * accept, drop or prioritize the message without decoding the body.
+ * Encoded layout (little endian): version (1 byte), cmd (1), priority (1), reserved (1), target (4), task_id (8).
+ */
+typedef struct _command_attachment_t {
+    jamcommand_t cmd;           ///< Command type
+    uint8_t priority;           ///< 0 for normal traffic, higher values are handled first (REXECs only, other commands keep their order)
+    uint32_t target;            ///< command_node_hash() of the node the command is for, 0 for every node
+    uint64_t task_id;           ///< Task identifier
+} command_attachment_t;
+
 /** @brief Structure for handling internal commands within the system.
  * A simplified command representation used for internal processing.
  */
@@ -197,6 +231,39 @@ command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_na
                                  uint64_t taskid, const char* node_id,
                                  const char* fn_argsig, arg_t* args);
 
+/**
+ * @brief Creates a new command object that takes ownership of an argument list. Unlike command_new_using_arg(), args is
+ * not cloned: it is encoded in place and released once, together with its string and nvoid values, by command_free().
+ * @param cmd Command type
+ * @param subcmd Subcommand identifier
+ * @param fn_name Function name
+ * @param taskid Task identifier
+ * @param node_id Node UUID
+ * @param fn_argsig Argument signature
+ * @param args Pointer to argument list, owned by the command from now on (must not be used or freed by the caller)
+ * @return Pointer to newly allocated command object
+ */
+command_t* command_new_taking_arg(jamcommand_t cmd, int subcmd, const char* fn_name,
+                                  uint64_t taskid, const char* node_id,
+                                  const char* fn_argsig, arg_t* args);
+
+/**
+ * @brief Creates a new batch command. The args array holds batch_size argument tuples of equal arity
+ * (args[0].nargs == batch_size * arity) and is encoded as an array of arrays, with batch_size in the "batch" field.
+ * @param cmd Command type (usually CMD_REXEC_BATCH)
+ * @param subcmd Subcommand identifier
+ * @param fn_name Function name
+ * @param taskid Task identifier
+ * @param node_id Node UUID
+ * @param fn_argsig Argument signature of a single tuple
+ * @param args Pointer to the flattened argument tuples
+ * @param batch_size Number of tuples
+ * @return Pointer to newly allocated command object, NULL if args do not split into batch_size tuples
+ */
+command_t* command_new_batch_using_arg(jamcommand_t cmd, int subcmd, const char* fn_name,
+                                       uint64_t taskid, const char* node_id,
+                                       const char* fn_argsig, arg_t* args, int batch_size);
+
 /**
  * @brief Initializes an existing command object using arguments
  * @param command Pointer to command object
@@ -231,6 +298,39 @@ void command_from_data_inplace(command_t* cmdo, const char* fn_argsig, int len);
 
 /* METHODS FOR COMMAND OBJECT */
 
+/**
+ * @brief Hashes a node id into the target field of a command attachment (32-bit FNV-1a)
+ * @param node_id Node id, NULL or empty for every node
+ * @return Hash of the node id, never 0; 0 if node_id is NULL or empty
+ */
+uint32_t command_node_hash(const char* node_id);
+
+/**
+ * @brief Fills the attachment of a command
+ * @param att Pointer to the attachment to fill
+ * @param cmd Pointer to the command
+ * @param target_node_id Node the command is for, NULL for every node
+ * @param priority 0 for normal traffic, higher values are handled first (REXECs only, other commands keep their order)
+ */
+void command_attachment_init(command_attachment_t* att, const command_t* cmd, const char* target_node_id, uint8_t priority);
+
+/**
+ * @brief Encodes an attachment
+ * @param att Pointer to the attachment
+ * @param buffer Buffer of at least COMMAND_ATTACHMENT_LEN bytes
+ * @return Number of bytes written (COMMAND_ATTACHMENT_LEN)
+ */
+size_t command_attachment_encode(const command_attachment_t* att, uint8_t* buffer);
+
+/**
+ * @brief Decodes an attachment
+ * @param buffer Encoded attachment
+ * @param len Length of buffer
+ * @param att Pointer to the decoded attachment
+ * @return Boolean indicating success, false if the length or the version does not match
+ */
+bool command_attachment_decode(const uint8_t* buffer, size_t len, command_attachment_t* att);
+
 /**
  * @brief Increments reference count of a command object
  * @param cmd Pointer to command object
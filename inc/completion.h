@@ -0,0 +1,79 @@
+/** @addtogroup completion
+ * @{
+ * @brief The completion module provides a bounded lock-free multi-producer / single-consumer ring of instance
+ * completion events. The @ref tboard pushes an event whenever an instance is over (from the scheduler, the coroutine
+ * worker or a cancellation) and the @ref cnode drains the ring to dispatch results. It is plain C11 (stdatomic).
+ */
+#ifndef __COMPLETION_H__
+#define __COMPLETION_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define COMPLETION_RING_SIZE 64 ///< Number of slots in a completion ring, must be a power of two
+
+/* STRUCTS & TYPEDEFS */
+
+/**
+ * @brief An instance is over (it returned, was dropped, timed out or was cancelled).
+ * @note The instance itself may already have been destroyed by its owner when the event is consumed, so the event only
+ * identifies it: look it up with task_get_instance_index().
+ */
+typedef struct _completion_event_t
+{
+    void*       task;       ///< task_t* of the instance
+    uint32_t    serial_id;  ///< serial id of the instance
+    int32_t     error;      ///< rexec_error_t of the instance, REXEC_ERR_NONE if it returned normally
+} completion_event_t;
+
+/**
+ * @brief One slot of the ring. seq tells producers and the consumer whose turn it is.
+ */
+typedef struct _completion_slot_t
+{
+    _Atomic uint32_t seq;       ///< position the slot is ready for
+    completion_event_t event;   ///< event stored in the slot
+} completion_slot_t;
+
+/**
+ * @brief Bounded multi-producer single-consumer ring.
+ */
+typedef struct _completion_ring_t
+{
+    completion_slot_t slots[COMPLETION_RING_SIZE]; ///< ring storage
+    _Atomic uint32_t head;                          ///< next position claimed by a producer
+    uint32_t tail;                                  ///< next position read by the consumer
+    _Atomic uint32_t overflows;                     ///< events lost because the ring was full
+} completion_ring_t;
+
+/* FUNCTION PROTOTYPES */
+
+/**
+ * @brief Initializes an empty ring.
+ * @param ring pointer to completion_ring_t struct
+*/
+void        completion_ring_init(completion_ring_t* ring);
+
+/**
+ * @brief Adds an event. Lock-free, can be called concurrently from any number of tasks.
+ * @param ring pointer to completion_ring_t struct
+ * @param event event to copy into the ring
+ * @retval true event added
+ * @retval false ring is full, the event is lost and counted in overflows
+*/
+bool        completion_ring_push(completion_ring_t* ring, const completion_event_t* event);
+
+/**
+ * @brief Removes the oldest event. Must only be called by the single consumer of the ring.
+ * @param ring pointer to completion_ring_t struct
+ * @param event filled with the removed event
+ * @retval true an event was removed
+ * @retval false ring is empty
+*/
+bool        completion_ring_pop(completion_ring_t* ring, completion_event_t* event);
+#endif // __COMPLETION_H__
+/**
+ * @}
+*/
@@ -7,8 +7,11 @@
 #define __CORE_H__
 
 #include "utils.h"
+#include <stddef.h>
 // TODO: move discountFlake to an util section
 
+#define CORE_HOST_STORE_DIR "." ///< Directory holding the key/value files that stand in for NVS on host (linux target) builds
+
 /* STRUCTS & TYPEDEFS */
 
 /**
@@ -49,6 +52,38 @@ void core_setup(corestate_t *cs);
  * @retval 0 ID generation successful
 */
 int discountflake(char *buffer);
+
+/**
+ * @brief Reads a blob previously stored with core_store_set_blob(). Backed by NVS on the ESP32 and by
+ * a file (CORE_HOST_STORE_DIR/namespace.key) on host builds.
+ * @param space NVS namespace (max 15 characters)
+ * @param key NVS key (max 15 characters)
+ * @param data buffer receiving the blob
+ * @param len in: size of data, out: number of bytes read
+ * @retval true blob found and read
+ * @retval false blob not found, too large or storage unavailable
+*/
+bool core_store_get_blob(const char* space, const char* key, void* data, size_t* len);
+
+/**
+ * @brief Stores a blob in persistent storage (NVS on the ESP32, a file on host builds).
+ * @param space NVS namespace (max 15 characters)
+ * @param key NVS key (max 15 characters)
+ * @param data pointer to the data to store
+ * @param len number of bytes to store
+ * @retval true blob stored and committed
+ * @retval false storage unavailable or write failed
+*/
+bool core_store_set_blob(const char* space, const char* key, const void* data, size_t len);
+
+/**
+ * @brief Removes a blob stored with core_store_set_blob().
+ * @param space NVS namespace (max 15 characters)
+ * @param key NVS key (max 15 characters)
+ * @retval true blob removed, or there was none
+ * @retval false storage unavailable or the removal failed
+*/
+bool core_store_erase(const char* space, const char* key);
 #endif
 /**
  * @}
@@ -0,0 +1,172 @@
+/** @addtogroup sched
+ * @{
+ * @brief The sched module provides the ready queues and the dispatcher used by the @ref tboard to decide which pending
+ * instance runs next. It is plain C without FreeRTOS dependencies so that the dispatching can also be exercised on the
+ * host (see tests/tboard/tboard_sim_test.c).
+ */
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SCHED_QUEUE_CAPACITY 64 ///< Maximum number of pending entries in a ready queue
+#define SCHED_NO_DEADLINE UINT64_MAX ///< Deadline value of entries without a deadline (they run after all entries with one)
+
+/* STRUCTS & TYPEDEFS */
+
+/**
+ * @brief Order in which entries leave the ready queue.
+ */
+typedef enum _sched_policy_t
+{
+    SCHED_POLICY_FIFO,  ///< arrival order
+    SCHED_POLICY_EDF    ///< earliest deadline first, arrival order between equal deadlines
+} sched_policy_t;
+
+/**
+ * @brief One pending entry of the ready queue.
+ */
+typedef struct _sched_entry_t
+{
+    uint64_t deadline;  ///< absolute deadline (same time base as the caller, SCHED_NO_DEADLINE if none)
+    uint32_t seq;       ///< arrival sequence number, used to break ties
+    void* item;         ///< caller data, e.g. a task_instance_t*
+} sched_entry_t;
+
+/**
+ * @brief Ready queue, a binary min-heap ordered according to the policy.
+ */
+typedef struct _sched_queue_t
+{
+    sched_entry_t entries[SCHED_QUEUE_CAPACITY]; ///< heap storage
+    uint32_t size;                               ///< number of pending entries
+    uint32_t next_seq;                           ///< sequence number given to the next pushed entry
+    sched_policy_t policy;                       ///< ordering policy
+} sched_queue_t;
+
+/**
+ * @brief What sched_dispatcher_next() decided for the entry it removed.
+ */
+typedef enum _sched_dispatch_t
+{
+    SCHED_DISPATCH_NONE,    ///< nothing to do: both queues are empty or no slot is free
+    SCHED_DISPATCH_START,   ///< start the entry, it now holds a slot until sched_dispatcher_done()
+    SCHED_DISPATCH_EXPIRED  ///< drop the entry, its deadline passed while it was queued
+} sched_dispatch_t;
+
+/**
+ * @brief Dispatcher: entries with a deadline in policy order, the others in arrival order, and the execution slots.
+ * At most max_deadline_running entries with a deadline and max_running entries in total hold a slot, entries with a
+ * deadline go first.
+ */
+typedef struct _sched_dispatcher_t
+{
+    sched_queue_t deadline_queue;   ///< pending entries with a deadline, ordered according to the policy
+    sched_queue_t fifo_queue;       ///< pending entries without a deadline, in arrival order
+    uint32_t max_running;           ///< slots, for entries with or without a deadline
+    uint32_t max_deadline_running;  ///< slots entries with a deadline can take
+    uint32_t num_running;           ///< started entries not done yet
+    uint32_t num_deadline_running;  ///< number of them with a deadline
+} sched_dispatcher_t;
+
+/* FUNCTION PROTOTYPES */
+
+/**
+ * @brief Initializes an empty ready queue.
+ * @param queue pointer to sched_queue_t struct
+ * @param policy ordering policy
+*/
+void        sched_queue_init(sched_queue_t* queue, sched_policy_t policy);
+
+/**
+ * @brief Adds an entry to the ready queue.
+ * @param queue pointer to sched_queue_t struct
+ * @param item caller data
+ * @param deadline absolute deadline of the entry, SCHED_NO_DEADLINE if none
+ * @retval true entry added
+ * @retval false queue is full
+*/
+bool        sched_queue_push(sched_queue_t* queue, void* item, uint64_t deadline);
+
+/**
+ * @brief Returns the entry that would be popped next without removing it.
+ * @param queue pointer to sched_queue_t struct
+ * @returns pointer to the head entry, NULL if the queue is empty
+*/
+const sched_entry_t* sched_queue_peek(const sched_queue_t* queue);
+
+/**
+ * @brief Removes the head entry of the ready queue.
+ * @param queue pointer to sched_queue_t struct
+ * @param entry filled with the removed entry (can be NULL)
+ * @retval true an entry was removed
+ * @retval false queue is empty
+*/
+bool        sched_queue_pop(sched_queue_t* queue, sched_entry_t* entry);
+
+/**
+ * @brief Removes the entry holding a given item, wherever it is in the queue.
+ * @param queue pointer to sched_queue_t struct
+ * @param item caller data to look for
+ * @retval true the item was found and removed
+ * @retval false the item is not queued
+*/
+bool        sched_queue_remove(sched_queue_t* queue, void* item);
+
+/**
+ * @brief Initializes a dispatcher with empty queues and no running entry.
+ * @param dispatcher pointer to sched_dispatcher_t struct
+ * @param policy ordering policy of the entries with a deadline
+ * @param max_running slots, for entries with or without a deadline
+ * @param max_deadline_running slots entries with a deadline can take
+*/
+void        sched_dispatcher_init(sched_dispatcher_t* dispatcher, sched_policy_t policy, uint32_t max_running,
+                                  uint32_t max_deadline_running);
+
+/**
+ * @brief Queues an entry, with the ones having a deadline or with the others.
+ * @param dispatcher pointer to sched_dispatcher_t struct
+ * @param item caller data
+ * @param deadline absolute deadline of the entry, SCHED_NO_DEADLINE if none
+ * @retval true entry queued
+ * @retval false its queue is full
+*/
+bool        sched_dispatcher_push(sched_dispatcher_t* dispatcher, void* item, uint64_t deadline);
+
+/**
+ * @brief Removes the next entry to handle at a given time. Call it until it returns SCHED_DISPATCH_NONE.
+ * @param dispatcher pointer to sched_dispatcher_t struct
+ * @param now current time, same time base as the deadlines
+ * @param entry filled with the removed entry
+ * @returns SCHED_DISPATCH_START if the entry took a slot, SCHED_DISPATCH_EXPIRED if its deadline is not after now (it
+ * did not take a slot), SCHED_DISPATCH_NONE if no entry was removed
+*/
+sched_dispatch_t sched_dispatcher_next(sched_dispatcher_t* dispatcher, uint64_t now, sched_entry_t* entry);
+
+/**
+ * @brief Gives back the slot of a started entry.
+ * @param dispatcher pointer to sched_dispatcher_t struct
+ * @param deadline deadline the entry was pushed with
+*/
+void        sched_dispatcher_done(sched_dispatcher_t* dispatcher, uint64_t deadline);
+
+/**
+ * @brief Removes a pending entry from whichever queue holds it.
+ * @param dispatcher pointer to sched_dispatcher_t struct
+ * @param item caller data to look for
+ * @retval true the item was found and removed
+ * @retval false the item is not queued
+*/
+bool        sched_dispatcher_remove(sched_dispatcher_t* dispatcher, void* item);
+
+/**
+ * @brief Number of pending entries in both queues.
+ * @param dispatcher pointer to sched_dispatcher_t struct
+*/
+uint32_t    sched_dispatcher_queued(const sched_dispatcher_t* dispatcher);
+#endif // __SCHED_H__
+/**
+ * @}
+*/
@@ -11,6 +11,7 @@
 #include <freertos/task.h>
 #include <stdarg.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "command.h"
 #include "utils.h"
 
@@ -18,16 +19,104 @@
 #define MAX_ARGS 20 ///< Maximum number of arguments 
 #define MAX_TASKS 20 ///< Maximum number of tasks
 #define MAX_INSTANCES 5 ///< Maximum number of instances per task
+#define MAX_CO_INSTANCES 64 ///< Maximum number of instances per coroutine task (they do not own a stack)
+#define MAX_BATCH 64 ///< Maximum number of argument tuples in one batch invocation
+#define TASK_DESC_NAME_MAX 32 ///< Longest task name accepted in a task registry (see TASK_DESC())
+
+/**
+ * @brief How the instances of a task are executed.
+ */
+typedef enum _task_exec_mode_t
+{
+    TASK_EXEC_THREAD,       ///< every instance is a FreeRTOS task with its own stack (default)
+    TASK_EXEC_COROUTINE     ///< instances are stackless coroutines multiplexed onto the tboard coroutine worker
+} task_exec_mode_t;
+
+/**
+ * @brief State of a coroutine stub after it returns to the coroutine worker.
+ */
+typedef enum _task_co_status_t
+{
+    TASK_CO_DONE = 0,       ///< the stub ran to completion (a plain stub always ends up here)
+    TASK_CO_YIELDED,        ///< the stub yielded and is resumed on the next round
+    TASK_CO_WAITING         ///< the stub sleeps until co_wake_tick
+} task_co_status_t;
+
+/**
+ * @brief Life cycle of a task instance. Transitions out of TASK_INSTANCE_RUNNING are made with a compare-and-swap so
+ * that exactly one of the instance itself (it returned) and the tboard (it deleted the instance) completes it.
+ */
+typedef enum _task_instance_state_t
+{
+    TASK_INSTANCE_PENDING = 0,  ///< created, waiting for an execution slot or the coroutine worker
+    TASK_INSTANCE_RUNNING,      ///< handed over to its FreeRTOS task or to the coroutine worker
+    TASK_INSTANCE_EXITED,       ///< the entry point of a thread instance returned, the scheduler completes it
+    TASK_INSTANCE_KILLED,       ///< the tboard deleted a thread instance that ignored its cancellation
+    TASK_INSTANCE_FINISHED      ///< over, has_finished is set
+} task_instance_state_t;
 
 /**
  * @brief Structure containing the execution context of a currently executing task.
+ * @note The co_* fields are the continuation of a coroutine instance and are only used in TASK_EXEC_COROUTINE mode.
  */
 typedef struct _execution_context_t
 {
     arg_t* query_args; ///< query arguments to the task
-    arg_t* return_arg; ///< return argument 
+    arg_t* return_arg; ///< return argument. A string or nvoid value stored here belongs to the instance and is freed with it: store a heap copy (see task_return_string()), never a literal or one of the arguments
+    uint32_t co_line; ///< resume point of a coroutine stub, 0 when starting
+    task_co_status_t co_status; ///< set by the TASK_CO_* macros when the stub returns to the worker
+    TickType_t co_wake_tick; ///< tick at which a waiting coroutine is resumed
+    void* co_locals; ///< per-instance storage for the locals that must survive a yield (see task_set_coroutine_mode())
+    volatile bool* cancelled; ///< becomes true when the instance is cancelled or times out, see TASK_CHECKPOINT()
 } execution_context_t;
 
+/**
+ * @brief True once the instance has been cancelled or has exceeded its execution timeout.
+ * Long running stubs should poll it (or use TASK_CHECKPOINT()) and return early; a thread instance that does not return
+ * within TBOARD_CANCEL_GRACE_MS is deleted by the tboard.
+ */
+#define TASK_CANCELLED(ctx)     ((ctx)->cancelled != NULL && *(ctx)->cancelled)
+/** @brief Cooperative cancellation point: returns from the stub if the instance has been cancelled */
+#define TASK_CHECKPOINT(ctx)    do { if (TASK_CANCELLED(ctx)) return; } while (0)
+
+/**
+ * @defgroup task_coroutine Coroutine stubs
+ * @brief Macros used to write stubs for TASK_EXEC_COROUTINE tasks. Locals are lost across a yield, so state that must
+ * survive has to be kept in TASK_CO_LOCALS(). Example:
+ * @code
+ * void entry_point_poll(execution_context_t* ctx) {
+ *     poll_state_t* st = TASK_CO_LOCALS(ctx, poll_state_t);
+ *     TASK_CO_BEGIN(ctx);
+ *     for (st->i = 0; st->i < 10; st->i++) {
+ *         TASK_CO_SLEEP_MS(ctx, 100);
+ *     }
+ *     TASK_CO_END(ctx);
+ * }
+ * @endcode
+ * @{
+ */
+#define TASK_CO_LOCALS(ctx, type)   ((type*) (ctx)->co_locals) ///< Access the coroutine locals of this instance
+#define TASK_CO_BEGIN(ctx)          switch ((ctx)->co_line) { case 0: ///< Must be the first statement of a coroutine stub
+#define TASK_CO_END(ctx)            } (ctx)->co_line = 0; (ctx)->co_status = TASK_CO_DONE ///< Must be the last statement of a coroutine stub
+
+/** @brief Give the worker to other coroutines, continue on the next round */
+#define TASK_CO_YIELD(ctx) do { \
+        (ctx)->co_line = __LINE__; (ctx)->co_status = TASK_CO_YIELDED; return; case __LINE__:; \
+    } while (0)
+
+/** @brief Sleep for ms milliseconds without holding the worker */
+#define TASK_CO_SLEEP_MS(ctx, ms) do { \
+        (ctx)->co_wake_tick = xTaskGetTickCount() + pdMS_TO_TICKS(ms); \
+        (ctx)->co_line = __LINE__; (ctx)->co_status = TASK_CO_WAITING; return; case __LINE__:; \
+    } while (0)
+
+/** @brief Wait until cond is true (e.g. a network result arrived), re-evaluated every round */
+#define TASK_CO_AWAIT(ctx, cond) do { \
+        (ctx)->co_line = __LINE__; __attribute__((fallthrough)); case __LINE__: \
+        if (!(cond)) { (ctx)->co_status = TASK_CO_YIELDED; return; } \
+    } while (0)
+/** @} */
+
 
 /**
  * @brief Function pointer to a function that returns void and takes in a execution_context_t* (function_stub)
@@ -36,19 +125,103 @@ typedef void (*function_stub_t)(execution_context_t*);
 
 typedef struct _task_instance_t task_instance_t;
 
+/**
+ * @brief Resource accounting of the instances of a task that started executing. Times are in microseconds. It is
+ * written only by the context that completes the instances of the task (the tboard scheduler, or the coroutine worker
+ * in coroutine mode), read it with task_get_stats().
+*/
+typedef struct _task_stats_t
+{
+    uint32_t runs; ///< accounted instances
+    int64_t total_wall_us; ///< time from start to completion, summed over the runs
+    int64_t max_wall_us; ///< longest run
+    int64_t total_cpu_us; ///< CPU time (FreeRTOS run-time stats, thread CPU clock on the host), 0 if unavailable
+    int64_t max_cpu_us; ///< largest CPU time of a run
+    int64_t total_wait_us; ///< time spent queued between submission and start
+    int64_t max_wait_us; ///< longest queue wait
+    uint64_t total_heap_bytes; ///< bytes allocated while the instances ran (MEMORY_DEBUG builds, see jam_alloc_hook)
+    uint32_t max_heap_bytes; ///< most bytes allocated by one run
+} task_stats_t;
+
+#define TASK_STATS_NUM_VALUES 8 ///< Number of int values in the reply of a CMD_GET_STATS (see jamcommand_t)
+
 /**
  * @brief Structure representing one task that is to be run by tboard.
 */
 typedef struct _task_t
 {
     char* name; ///< string: name of the task
+    uint32_t name_hash; ///< jam_name_hash() of the name, compared before the name itself on lookups
     argtype_t return_type; // return type
     char* fn_argsig; ///< string representing the argument signature in compact form. i.e., "iis" => (int, int, string)
     function_stub_t entry_point; ///< function pointer; represents the entry point to the stub of this function
-    task_instance_t* instances[MAX_INSTANCES];  ///< array of pointers to task_instance_t structs
+    task_instance_t** instances;  ///< array of max_instances pointers to task_instance_t structs
+    uint32_t max_instances; ///< size of the instances array (MAX_INSTANCES, or MAX_CO_INSTANCES in coroutine mode)
     uint32_t num_instances; ///< keeps track of the number of instances of this specific task
+    task_exec_mode_t exec_mode; ///< thread (default) or coroutine execution
+    uint32_t co_locals_size; ///< bytes of TASK_CO_LOCALS() storage given to each coroutine instance
+    _Atomic uint32_t max_stack_used; ///< largest stack usage (bytes) observed when an instance completed, including previous boots
+    _Atomic uint32_t stack_samples; ///< number of instances whose stack usage was sampled since boot
+    _Atomic uint32_t deadline_drops; ///< instances dropped without running because their deadline had passed
+    _Atomic uint32_t deadline_misses; ///< instances that ran but completed after their deadline
+    uint32_t timeout_ms; ///< execution timeout of an instance, 0 for none (see task_set_timeout())
+    _Atomic uint32_t timeouts; ///< instances stopped because they exceeded the timeout
+    _Atomic uint32_t cancellations; ///< instances cancelled before completion
+    uint32_t wait_depth; ///< REXECs that may wait for a free instance slot, 0 to reject them at once (see task_set_wait_queue())
+    uint32_t wait_timeout_ms; ///< longest wait for a free instance slot, 0 for no limit
+    uint32_t wait_drops; ///< REXECs rejected because the wait queue was full or their wait timed out
+    task_stats_t stats; ///< wall, CPU, queue wait and heap accounting of the instances that ran
 } task_t;
 
+/**
+ * @brief Constant description of an exported function. Tables of descriptors are built with TASK_REGISTRY() and stay in
+ * flash; the tboard allocates a task_t for a descriptor only when its function is used for the first time.
+*/
+typedef struct _task_desc_t
+{
+    const char* name; ///< name of the task
+    uint32_t name_hash; ///< jam_name_hash() of the name, computed at compile time
+    const char* fn_argsig; ///< argument signature in compact form
+    argtype_t return_type; ///< return type
+    function_stub_t entry_point; ///< stub of the function
+    task_exec_mode_t exec_mode; ///< thread or coroutine execution
+    uint32_t co_locals_size; ///< bytes of TASK_CO_LOCALS() storage of a coroutine task, 0 otherwise
+    uint32_t timeout_ms; ///< execution timeout of an instance, 0 for none
+} task_desc_t;
+
+/* Fails the build when cond is false, usable inside an initializer (evaluates to 0) */
+#define TASK_DESC_CHECK(cond, msg) (0 * sizeof(struct { _Static_assert(cond, msg); int _check; }))
+
+/**
+ * @brief Descriptor with every attribute given. name and argsig must be string literals; their length, the return
+ * type and the execution attributes are checked at compile time.
+*/
+#define TASK_DESC_FULL(name, return_type, argsig, entry_point, exec_mode, co_locals_size, timeout_ms) \
+    { name, \
+      JAM_NAME_HASH(name) \
+          + TASK_DESC_CHECK(sizeof(name) > 1 && sizeof(name) - 1 <= TASK_DESC_NAME_MAX, "bad task name length: " name) \
+          + TASK_DESC_CHECK(sizeof(argsig) - 1 <= MAX_ARGS, "too many arguments: " name) \
+          + TASK_DESC_CHECK((return_type) >= NULL_TYPE && (return_type) <= VOID_TYPE, "bad return type: " name) \
+          + TASK_DESC_CHECK((exec_mode) == TASK_EXEC_COROUTINE || (co_locals_size) == 0, "locals of a thread task: " name), \
+      argsig, return_type, entry_point, exec_mode, co_locals_size, timeout_ms }
+
+/** @brief Descriptor of a thread task, see TASK_DESC_FULL(). */
+#define TASK_DESC(name, return_type, argsig, entry_point) \
+    TASK_DESC_FULL(name, return_type, argsig, entry_point, TASK_EXEC_THREAD, 0, 0)
+
+/** @brief Descriptor of a coroutine task with locals_size bytes of TASK_CO_LOCALS() storage, see TASK_DESC_FULL(). */
+#define TASK_DESC_COROUTINE(name, return_type, argsig, entry_point, locals_size) \
+    TASK_DESC_FULL(name, return_type, argsig, entry_point, TASK_EXEC_COROUTINE, locals_size, 0)
+
+/**
+ * @brief Declares a constant task registry: TASK_REGISTRY(app_tasks, TASK_DESC("add", INT_TYPE, "ii", add_stub), ...).
+ * The descriptors must be sorted by name (strcmp() order), see tboard_set_registry().
+*/
+#define TASK_REGISTRY(table, ...) static const task_desc_t table[] = { __VA_ARGS__ }
+
+/** @brief Number of descriptors in a table declared with TASK_REGISTRY(). */
+#define TASK_REGISTRY_SIZE(table) (sizeof(table) / sizeof((table)[0]))
+
 /**
  * @brief Structure representing instance of a task to be run by the tboard.
 */
@@ -56,11 +229,29 @@ typedef struct _task_instance_t
 {
     volatile bool is_running;
     volatile bool has_finished;
+    _Atomic task_instance_state_t state; ///< see task_instance_state_t
     uint32_t serial_id;
     TaskHandle_t task_handle_frtos;
-    arg_t* return_arg; ///< return value and type
-    arg_t* args; ///< array of arg_t objects for the arguments 
+    uint32_t stack_size; ///< stack size (bytes) the instance was started with
+    uint32_t stack_used; ///< stack usage (bytes) sampled when the instance completed
+    arg_t* return_arg; ///< return value and type (an array of batch_size results for a batch invocation), string and nvoid values are heap allocated by the stub and owned by the instance
+    arg_t* args; ///< array of arg_t objects for the arguments (batch_size consecutive tuples for a batch invocation)
+    uint32_t batch_size; ///< number of argument tuples run by this instance, 0 for a normal invocation
+    int64_t deadline_us; ///< absolute deadline on the jam_time_us() clock, 0 if none
+    int64_t release_us; ///< nominal release time of a periodic instance, 0 otherwise
+    int64_t queued_us; ///< time the instance was handed over to the scheduler or the coroutine worker
+    int64_t start_us; ///< time the instance started executing, 0 if it has not started
+    int64_t end_us; ///< time the instance stopped executing, 0 while it runs
+    uint32_t cpu_us; ///< CPU time used by the instance so far (see jam_task_cpu_ticks())
+    uint32_t heap_bytes; ///< bytes allocated by the instance so far (MEMORY_DEBUG builds)
+    int64_t timeout_at_us; ///< time at which the running instance times out, 0 if the task has no timeout
+    int64_t kill_at_us; ///< time at which a cancelled thread instance that has not returned yet is deleted
+    volatile bool cancel_requested; ///< set on cancellation or timeout, polled through TASK_CHECKPOINT()
+    rexec_error_t error; ///< why the instance finished without running, REXEC_ERR_NONE if it ran
+    _Atomic(TaskHandle_t) waiter; ///< task blocked in tboard_future_wait() on this instance, notified when it completes
     task_t* parent_task; ///< pointer to parent task
+    bool detached; ///< removed from parent_task->instances by task_instance_detach(), destroyed by whoever detached it
+    execution_context_t ctx; ///< persistent execution context (continuation) of a coroutine instance
 };
 
 
@@ -78,6 +269,44 @@ typedef struct _task_instance_t
 task_t*     task_create(char* name, argtype_t return_type, char* fn_argsig, function_stub_t entry_point);
 
 
+/**
+ * @brief Constructor from a registry descriptor. The name and argsig strings are used in place (they stay in flash),
+ * the execution attributes of the descriptor are applied.
+ * @param desc pointer to the task_desc_t
+ * @returns pointer to the task_t, NULL if it could not be allocated
+*/
+task_t*     task_create_from_desc(const task_desc_t* desc);
+
+/**
+ * @brief Switches a task to coroutine execution. Its instances no longer get their own FreeRTOS task and stack, they are
+ * resumed by the tboard coroutine worker instead. The stub must be written with the TASK_CO_* macros.
+ * @param task pointer to task_t struct
+ * @param locals_size number of bytes of TASK_CO_LOCALS() storage allocated for every instance (can be 0)
+ * @retval true task switched to coroutine mode
+ * @retval false task has live instances or could not allocate
+*/
+bool        task_set_coroutine_mode(task_t* task, uint32_t locals_size);
+
+
+/**
+ * @brief Sets the execution timeout of the instances of a task. An instance running longer is cancelled: its stub sees
+ * TASK_CANCELLED() and should return, and a thread instance is deleted if it has not returned TBOARD_CANCEL_GRACE_MS
+ * later. Either way the instance finishes with error REXEC_ERR_TIMEOUT.
+ * @param task pointer to task_t struct
+ * @param timeout_ms timeout in milliseconds, 0 to disable
+*/
+void        task_set_timeout(task_t* task, uint32_t timeout_ms);
+
+/**
+ * @brief Lets REXECs wait when every instance slot of the task is taken, instead of failing at once. A waiting REXEC
+ * starts, in arrival order, as soon as an instance of the task finishes, and is acknowledged then with the time it
+ * waited. It is rejected with REXEC_ERR_BUSY if depth invocations are already waiting, or once it waited timeout_ms.
+ * @param task pointer to task_t struct
+ * @param depth number of REXECs that may wait, 0 to disable waiting
+ * @param timeout_ms longest wait, 0 for no limit
+*/
+void        task_set_wait_queue(task_t* task, uint32_t depth, uint32_t timeout_ms);
+
 /**
  * Constructor. Initializes an instance of the task using a given task_t struct and adds it to the parent_task array of instances.
  * Checks if there is an existing task_instance with the same serial_id.
@@ -104,6 +333,15 @@ void        task_destroy(task_t* task);
 void        task_instance_destroy(task_instance_t* instance);
 
 
+/**
+ * @brief Removes a finished instance from the instances array of its parent task, so that the slot can be given to a
+ * new instance. The instance is no longer found with task_get_instance_index() and is not freed by task_destroy(): the
+ * caller keeps it and destroys it with task_instance_destroy() before the parent task is destroyed.
+ * @param instance pointer to task_instance_t struct
+*/
+void        task_instance_detach(task_instance_t* instance);
+
+
 /**
  * @brief Returns the index of task instance (in task->instances) with the given serial id.
  * @param task pointer to task_t struct
@@ -127,24 +365,71 @@ arg_t*      task_instance_get_args(task_instance_t* instance);
  * @returns pointer to arguments (arg_t)
  */
 arg_t*      task_instance_get_return_args(task_instance_t* instance);
+
+/**
+ * @brief Moves the result out of a finished instance, without copying it. The caller owns the returned array (a
+ * batch_size array for a batch invocation) and its string and nvoid values, e.g. hands it to command_new_taking_arg()
+ * or releases it with command_args_free(). The instance is left without a result.
+ * @param instance pointer to task_instance_t struct
+ * @returns pointer to the result array, NULL if it was already taken
+ */
+arg_t*      task_instance_take_return_arg(task_instance_t* instance);
 /**
  * @brief Set the return argument of the task instance.
+ * @note A string or nvoid value is copied (see task_return_string()), return_arg and its value stay owned by the caller.
+ * A value previously set on the instance is released.
  * @param task_instance pointer to task_instance_t struct
  * @param return_arg pointer to arg_t struct
 */
 void        task_instance_set_return_arg(task_instance_t* instance, arg_t* return_arg);
 
+/**
+ * @brief Copies a string result for the instance, which frees it with its result (see execution_context_t.return_arg).
+ * @param value string returned by the native function, it stays owned by its caller
+ * @returns heap copy of value, NULL if value is NULL
+*/
+char*       task_return_string(const char* value);
+
+/**
+ * @brief Copies an nvoid result for the instance, same as task_return_string().
+ * @param value nvoid returned by the native function, it stays owned by its caller
+ * @returns heap copy of value, NULL if value is NULL
+*/
+nvoid_t*    task_return_nvoid(const nvoid_t* value);
+
 /**
  * @brief Set the arguments of the task instance.
  * @param instance pointer to task_instance_t struct.
  * @param args pointer to array of arguments.
  * @retval true arguments correctly set
- * @retval false error in setting arguments
- * @warning number of arguments need to be less than MAX_ARGS 
+ * @retval false error in setting arguments, or args is NULL while the task takes arguments
+ * @warning the number of arguments is at most MAX_ARGS, the bound checked by task_create()
  * @note The arguments are passed by reference and are not copied.
 */
 bool        task_instance_set_args(task_instance_t* instance, arg_t* args);
 
+/**
+ * @brief Set the arguments of a batch invocation. The instance runs the entry point once per tuple and collects
+ * one result per tuple in its return_arg array.
+ * @param instance pointer to task_instance_t struct.
+ * @param args flattened array of batch_size tuples (args[0].nargs == batch_size * strlen(fn_argsig)).
+ * @param batch_size number of tuples.
+ * @retval true arguments correctly set
+ * @retval false malformed tuples, type mismatch or batch_size larger than MAX_BATCH
+ * @note The argument values are not copied, same as task_instance_set_args().
+*/
+bool        task_instance_set_batch_args(task_instance_t* instance, arg_t* args, uint32_t batch_size);
+
+/**
+ * @brief Checks whether a value of the given type can be passed to the task as its arguments, i.e. the task takes
+ * exactly one argument of that type (used to chain the result of one task into the next one).
+ * @param task pointer to task_t struct
+ * @param type type of the value
+ * @retval true fn_argsig is a single argument of the given type
+ * @retval false otherwise
+*/
+bool        task_accepts_single_arg(task_t* task, argtype_t type);
+
 /**
  * @brief Set the arguments of the task using variable arguments.
  * @param task pointer to task_t struct
@@ -154,6 +439,31 @@ bool        task_instance_set_args(task_instance_t* instance, arg_t* args);
 void        task_set_args_va(task_t* task, int num_args, ...);
 
 
+/**
+ * @brief Accounts an instance that started executing in the statistics of its task. Called by the tboard once the
+ * instance is over.
+ * @param task pointer to task_t struct
+ * @param instance pointer to the finished task_instance_t
+*/
+void        task_record_stats(task_t* task, task_instance_t* instance);
+
+/**
+ * @brief Copies the statistics of a task.
+ * @param task pointer to task_t struct
+ * @param stats filled with the statistics
+ * @note Unlocked snapshot: a run completing during the copy may be partly included.
+*/
+void        task_get_stats(task_t* task, task_stats_t* stats);
+
+/**
+ * @brief Stores the statistics of a task as the TASK_STATS_NUM_VALUES int values answered to a CMD_GET_STATS: runs,
+ * average and maximum wall time, average CPU time, average and maximum queue wait (microseconds), average and maximum
+ * heap bytes. Values that do not fit an int are clamped.
+ * @param task pointer to task_t struct
+ * @param values array of TASK_STATS_NUM_VALUES arg_t, nargs and type are set as well
+*/
+void        task_stats_to_args(task_t* task, arg_t* values);
+
 /**
  * @brief Print out information about task to the terminal.
  * @param task pointer to task_t struct
@@ -0,0 +1,108 @@
+/** @addtogroup task
+ * @{
+ * @brief Generator of typed task stubs. TASK_STUB_n() turns a native C function into a function_stub_t that reads its
+ * arguments straight into the native parameters and stores the native return value, along with the matching argsig and
+ * return type. Example:
+ *
+ *     int add(int a, double b) { return a + (int) b; }
+ *     TASK_STUB_2(add, INT, INT, DOUBLE)   // defines add_stub, add_argsig ("if") and add_return_type (INT_TYPE)
+ *
+ *     task_t* task = TASK_STUB_CREATE("add", add);          // runtime registration
+ *     TASK_REGISTRY(app_tasks, TASK_STUB_DESC("add", add)); // or compile-time registry (see TASK_REGISTRY())
+ *
+ * Type names are INT (int), DOUBLE (double), STRING (char*) and NVOID (nvoid_t*), plus VOID for the return value. The
+ * native prototype is checked against them by the compiler, so a stub can no longer disagree with its argsig; the
+ * argument types of every invocation are checked once against the argsig by task_instance_set_args().
+ * A STRING or NVOID return value is copied for the instance: the native function keeps ownership of what it returns
+ * (a literal, one of its arguments or its own buffer).
+ */
+#ifndef __TASK_STUB_H__
+#define __TASK_STUB_H__
+
+#include "task.h"
+
+/* Per type: C type, argsig character, argtype_t, reading an argument and storing a return value */
+#define _TASK_STUB_CTYPE_INT            int
+#define _TASK_STUB_CTYPE_DOUBLE         double
+#define _TASK_STUB_CTYPE_STRING         char*
+#define _TASK_STUB_CTYPE_NVOID          nvoid_t*
+#define _TASK_STUB_CTYPE_VOID           void
+
+#define _TASK_STUB_SIG_INT              "i"
+#define _TASK_STUB_SIG_DOUBLE           "f"
+#define _TASK_STUB_SIG_STRING           "s"
+#define _TASK_STUB_SIG_NVOID            "n"
+
+#define _TASK_STUB_TYPE_INT             INT_TYPE
+#define _TASK_STUB_TYPE_DOUBLE          DOUBLE_TYPE
+#define _TASK_STUB_TYPE_STRING          STRING_TYPE
+#define _TASK_STUB_TYPE_NVOID           NVOID_TYPE
+#define _TASK_STUB_TYPE_VOID            VOID_TYPE
+
+#define _TASK_STUB_ARG_INT(arg)         ((arg).val.ival)
+#define _TASK_STUB_ARG_DOUBLE(arg)      ((arg).val.dval)
+#define _TASK_STUB_ARG_STRING(arg)      ((arg).val.sval)
+#define _TASK_STUB_ARG_NVOID(arg)       ((arg).val.nval)
+
+#define _TASK_STUB_RET_INT(ret, call)   ((ret)->val.ival = (call))
+#define _TASK_STUB_RET_DOUBLE(ret, call) ((ret)->val.dval = (call))
+#define _TASK_STUB_RET_STRING(ret, call) ((ret)->val.sval = task_return_string(call))
+#define _TASK_STUB_RET_NVOID(ret, call) ((ret)->val.nval = task_return_nvoid(call))
+#define _TASK_STUB_RET_VOID(ret, call)  (call)
+
+/* Declarations shared by every arity: the argsig, the return type, and a check that the native prototype matches the
+   given types */
+#define _TASK_STUB_COMMON(fn, ret, sig, ...) \
+    _Static_assert(__builtin_types_compatible_p(__typeof__(fn), _TASK_STUB_CTYPE_##ret (__VA_ARGS__)), \
+                   "prototype of " #fn " does not match its stub types"); \
+    static const char fn##_argsig[] = "" sig; \
+    enum { fn##_return_type = _TASK_STUB_TYPE_##ret };
+
+#define _TASK_STUB_DEFINE(fn, ret, call) \
+    static void fn##_stub(execution_context_t* ctx) { \
+        arg_t* args __attribute__((unused)) = ctx->query_args; \
+        _TASK_STUB_RET_##ret(ctx->return_arg, call); \
+    }
+
+/** @brief Stub of a function without arguments. */
+#define TASK_STUB_0(fn, ret) \
+    _TASK_STUB_COMMON(fn, ret, "", void) \
+    _TASK_STUB_DEFINE(fn, ret, fn())
+
+/** @brief Stub of a function with one argument. */
+#define TASK_STUB_1(fn, ret, t0) \
+    _TASK_STUB_COMMON(fn, ret, _TASK_STUB_SIG_##t0, _TASK_STUB_CTYPE_##t0) \
+    _TASK_STUB_DEFINE(fn, ret, fn(_TASK_STUB_ARG_##t0(args[0])))
+
+/** @brief Stub of a function with two arguments. */
+#define TASK_STUB_2(fn, ret, t0, t1) \
+    _TASK_STUB_COMMON(fn, ret, _TASK_STUB_SIG_##t0 _TASK_STUB_SIG_##t1, \
+                      _TASK_STUB_CTYPE_##t0, _TASK_STUB_CTYPE_##t1) \
+    _TASK_STUB_DEFINE(fn, ret, fn(_TASK_STUB_ARG_##t0(args[0]), _TASK_STUB_ARG_##t1(args[1])))
+
+/** @brief Stub of a function with three arguments. */
+#define TASK_STUB_3(fn, ret, t0, t1, t2) \
+    _TASK_STUB_COMMON(fn, ret, _TASK_STUB_SIG_##t0 _TASK_STUB_SIG_##t1 _TASK_STUB_SIG_##t2, \
+                      _TASK_STUB_CTYPE_##t0, _TASK_STUB_CTYPE_##t1, _TASK_STUB_CTYPE_##t2) \
+    _TASK_STUB_DEFINE(fn, ret, fn(_TASK_STUB_ARG_##t0(args[0]), _TASK_STUB_ARG_##t1(args[1]), \
+                                  _TASK_STUB_ARG_##t2(args[2])))
+
+/** @brief Stub of a function with four arguments. */
+#define TASK_STUB_4(fn, ret, t0, t1, t2, t3) \
+    _TASK_STUB_COMMON(fn, ret, _TASK_STUB_SIG_##t0 _TASK_STUB_SIG_##t1 _TASK_STUB_SIG_##t2 _TASK_STUB_SIG_##t3, \
+                      _TASK_STUB_CTYPE_##t0, _TASK_STUB_CTYPE_##t1, _TASK_STUB_CTYPE_##t2, _TASK_STUB_CTYPE_##t3) \
+    _TASK_STUB_DEFINE(fn, ret, fn(_TASK_STUB_ARG_##t0(args[0]), _TASK_STUB_ARG_##t1(args[1]), \
+                                  _TASK_STUB_ARG_##t2(args[2]), _TASK_STUB_ARG_##t3(args[3])))
+
+/** @brief Creates the task_t of a function wrapped with TASK_STUB_n() (see task_create()). */
+#define TASK_STUB_CREATE(name, fn) \
+    task_create(name, (argtype_t) fn##_return_type, (char*) fn##_argsig, fn##_stub)
+
+/** @brief Registry descriptor of a function wrapped with TASK_STUB_n() (see TASK_DESC()). */
+#define TASK_STUB_DESC(name, fn) \
+    TASK_DESC(name, (argtype_t) fn##_return_type, fn##_argsig, fn##_stub)
+
+#endif // __TASK_STUB_H__
+/**
+ * @}
+*/
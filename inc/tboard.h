@@ -8,15 +8,65 @@
 
 #include "task.h"
 #include "command.h"
+#include "sched.h"
+#include "completion.h"
 #include "utils.h"
 
 #define TLSTORE_TASK_PTR_IDX 0 ///< Used in _task_freertos_entrypoint_wrapper NOTE: Not sure if this is necessary but lets keep it for now
 #define TASK_STACK_SIZE 2048 ///< Size of stack allocated for each running task
+#define TASK_STACK_MIN_SIZE 1024 ///< Smallest stack adaptive sizing will give an instance
+#define TASK_STACK_MARGIN 512 ///< Safety margin (bytes) added to the observed stack usage in adaptive mode
+#define TBOARD_NVS_NAMESPACE "tboard" ///< NVS namespace holding the learned stack profile
 #define TASK_DEFAULT_CORE 1 ///< Specifies which core tasks are run on. NOTE: For now set to 1.
 #define MUTEX_WAIT 500 ///< Time (ms) to wait for a mutex
+#define TBOARD_MAX_COROUTINES 128 ///< Maximum number of coroutine instances alive at the same time
+#define TBOARD_CO_WORKER_STACK_SIZE 4096 ///< Stack of the coroutine worker, shared by all coroutine instances
+#define TBOARD_MAX_RUNNING 4 ///< Maximum number of thread instances with a deadline executing at the same time, the others wait in the ready queue
+#define TBOARD_MAX_THREADS 32 ///< Maximum number of thread instances executing at the same time, with or without a deadline
+#define TBOARD_SCHED_STACK_SIZE 2048 ///< Stack of the scheduler task dispatching the ready queue
+#define TBOARD_SCHED_PRIORITY 2 ///< Priority of the scheduler task, above the instances so that dispatching is not delayed
+#define TBOARD_CANCEL_GRACE_MS 1000 ///< Time a cancelled thread instance has to reach a TASK_CHECKPOINT() before it is deleted
+#define TBOARD_MAX_PERIODIC 8 ///< Maximum number of periodic tasks
+#define TBOARD_MAX_PIPELINES 4 ///< Maximum number of local pipelines
+#define TBOARD_MAX_PIPELINE_STAGES 8 ///< Maximum number of stages of a pipeline
+#define TBOARD_PIPELINE_SEPARATOR '|' ///< Separates the stage names of a pipeline chain, e.g. "filter|fft|peak"
+#define TBOARD_INTERNAL_SERIAL_BASE 0x80000000u ///< Serial ids of instances created by the tboard itself (e.g. periodic releases, tboard_invoke()) have this bit set, tboard_start_task_opts() rejects them
 
 /* STRUCTS & TYPEDEFS */
 
+/**
+ * @brief A task released periodically by the tboard scheduler, together with its release statistics.
+ * Each release is a detached instance (serial id with TBOARD_INTERNAL_SERIAL_BASE set) whose deadline is the next release.
+ * @note Release jitter is the delay between the nominal release time and the moment the instance started executing.
+*/
+typedef struct _tboard_periodic_t
+{
+    task_t*     task;               ///< Periodic task, NULL if the slot is free
+    arg_t*      args;               ///< Arguments given to every release (not copied)
+    int64_t     period_us;          ///< Release period
+    int64_t     jitter_budget_us;   ///< Release jitter above this is counted in jitter_violations
+    int64_t     next_release_us;    ///< Next nominal release on the jam_time_us() clock
+    task_instance_t* current;       ///< Instance of the last release until it is reaped, NULL otherwise
+    uint32_t    releases;           ///< Number of instances released
+    uint32_t    overruns;           ///< Releases skipped because the previous one had not finished (or no instance was available)
+    uint32_t    completions;        ///< Releases that ran, used for the average jitter
+    uint32_t    jitter_violations;  ///< Releases that started later than the jitter budget allows
+    int64_t     max_jitter_us;      ///< Largest release jitter observed
+    int64_t     total_jitter_us;    ///< Sum of the release jitter of the completions
+} tboard_periodic_t;
+
+/**
+ * @brief A chain of local tasks run as one task. The result of every stage is passed as the argument of the next stage
+ * within the same instance, so only the result of the last stage is reported.
+*/
+typedef struct _tboard_pipeline_t
+{
+    char        name[SMALL_CMD_STR_LEN];                ///< Name of the pipeline task
+    task_t*     task;                                   ///< Task registered for the pipeline (started like any other task), NULL if the slot is free
+    task_t*     stages[TBOARD_MAX_PIPELINE_STAGES];     ///< Stages in execution order
+    uint32_t    num_stages;                             ///< Number of stages
+} tboard_pipeline_t;
+
 /**
  * @brief Structure representing the tboard itself. 
  * @note Can be accessed by various tasks (need to be careful about race conditions).
@@ -26,12 +76,44 @@ typedef struct _tboard_t
     // NOTE: Should determine number of functions at compile time
     task_t*     tasks[MAX_TASKS];                   ///< Array of task_t pointers
     uint32_t    num_tasks;                          ///< Number of tasks that have been registered
-    uint32_t    num_dead_tasks;                     ///< Number of tasks that have been completed (NOTE: not 100% about this definition of 'dead')
-    uint32_t    last_dead_task_id;                  ///< The ID of the last task that was declared dead
+    _Atomic uint32_t num_dead_tasks;                ///< Number of tasks that have been completed (NOTE: not 100% about this definition of 'dead')
+    _Atomic uint32_t last_dead_task_id;             ///< The ID of the last task that was declared dead
+    bool        adaptive_stack;                     ///< If true, instance stacks are sized from the observed high-water marks
+    bool        stack_profile_dirty;                ///< A task has a new stack maximum which has not been saved yet
+    task_instance_t* co_instances[TBOARD_MAX_COROUTINES]; ///< Live coroutine instances resumed by the coroutine worker
+    TaskHandle_t co_worker;                         ///< FreeRTOS task running the coroutines, NULL until the first one starts
+    sched_dispatcher_t dispatcher;                  ///< Queued thread instances (with a deadline: earliest deadline first, at most TBOARD_MAX_RUNNING executing; others in arrival order) and the TBOARD_MAX_THREADS execution slots
+    task_instance_t* running[TBOARD_MAX_THREADS];   ///< Thread instances currently executing, watched for timeouts and cancellation
+    TaskHandle_t scheduler;                         ///< FreeRTOS task dispatching the ready queue and releasing periodic tasks, NULL until first needed
+    tboard_periodic_t periodics[TBOARD_MAX_PERIODIC]; ///< Periodic tasks released by the scheduler
+    uint32_t    internal_serials;                   ///< Counter used to give serial ids to instances created by the tboard
+    tboard_pipeline_t pipelines[TBOARD_MAX_PIPELINES]; ///< Local pipelines
+    completion_ring_t completions;                  ///< Instances that are over, drained by tboard_poll_completion()
+    const task_desc_t* registry;                    ///< Compile-time task registry (in flash), NULL if none
+    uint32_t    registry_size;                      ///< Number of descriptors in the registry
     SemaphoreHandle_t task_management_mutex;        ///< Mutex as lock to prevent race conditions between tasks
     StaticSemaphore_t task_management_mutex_data;   ///< Mutex as lock to prevent race conditions between tasks
 } tboard_t;
 
+/**
+ * @brief Optional parameters of tboard_start_task_opts(). Initialize with tboard_start_options_default().
+*/
+typedef struct _tboard_start_options_t
+{
+    uint32_t    batch_size;     ///< Number of argument tuples (see tboard_start_batch_task()), 0 for a normal invocation
+    int64_t     deadline_us;    ///< Absolute deadline on the jam_time_us() clock, 0 for none
+} tboard_start_options_t;
+
+/**
+ * @brief Handle of an in-process invocation started with tboard_invoke(). It can be polled with tboard_future_ready(),
+ * waited on with tboard_future_wait() and must be released with tboard_future_get().
+*/
+typedef struct _tboard_future_t
+{
+    tboard_t*           tboard;     ///< tboard running the invocation
+    task_instance_t*    instance;   ///< the instance, owned by the future until tboard_future_get()
+} tboard_future_t;
+
 /* FUNCTION PROTOTYPES */
 /**
  * @brief Constructor. Initializes the tboard structure. Should allocate memory to the array of tasks.
@@ -41,6 +123,7 @@ tboard_t*   tboard_create();
 
 /**
  * @brief Destructor. Frees memory allocated during creation of the tboard structure.
+ * Instances still running are cancelled first (see tboard_shutdown()).
  * @param tboard pointer to tboard_t struct
 */
 void        tboard_destroy(tboard_t* tboard);
@@ -59,6 +142,18 @@ void        tboard_delete_last_dead_task(tboard_t* tboard);
 */
 void        tboard_register_task(tboard_t* tboard, task_t* task);
 
+/**
+ * @brief Exports the functions of a compile-time task registry (see TASK_REGISTRY()). The table is used in place and
+ * nothing is allocated here: a function gets its task_t when it is looked up for the first time, so the startup cost
+ * does not depend on the number of exported functions. Tasks registered with tboard_register_task() take precedence.
+ * @param tboard pointer to tboard_t struct
+ * @param table descriptors sorted by name in strcmp() order (the order and the argsigs are verified in DEBUG builds)
+ * @param size number of descriptors, see TASK_REGISTRY_SIZE()
+ * @retval true registry set
+ * @retval false invalid table
+*/
+bool        tboard_set_registry(tboard_t* tboard, const task_desc_t* table, uint32_t size);
+
 /**
  * @brief Starts a task instance corresponding to one of the registered tasks. Returns a pointer to a newly allocated task_instance_t.
  * @note The task needs to have already been registered using tboard_register_task()
@@ -70,11 +165,121 @@ void        tboard_register_task(tboard_t* tboard, task_t* task);
 */
 task_instance_t*    tboard_start_task(tboard_t* tboard, char* name, int task_serial_id, arg_t* args);
 
+/**
+ * @brief Starts a single instance that runs the task once per argument tuple (vectorized invocation).
+ * The results are collected in order in the instance return_arg array (return_arg[0].nargs == batch_size).
+ * @note Not supported for coroutine tasks.
+ * @param tboard pointer to tboard_t struct
+ * @param name string of the name of the task to be run
+ * @param task_serial_id serial id uniquely identifying this instance
+ * @param args flattened argument tuples (args[0].nargs == batch_size * strlen(fn_argsig))
+ * @param batch_size number of argument tuples, at most MAX_BATCH
+ * @returns pointer to allocated task_instance_t, NULL if unable to allocate or argument error.
+*/
+task_instance_t*    tboard_start_batch_task(tboard_t* tboard, char* name, int task_serial_id, arg_t* args, uint32_t batch_size);
+
+/**
+ * @brief Sets the options to their defaults (normal invocation, no deadline).
+ * @param opts pointer to tboard_start_options_t struct
+*/
+void        tboard_start_options_default(tboard_start_options_t* opts);
+
+/**
+ * @brief Starts a task instance with optional parameters. Thread instances with a deadline are queued and dispatched
+ * earliest deadline first while at most TBOARD_MAX_RUNNING of them execute. Instances without a deadline are not
+ * capped: they start at once, unless TBOARD_MAX_THREADS thread instances execute (they then wait in arrival order).
+ * An instance whose deadline has passed when it reaches the front of the queue is dropped without running: it is
+ * marked finished with error REXEC_ERR_DEADLINE_EXPIRED and counted in the deadline_drops of its task.
+ * @param tboard pointer to tboard_t struct
+ * @param name string of the name of the task to be run
+ * @param task_serial_id serial id uniquely identifying this instance, below TBOARD_INTERNAL_SERIAL_BASE
+ * @param args arguments passed to the instance
+ * @param opts options, NULL for the defaults
+ * @returns pointer to allocated task_instance_t, NULL if unable to allocate, argument error, reserved serial id or the
+ * ready queue is full.
+*/
+task_instance_t*    tboard_start_task_opts(tboard_t* tboard, char* name, int task_serial_id, arg_t* args,
+                                           const tboard_start_options_t* opts);
+
+
+/**
+ * @brief Registers a periodic release of a task. The scheduler starts an instance every period_ms, the first one phase_ms
+ * after registration, without any network command. A release is skipped (overrun) while the previous one is still
+ * pending or running, and a release that could not start before the next one is dropped (see tboard_start_task_opts()).
+ * Finished releases are destroyed by the tboard after their release jitter has been recorded.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of a registered task
+ * @param args arguments given to every release, must stay valid until the task is unregistered (not copied)
+ * @param period_ms release period
+ * @param phase_ms offset of the first release
+ * @param jitter_budget_ms releases starting later than this after their nominal release are counted as jitter violations
+ * @retval true task released periodically from now on
+ * @retval false unknown task, argument mismatch, task already periodic or TBOARD_MAX_PERIODIC reached
+*/
+bool        tboard_register_periodic(tboard_t* tboard, char* name, arg_t* args,
+                                     uint32_t period_ms, uint32_t phase_ms, uint32_t jitter_budget_ms);
+
+/**
+ * @brief Stops the periodic releases of a task. An instance still in flight runs to completion.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of the periodic task
+ * @retval true releases stopped
+ * @retval false task is not periodic
+*/
+bool        tboard_unregister_periodic(tboard_t* tboard, char* name);
+
+/**
+ * @brief Returns the periodic release state and statistics of a task.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of the periodic task
+ * @returns pointer to the tboard_periodic_t entry, NULL if the task is not periodic
+*/
+tboard_periodic_t*  tboard_find_periodic(tboard_t* tboard, char* name);
+
+/**
+ * @brief Registers a pipeline: a task named name whose instances run the stages of chain one after the other, passing the
+ * return value of each stage directly as the argument of the next one. The pipeline takes the arguments of the first
+ * stage and returns the result of the last stage. It is started, batched and queried like any other task.
+ * @note Only pipelines registered locally can be started: a REXEC names the pipeline task, not a chain. String and nvoid
+ * intermediate results are freed once the next stage returned, so a stage must not keep its argument.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of the pipeline task (at most SMALL_CMD_STR_LEN - 1 characters)
+ * @param chain names of the stages separated by TBOARD_PIPELINE_SEPARATOR, e.g. "filter|fft|peak"
+ * @returns pointer to the pipeline task, NULL if a stage is unknown, is a coroutine task or a pipeline, or does not
+ * take exactly one argument of the return type of the previous stage
+*/
+task_t*     tboard_register_pipeline(tboard_t* tboard, const char* name, const char* chain);
+
+/**
+ * @brief Enables or disables adaptive stack sizing. When enabled, new instances get the largest stack usage observed
+ * for their task plus TASK_STACK_MARGIN instead of TASK_STACK_SIZE.
+ * @param tboard pointer to tboard_t struct
+ * @param enable true to size stacks from the learned profile
+*/
+void        tboard_set_adaptive_stack(tboard_t* tboard, bool enable);
+
+/**
+ * @brief Returns the stack size (bytes) that the next instance of a task will be created with.
+ * @param tboard pointer to tboard_t struct
+ * @param task pointer to task_t struct
+ * @returns stack size in bytes
+*/
+uint32_t    tboard_get_task_stack_size(tboard_t* tboard, task_t* task);
+
+/**
+ * @brief Saves the learned stack profile (largest observed stack usage of every task) to NVS.
+ * Tasks registered later with tboard_register_task() pick up the saved value.
+ * @param tboard pointer to tboard_t struct
+ * @retval true profile saved (or nothing to save)
+ * @retval false could not write to NVS
+*/
+bool        tboard_save_stack_profile(tboard_t* tboard);
 
 /* GET TASK FUNCTIONS*/
 /**
  * @brief Return the task associated to name in the tboard
- * @note the task has to be registered on the tboard to be found
+ * @note the task has to be registered on the tboard, or be part of its registry (its task_t is then created on the
+ * first lookup), to be found
  * @param tboard pointer to the tboard_t structure
  * @param name char pointer to the name of the task
  * @returns pointer to the task associated with the name in the tboard
@@ -91,7 +296,95 @@ void tboard_print_tasks(tboard_t* tboard);
 
 
 /**
- * @brief Shutdown the tboard
+ * @brief Cancels an instance. A queued instance is dropped, a running one is asked to stop through TASK_CANCELLED() and,
+ * for a thread instance that has not returned TBOARD_CANCEL_GRACE_MS later, deleted to reclaim its stack and slot.
+ * The instance finishes with error REXEC_ERR_CANCELLED.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of the task
+ * @param task_serial_id serial id of the instance
+ * @retval true instance is being cancelled
+ * @retval false no such instance, or it has already finished
+ */
+bool        tboard_cancel_task(tboard_t* tboard, char* name, uint32_t task_serial_id);
+
+/**
+ * @brief Invokes an exported task from C code on this node. The instance is scheduled exactly like a REXEC (ready queue,
+ * coroutine worker, timeouts, accounting) but arguments and result are passed as arg_t without any encoding.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of the task
+ * @param args arguments, not copied: they must stay valid until the invocation is over
+ * @param future set to the handle of the invocation
+ * @retval true invocation started
+ * @retval false unknown task, argument mismatch or no free instance
+ */
+bool        tboard_invoke(tboard_t* tboard, char* name, arg_t* args, tboard_future_t* future);
+
+/**
+ * @brief Checks whether an invocation is over, without blocking.
+ * @param future handle set by tboard_invoke()
+ * @retval true the result (or error) can be taken with tboard_future_get()
+ */
+bool        tboard_future_ready(const tboard_future_t* future);
+
+/**
+ * @brief Blocks the calling task until an invocation is over. The tboard wakes it with a direct-to-task notification
+ * when the instance completes, so the caller must not use ulTaskNotifyTake() for another purpose at the same time.
+ * @param future handle set by tboard_invoke()
+ * @param timeout_ms longest time to wait, 0 to wait without limit
+ * @retval true the invocation is over
+ * @retval false timed out, the invocation goes on (see tboard_future_cancel())
+ */
+bool        tboard_future_wait(tboard_future_t* future, uint32_t timeout_ms);
+
+/**
+ * @brief Cancels an invocation (see tboard_cancel_task()). It is over once it reaches a TASK_CHECKPOINT(), or after
+ * TBOARD_CANCEL_GRACE_MS for a thread instance.
+ * @param future handle set by tboard_invoke()
+ * @retval true the invocation is being cancelled
+ * @retval false it is already over
+ */
+bool        tboard_future_cancel(tboard_future_t* future);
+
+/**
+ * @brief Takes the outcome of an invocation that is over and releases its instance. The future cannot be used anymore.
+ * @param future handle set by tboard_invoke(), tboard_future_ready() must be true
+ * @param result set to the result array (moved out of the instance, free it with command_args_free()), or NULL on error.
+ * Can be NULL to discard the result.
+ * @returns REXEC_ERR_NONE, or why the instance did not run to completion
+ */
+rexec_error_t tboard_future_get(tboard_future_t* future, arg_t** result);
+
+/**
+ * @brief Synchronous tboard_invoke(): waits for the invocation and takes its result. An invocation still running after
+ * timeout_ms is cancelled and waited for, the call then returns REXEC_ERR_TIMEOUT. Must not be called from a task
+ * instance, a coroutine or another tboard task, which would deadlock: the call fails with REXEC_ERR_FAILED there, use
+ * tboard_invoke() and tboard_future_ready() instead.
+ * @param tboard pointer to tboard_t struct
+ * @param name name of the task
+ * @param args arguments, not copied
+ * @param result set to the result array (free it with command_args_free()), NULL on error
+ * @param timeout_ms longest time to wait for the result, 0 to wait without limit
+ * @returns REXEC_ERR_NONE, REXEC_ERR_FAILED if the invocation could not start or was called from a tboard task, or why
+ * it did not run to completion
+ */
+rexec_error_t tboard_invoke_sync(tboard_t* tboard, char* name, arg_t* args, arg_t** result, uint32_t timeout_ms);
+
+/**
+ * @brief Takes the oldest completion event: an instance returned, was dropped, timed out or was cancelled. Completions
+ * are published lock-free, the events must be consumed by a single task (the cnode).
+ * @param tboard pointer to tboard_t struct
+ * @param event filled with the event, event->task is the task_t* of the instance
+ * @retval true an event was taken
+ * @retval false no instance completed since the last call
+ * @note If the ring overflowed (completions.overflows changed), events were lost and the consumer should check the
+ * has_finished flag of the instances it waits for.
+ */
+bool        tboard_poll_completion(tboard_t* tboard, completion_event_t* event);
+
+/**
+ * @brief Shutdown the tboard: stops the periodic releases, drops the queued instances and cancels the running ones
+ * (see tboard_cancel_task()). Returns once no instance is running anymore, or after twice the cancellation grace period.
+ * @note The finished instances are still owned by their tasks, tboard_destroy() frees them.
  * @param tboard pointer to tboard_t struct
  */
 void           tboard_shutdown(tboard_t *tboard);
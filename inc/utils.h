@@ -26,16 +26,29 @@ void dump_bufer_hex(uint8_t* buffer, uint32_t size);
 void dump_bufer_hex_raw(uint8_t* buffer, uint32_t size);
 void dump_heap_left();
 char* concat(const char *s1, const char *s2);
+uint32_t jam_name_hash(const char* name); // 32-bit FNV-1a hash of a name, used as a short persistent key
+/* jam_name_hash() of a string literal of up to 32 characters as a constant expression (longer ones are truncated) */
+#define _JAM_NAME_HASH_STEP(h, s, i) (((h) ^ ((i) < sizeof(s) - 1 ? (uint32_t)(uint8_t)(s)[(i) < sizeof(s) - 1 ? (i) : 0] : 0u)) \
+                                      * ((i) < sizeof(s) - 1 ? 16777619u : 1u))
+#define _JAM_NAME_HASH_4(h, s, i) _JAM_NAME_HASH_STEP(_JAM_NAME_HASH_STEP(_JAM_NAME_HASH_STEP(_JAM_NAME_HASH_STEP( \
+                                      h, s, i), s, (i) + 1), s, (i) + 2), s, (i) + 3)
+#define _JAM_NAME_HASH_16(h, s, i) _JAM_NAME_HASH_4(_JAM_NAME_HASH_4(_JAM_NAME_HASH_4(_JAM_NAME_HASH_4( \
+                                      h, s, i), s, (i) + 4), s, (i) + 8), s, (i) + 12)
+#define JAM_NAME_HASH(s) _JAM_NAME_HASH_16(_JAM_NAME_HASH_16(2166136261u, s, 0), s, 16)
+int64_t jam_time_us(void); // monotonic time since boot in microseconds
+uint32_t jam_task_cpu_ticks(void); // CPU time counter of the calling task (wraps, subtract two readings), 0 if unavailable
+uint32_t jam_cpu_ticks_to_us(uint32_t ticks); // converts a difference of jam_task_cpu_ticks() readings to microseconds
 static const char* ERROR_TAG = "JAM_ERROR";
 #define log_error(x) ESP_LOGE(ERROR_TAG, "Jamscript Runtime Error: %s  " __FILE__ ":%d.\n",x, __LINE__);
 #define MEMORY_DEBUG
 #ifdef MEMORY_DEBUG
 extern int32_t total_mem_usage;
+extern void (*jam_alloc_hook)(uint32_t bytes); // called on every tracked allocation when set (the tboard charges it to the running instance)
 static uint32_t string_len = 1;
 
 static const char* TAG = "MEMORY_DEBUG";
-#define calloc(x,y) calloc(x,y); total_mem_usage+=(y*x); ESP_LOGI(TAG, "calloc: %lu  " __FILE__ ":%d. Total M count: %li\n", (uint32_t) y*x, __LINE__, total_mem_usage)
-#define malloc(x) malloc(x); total_mem_usage+=x; ESP_LOGI(TAG, "malloc: %lu"  __FILE__ ":%d. Total M count: %li\n", (uint32_t) x, __LINE__, total_mem_usage)
+#define calloc(x,y) calloc(x,y); total_mem_usage+=(y*x); if (jam_alloc_hook) jam_alloc_hook((uint32_t) (y*x)); ESP_LOGI(TAG, "calloc: %lu  " __FILE__ ":%d. Total M count: %li\n", (uint32_t) y*x, __LINE__, total_mem_usage)
+#define malloc(x) malloc(x); total_mem_usage+=x; if (jam_alloc_hook) jam_alloc_hook((uint32_t) x); ESP_LOGI(TAG, "malloc: %lu"  __FILE__ ":%d. Total M count: %li\n", (uint32_t) x, __LINE__, total_mem_usage)
 #define free(x) {string_len = (sizeof(*x) == sizeof(char))?strlen(x)+1:1; free(x); total_mem_usage-=sizeof(*x)*string_len; ESP_LOGI(TAG, "Freed a " #x " " __FILE__ ":%d. Total M count: %li\n", __LINE__, total_mem_usage);}
 #endif
 #endif
\ No newline at end of file
@@ -8,17 +8,162 @@
 #define __ZENOH_H__
 
 #include <zenoh-pico.h>
+#include <stdatomic.h>
 #include "utils.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define ZENOH_MAX_SUBS 8 ///< Maximum number of subscriptions declared on one zenoh_t
+#define ZENOH_MAX_PUBS 8 ///< Maximum number of publishers re-declared after a reconnection
+#define ZENOH_SUPERVISOR_PERIOD_MS 500 ///< How often the supervisor checks the session
+#define ZENOH_RECONNECT_MIN_MS 100 ///< First reconnection backoff, doubled after every failed attempt
+#define ZENOH_RECONNECT_MAX_MS 5000 ///< Bound of the reconnection backoff
+#define ZENOH_MAX_TX_FAILURES 3 ///< Consecutive failed publications after which the session is considered lost
+#define ZENOH_POOL_SMALL_SIZE 256 ///< Size of the small pooled buffers (ACKs, errors and other control messages)
+#define ZENOH_POOL_SMALL_COUNT 8 ///< Number of small pooled buffers (at most 32)
+#define ZENOH_POOL_LARGE_SIZE 1024 ///< Size of the large pooled buffers, a whole encoded command (HUGE_CMD_STR_LEN)
+#define ZENOH_POOL_LARGE_COUNT 4 ///< Number of large pooled buffers (at most 32)
+#define ZENOH_MODE_LEN 8 ///< Size of the mode of a zenoh_config_t ("peer" or "client")
+#define ZENOH_LOCATOR_LEN 96 ///< Size of a locator of a zenoh_config_t, e.g. "udp/224.0.0.224:7446#iface=eth0"
+#define ZENOH_NVS_NAMESPACE "zenoh" ///< NVS namespace holding the session configuration
+#define ZENOH_NVS_CONFIG_KEY "config" ///< NVS key of the stored zenoh_config_t
+#define ZENOH_DEFAULT_MODE "peer" ///< Mode used when no configuration is stored
+#define ZENOH_DEFAULT_CONNECT "udp/224.0.0.224:7446#iface=eth0" ///< Locator used when no configuration is stored
+#define ZENOH_NVS_LOCATORS_KEY "locators" ///< NVS key of the cached controller locators, see zenoh_init_discovered()
+#define ZENOH_MAX_LOCATORS 4 ///< Controller locators kept in the cache
+#define ZENOH_SCOUT_TIMEOUT_MS 3000 ///< Duration of one scouting
+#define ZENOH_DISCOVERY_PERIOD_MS 60000 ///< How often the background discovery scouts to refresh the cache
+
+/**
+ * @brief Function pointer typedef. Need to register this type as an argument of zenoh_subscribe().
+*/
+typedef void (*zenoh_callback_t)(z_loaned_sample_t*, void*);
+
+/**
+ * @brief Function pointer typedef. Need to register this type as an argument of zenoh_declare_queryable().
+*/
+typedef void (*zenoh_query_callback_t)(z_loaned_query_t*, void*);
+
+/**
+ * @brief One entry of the subscription table of a zenoh_t, with its own callback and statistics.
+ * @note The statistics are updated by the zenoh read task before the callback is called.
+*/
+typedef struct _zenoh_sub_t
+{
+    z_owned_subscriber_t z_sub; ///< zenoh subscriber object
+    const char* keyexpr; ///< key expression of the subscription
+    zenoh_callback_t callback; ///< called for every received sample
+    void* cb_arg; ///< argument passed to the callback
+    bool declared; ///< entry in use
+    volatile uint32_t samples; ///< samples delivered to the callback
+    volatile uint64_t bytes; ///< payload bytes delivered to the callback
+    volatile int64_t last_us; ///< jam_time_us() of the last sample, 0 if none
+} zenoh_sub_t;
+
+/**
+ * @brief Outbound buffers handed to zenoh without a copy, see zenoh_buf_acquire() and zenoh_publish_pooled().
+ * @note Buffers are taken by the publishing tasks and given back by zenoh once sent, the free masks are atomic.
+*/
+typedef struct _zenoh_buf_pool_t
+{
+    uint8_t small[ZENOH_POOL_SMALL_COUNT][ZENOH_POOL_SMALL_SIZE]; ///< small buffers
+    uint8_t large[ZENOH_POOL_LARGE_COUNT][ZENOH_POOL_LARGE_SIZE]; ///< large buffers
+    _Atomic uint32_t small_free; ///< bit i set: small[i] is free
+    _Atomic uint32_t large_free; ///< bit i set: large[i] is free
+    _Atomic uint32_t misses; ///< acquisitions that found no free buffer large enough
+} zenoh_buf_pool_t;
+
+/**
+ * @brief Transports a session can use, see zenoh_config_set_endpoint().
+*/
+typedef enum _zenoh_transport_t
+{
+    ZENOH_TRANSPORT_UDP_MULTICAST, ///< peers of a multicast group, no router or listener needed
+    ZENOH_TRANSPORT_UDP_UNICAST, ///< UDP to one endpoint (router or peer)
+    ZENOH_TRANSPORT_TCP, ///< TCP to one endpoint (router or peer)
+    ZENOH_TRANSPORT_UNKNOWN ///< not a locator of the transports above
+} zenoh_transport_t;
+
+/**
+ * @brief Parameters of the session, stored in NVS (a file on host builds) so that the transport of a deployment is
+ * chosen without recompiling.
+ * @note Stored as a blob: a new field needs a new ZENOH_NVS_CONFIG_KEY, old blobs are then ignored.
+*/
+typedef struct _zenoh_config_t
+{
+    char mode[ZENOH_MODE_LEN]; ///< "peer" or "client"
+    char connect[ZENOH_LOCATOR_LEN]; ///< locator to connect to, "" to find the controller, see zenoh_init_discovered()
+    char listen[ZENOH_LOCATOR_LEN]; ///< locator to listen on, "" for none
+} zenoh_config_t;
+
+/**
+ * @brief Controller locators found by scouting, cached in NVS (a file on host builds) to connect without scouting at
+ * the next boot.
+*/
+typedef struct _zenoh_locators_t
+{
+    uint32_t count; ///< number of locators
+    char locators[ZENOH_MAX_LOCATORS][ZENOH_LOCATOR_LEN]; ///< locators, the one last connected to first
+} zenoh_locators_t;
 
 /**
  * @brief Struct representing a zenoh object. 
 */
 typedef struct _zenoh_t
 {
-    z_owned_subscriber_t z_sub; ///< zenoh subscriber instance. used when receiving messages.
+    zenoh_config_t config; ///< parameters the session is opened (and reopened) with
+    zenoh_sub_t subs[ZENOH_MAX_SUBS]; ///< subscription table, see zenoh_subscribe()
+    struct _zenoh_pub_t* pubs[ZENOH_MAX_PUBS]; ///< declared publishers, re-declared after a reconnection
+    z_owned_queryable_t z_queryable; ///< queryable declared with zenoh_declare_queryable()
+    bool queryable_declared; ///< z_queryable is in use
+    const char* queryable_key; ///< key expression of the queryable
+    zenoh_query_callback_t queryable_callback; ///< callback of the queryable
+    void* queryable_arg; ///< argument passed to the queryable callback
+    bool batching; ///< a batch is open, see zenoh_batch_start()
+    zenoh_buf_pool_t pool; ///< outbound buffer pool
     z_owned_session_t z_session; ///< zenoh session instance. 
+    bool session_open; ///< z_session is open (it is closed between a loss and the reconnection)
+    uint32_t session_seq; ///< incremented every time a session is opened, tells the current one from a lost one
+    volatile bool connected; ///< false while the session is lost and being reopened, see zenoh_is_connected()
+    SemaphoreHandle_t lock; ///< held while the session is used, so the supervisor never reopens it under a publisher
+    bool read_task_started; ///< zenoh_start_read_task() was called, restarted after a reconnection
+    bool lease_task_started; ///< zenoh_start_lease_task() was called, restarted after a reconnection
+    volatile uint32_t tx_failures; ///< consecutive failed publications
+    TaskHandle_t supervisor; ///< supervisor task, NULL if not started
+    volatile bool supervisor_stop; ///< asks the supervisor task to exit
+    uint32_t reconnects; ///< sessions reopened after a loss
+    uint32_t last_reconnect_ms; ///< time from the detection of the last loss to the reopened session
+    uint32_t max_reconnect_ms; ///< longest reconnection
+    bool discovery; ///< the connect locator comes from discovery, see zenoh_init_discovered()
+    zenoh_locators_t locators; ///< known controller locators, tried in turn by the supervisor when discovery is on
+    bool from_cache; ///< the session was opened with a cached locator, without scouting
+    uint32_t discovery_ms; ///< time zenoh_init_discovered() took to open the session
+    TaskHandle_t discovery_task; ///< background discovery task, NULL if not started
+    volatile bool discovery_stop; ///< asks the discovery task to exit
 } zenoh_t;
 
+/**
+ * @brief Message classes with a predefined QoS, see zenoh_qos_init().
+*/
+typedef enum _zenoh_qos_class_t
+{
+    ZENOH_QOS_DEFAULT, ///< zenoh-pico defaults
+    ZENOH_QOS_CONTROL, ///< small control messages (ACKs, errors): express, interactive high priority, never dropped
+    ZENOH_QOS_DATA, ///< results and requests: data high priority, never dropped
+    ZENOH_QOS_TELEMETRY ///< periodic values that the next sample replaces: low priority, dropped under congestion
+} zenoh_qos_class_t;
+
+/**
+ * @brief Quality of service of a publisher, applied to every message it publishes.
+*/
+typedef struct _zenoh_qos_t
+{
+    z_priority_t priority; ///< transport priority, messages of higher priority do not queue behind lower ones
+    z_congestion_control_t congestion_control; ///< Z_CONGESTION_CONTROL_DROP drops messages when the transport is congested, Z_CONGESTION_CONTROL_BLOCK waits
+    bool is_express; ///< send at once instead of waiting to be batched with other messages
+} zenoh_qos_t;
+
 /**
  * @brief Struct representing a zenoh publisher.
 */
@@ -26,22 +171,82 @@ typedef struct _zenoh_pub_t
 {
     z_owned_publisher_t z_pub; ///< zenoh publisher object
     char* keyexpr; ///< keyexpression (or topic) of the publisher
+    zenoh_qos_t qos; ///< QoS the publisher was declared with
 } zenoh_pub_t;
 
+/* FUNCTION PROTOTYPES */
 
 /**
- * @brief Function pointer typedef. Need to register this type as an argument of zenoh_declare_sub().
+ * @brief Constructor. Initializes zenoh objects and starts a Zenoh session with the stored configuration, see
+ * zenoh_config_load().
+ * @return pointer to unitialized zenoh_t struct
 */
-typedef void (*zenoh_callback_t)(z_loaned_sample_t*, void*);
-
-/* FUNCTION PROTOTYPES */
+zenoh_t* zenoh_init();
 
 /**
- * @brief Constructor. Initializes zenoh objects and starts a Zenoh session.
+ * @brief Constructor. Same as zenoh_init(), with the given session parameters.
+ * @param config session parameters, copied
  * @return pointer to unitialized zenoh_t struct
- * @todo What configuration do we want for the zenoh session? Peer to peer, client?
+ * @retval NULL the configuration is invalid or the session could not be opened
 */
-zenoh_t* zenoh_init();
+zenoh_t* zenoh_init_with_config(const zenoh_config_t* config);
+
+/**
+ * @brief Fills a configuration with the built-in parameters (ZENOH_DEFAULT_MODE, ZENOH_DEFAULT_CONNECT).
+ * @param config configuration to fill
+*/
+void zenoh_config_default(zenoh_config_t* config);
+
+/**
+ * @brief Reads the configuration stored with zenoh_config_save(). The built-in parameters are used when none is stored.
+ * @param config configuration to fill
+ * @retval true a stored configuration was read
+ * @retval false none is stored (or it is invalid), config holds the built-in parameters
+*/
+bool zenoh_config_load(zenoh_config_t* config);
+
+/**
+ * @brief Stores a configuration, used by zenoh_init() from the next boot.
+ * @param config configuration to store
+ * @retval true configuration stored
+ * @retval false the configuration is invalid or the storage failed
+*/
+bool zenoh_config_save(const zenoh_config_t* config);
+
+/**
+ * @brief Removes the stored configuration, zenoh_init() uses the built-in parameters from the next boot.
+ * @retval true no configuration is stored anymore
+ * @retval false the storage failed
+*/
+bool zenoh_config_erase(void);
+
+/**
+ * @brief Sets the connect locator from a transport and an endpoint, e.g. ZENOH_TRANSPORT_TCP, "192.168.1.10", 7447
+ * gives "tcp/192.168.1.10:7447".
+ * @param config configuration to change
+ * @param transport transport of the locator
+ * @param host IP address (a multicast group for ZENOH_TRANSPORT_UDP_MULTICAST)
+ * @param port port
+ * @param iface network interface appended as "#iface=", needed for multicast, NULL for none
+ * @retval true locator set
+ * @retval false unknown transport, or the locator does not fit
+*/
+bool zenoh_config_set_endpoint(zenoh_config_t* config, zenoh_transport_t transport, const char* host, int port,
+                               const char* iface);
+
+/**
+ * @brief Returns the transport of a locator. A udp locator is multicast when its address is an IPv4 (224.0.0.0/4) or
+ * IPv6 (ff00::/8, in brackets) multicast group.
+ * @param locator e.g. config->connect
+*/
+zenoh_transport_t zenoh_locator_transport(const char* locator);
+
+/**
+ * @brief Parses a transport name: "udp-multicast", "udp" or "tcp".
+ * @param name transport name
+ * @retval ZENOH_TRANSPORT_UNKNOWN the name is not known
+*/
+zenoh_transport_t zenoh_transport_from_str(const char* name);
 
 /**
  * @brief Frees memory associated with the zenoh_t struct.
@@ -50,17 +255,97 @@ zenoh_t* zenoh_init();
 void zenoh_destroy(zenoh_t* zenoh);
 
 /**
- * @brief Scouts for JNodes. Note that JNodes must be using Zenoh.
- * @retval true If a JNode is found
- * @retval false If a JNode is not found
- * @warning Do not use this function.
- * @todo Checking for JNode is not implemented. Function currently always returns true
- * @todo FIX this function, DO NOT USE CURRENTLY
+ * @brief Scouts for zenoh routers for ZENOH_SCOUT_TIMEOUT_MS.
+ * @deprecated Same as zenoh_discover() without the locators.
+ * @retval true If a router is found
+ * @retval false If none is found
 */
 bool zenoh_scout();
 
+/**
+ * @brief Scouts for controllers (zenoh routers, peers are other nodes) and collects their unicast locators. Blocks for
+ * timeout_ms.
+ * @param found locators found, up to ZENOH_MAX_LOCATORS
+ * @param timeout_ms duration of the scouting
+ * @retval true If a locator was found
+ * @retval false If none was found or scouting failed
+*/
+bool zenoh_discover(zenoh_locators_t* found, uint32_t timeout_ms);
+
+/**
+ * @brief Reads the controller locators cached with zenoh_locators_save().
+ * @param locators locators read, count is 0 when none are cached
+ * @retval true If cached locators were read
+ * @retval false If none are cached (or the cache is invalid)
+*/
+bool zenoh_locators_load(zenoh_locators_t* locators);
+
+/**
+ * @brief Caches controller locators in NVS.
+ * @param locators locators to cache
+ * @retval true If the locators were stored
+ * @retval false If the storage failed
+*/
+bool zenoh_locators_save(const zenoh_locators_t* locators);
+
+/**
+ * @brief Constructor. Opens a session with a controller locator found without configuring it: the cached locators
+ * are tried first, one connection attempt each, and scouting (ZENOH_SCOUT_TIMEOUT_MS) only happens when none of them
+ * answers. The locators found by scouting are cached for the next boot. The supervisor then tries the other known
+ * locators when the session is lost. The session is opened in client mode, the controller being a router.
+ * @param config session parameters, the mode, listen and connect locators are ignored
+ * @return pointer to zenoh_t struct, with discovery on
+ * @retval NULL no controller answered
+*/
+zenoh_t* zenoh_init_discovered(const zenoh_config_t* config);
+
+/**
+ * @brief Starts the background discovery task: every ZENOH_DISCOVERY_PERIOD_MS it scouts and caches the controller
+ * locators found, so the cache is current at the next boot. Does nothing when discovery is off.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If the task is running, or discovery is off
+ * @retval false If the task could not be created
+*/
+bool zenoh_start_discovery(zenoh_t* zenoh);
+
+/**
+ * @brief Stops the background discovery task, waiting for it to exit (at most one scouting).
+ * @param zenoh pointer to zenoh_t struct
+*/
+void zenoh_stop_discovery(zenoh_t* zenoh);
+
+/**
+ * @brief Declares a subscription in the subscription table. Each subscription has its own callback and statistics, so
+ * different traffic classes can be handled separately.
+ * @param zenoh pointer to zenoh_t struct
+ * @param key_expression key expression to subscribe to, must stay valid until the subscription is undeclared
+ * @param callback called from the zenoh read task for every sample
+ * @param cb_arg argument passed to the callback
+ * @returns id of the subscription (index in zenoh->subs)
+ * @retval -1 the table is full or the declaration failed
+*/
+int zenoh_subscribe(zenoh_t* zenoh, const char* key_expression, zenoh_callback_t callback, void* cb_arg);
+
+/**
+ * @brief Undeclares a subscription and frees its entry of the table.
+ * @param zenoh pointer to zenoh_t struct
+ * @param sub_id id returned by zenoh_subscribe()
+ * @retval true subscription undeclared
+ * @retval false no such subscription, or zenoh refused to undeclare it
+*/
+bool zenoh_unsubscribe(zenoh_t* zenoh, int sub_id);
+
+/**
+ * @brief Returns a declared subscription, e.g. to read its statistics.
+ * @param zenoh pointer to zenoh_t struct
+ * @param sub_id id returned by zenoh_subscribe()
+ * @returns pointer to the entry, NULL if there is no such subscription
+*/
+const zenoh_sub_t* zenoh_get_sub(const zenoh_t* zenoh, int sub_id);
+
 /**
  * @brief Declare a zenoh subscriber on a specific topic. Assign callback function.
+ * @deprecated Kept for existing callers, same as zenoh_subscribe() without the subscription id.
  * @param zenoh pointer to zenoh_t struct
  * @param key_expression string describing the 'subscription topic'
  * @param callback pointer to zenoh callback function 
@@ -80,6 +365,125 @@ bool zenoh_declare_sub(zenoh_t* zenoh, const char* key_expression, zenoh_callbac
 */
 bool zenoh_declare_pub(zenoh_t* zenoh, const char* key_expression, zenoh_pub_t* zenoh_pub);
 
+/**
+ * @brief Fills a QoS with the settings of a message class.
+ * @param qos pointer to the zenoh_qos_t to fill
+ * @param qos_class message class
+*/
+void zenoh_qos_init(zenoh_qos_t* qos, zenoh_qos_class_t qos_class);
+
+/**
+ * @brief Same as zenoh_declare_pub(), with the QoS of the publisher. Several publishers with different QoS can be
+ * declared on the same key expression.
+ * @param zenoh pointer to zenoh_t struct
+ * @param key_expression string describing the 'subscription topic'
+ * @param zenoh_pub pointer to zenoh_pub_t struct, which will contain the resulting z_owned_pub struct
+ * @param qos QoS of the publisher, NULL for the zenoh-pico defaults
+ * @retval true If publish declaration returned without error
+ * @retval false If an error occured 
+*/
+bool zenoh_declare_pub_qos(zenoh_t* zenoh, const char* key_expression, zenoh_pub_t* zenoh_pub, const zenoh_qos_t* qos);
+
+/**
+ * @brief Undeclares a publisher.
+ * @param zenoh pointer to zenoh_t struct
+ * @param zenoh_pub pointer to zenoh_pub_t struct declared with zenoh_declare_pub() or zenoh_declare_pub_qos()
+ * @retval true If the publisher was undeclared
+ * @retval false If an error occured 
+*/
+bool zenoh_undeclare_pub(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub);
+
+/**
+ * @brief Declares the queryable of the session. Queries (z_get) matching the key expression are passed to the callback,
+ * which may keep them with z_query_clone() to reply later: the requester gets its reply(s) when the last copy of the
+ * query is dropped.
+ * @param zenoh pointer to zenoh_t struct
+ * @param key_expression key expression answered by the queryable
+ * @param callback called from the zenoh read task for every query
+ * @param cb_arg argument passed to the callback
+ * @retval true If the queryable was declared
+ * @retval false If a queryable is already declared or an error occured
+*/
+bool zenoh_declare_queryable(zenoh_t* zenoh, const char* key_expression, zenoh_query_callback_t callback, void* cb_arg);
+
+/**
+ * @brief Undeclares the queryable of the session.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If the queryable was undeclared
+ * @retval false If there is no queryable or an error occured
+*/
+bool zenoh_undeclare_queryable(zenoh_t* zenoh);
+
+/**
+ * @brief Replies to a query with a CBOR encoded message. The reply is routed to the requester only.
+ * @param query query to reply to
+ * @param key_expression concrete key expression the reply is sent on, the one of the queryable (the query may use a
+ * wildcard, which a reply cannot carry)
+ * @param buffer buffer containing encoded message
+ * @param buffer_len length of buffer
+ * @retval true If the reply was sent
+ * @retval false If an error occured
+*/
+bool zenoh_reply_encoded(const z_loaned_query_t* query, const char* key_expression, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Whether the session is usable. It is not between the detection of a loss and the reconnection: publications
+ * then fail at once, so callers can buffer their messages.
+ * @param zenoh pointer to zenoh_t struct
+*/
+bool zenoh_is_connected(const zenoh_t* zenoh);
+
+/**
+ * @brief Reopens the session and re-declares the subscriptions, publishers and queryable, then restarts the read and
+ * lease tasks that were started. One attempt, the supervisor calls it with a bounded backoff.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If the session is back
+ * @retval false If an error occured, the session stays closed
+*/
+bool zenoh_reconnect(zenoh_t* zenoh);
+
+/**
+ * @brief Starts the session supervisor task. Every ZENOH_SUPERVISOR_PERIOD_MS it checks the session (closed, failed
+ * keep-alive or ZENOH_MAX_TX_FAILURES failed publications in a row). On a loss it calls zenoh_reconnect() with a backoff
+ * from ZENOH_RECONNECT_MIN_MS to ZENOH_RECONNECT_MAX_MS, and reports how long the reconnection took.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If the supervisor is running
+ * @retval false If the task could not be created
+*/
+bool zenoh_start_supervisor(zenoh_t* zenoh);
+
+/**
+ * @brief Stops the supervisor task, waiting for it to exit.
+ * @param zenoh pointer to zenoh_t struct
+*/
+void zenoh_stop_supervisor(zenoh_t* zenoh);
+
+/**
+ * @brief Opens a batch: the following messages of the session are grouped in as few transport frames as possible
+ * until zenoh_batch_flush() or zenoh_batch_stop(). zenoh-pico also sends the batch by itself once it is full.
+ * @note Needs zenoh-pico built with Z_FEATURE_BATCHING, otherwise no batch is opened and messages go out one by one.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If a batch is open
+ * @retval false If batching is not available or an error occured
+*/
+bool zenoh_batch_start(zenoh_t* zenoh);
+
+/**
+ * @brief Sends the messages of the open batch now. The batch stays open.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If the batch was sent, or no batch is open
+ * @retval false If an error occured
+*/
+bool zenoh_batch_flush(zenoh_t* zenoh);
+
+/**
+ * @brief Sends the messages of the open batch and closes it: messages go out one by one again.
+ * @param zenoh pointer to zenoh_t struct
+ * @retval true If the batch was closed, or no batch is open
+ * @retval false If an error occured
+*/
+bool zenoh_batch_stop(zenoh_t* zenoh);
+
 /**
  * @brief Start the zenoh read task by calling zp_start_read_task()
  * @param zenoh pointer to zenoh_t struct
@@ -103,7 +507,8 @@ void zenoh_start_lease_task(zenoh_t* zenoh); // do we really need this
 bool zenoh_publish(zenoh_t* zenoh, const char* message, zenoh_pub_t* zenoh_pub);
 
 /**
- * @brief Publish a CBOR encoded message over zenoh using a given publisher.
+ * @brief Publish a CBOR encoded message over zenoh using a given publisher. The message is copied into a pooled buffer
+ * when one is free (no allocation), otherwise into a new zenoh payload.
  * @param zenoh pointer to zenoh_t struct
  * @param zenoh_pub pointer to zenoh_pub_t struct specifying which publisher to send over.
  * @param buffer buffer containing encoded message
@@ -112,6 +517,71 @@ bool zenoh_publish(zenoh_t* zenoh, const char* message, zenoh_pub_t* zenoh_pub);
  * @retval false If an error occured 
 */
 bool zenoh_publish_encoded(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Same as zenoh_publish_encoded(), with a zenoh attachment sent next to the message. Receivers read it with
+ * zenoh_sample_attachment() without decoding the message.
+ * @param zenoh pointer to zenoh_t struct
+ * @param zenoh_pub pointer to zenoh_pub_t struct specifying which publisher to send over.
+ * @param buffer buffer containing encoded message
+ * @param buffer_len length of buffer
+ * @param attachment attachment bytes (e.g. an encoded command_attachment_t), NULL for none
+ * @param attachment_len length of attachment
+ * @retval true If publish successful
+ * @retval false If an error occured 
+*/
+bool zenoh_publish_encoded_attached(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, const uint8_t* buffer, size_t buffer_len,
+                                    const uint8_t* attachment, size_t attachment_len);
+
+/**
+ * @brief Copies the attachment of a received sample, without allocating.
+ * @param sample received sample
+ * @param buffer destination buffer
+ * @param buffer_len size of buffer
+ * @returns length of the attachment
+ * @retval 0 the sample has no attachment or it does not fit in buffer
+*/
+size_t zenoh_sample_attachment(const z_loaned_sample_t* sample, uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Takes a buffer of the pool, from the smallest class that fits. It goes back to the pool with
+ * zenoh_publish_pooled() or zenoh_buf_release().
+ * @param zenoh pointer to zenoh_t struct
+ * @param size number of bytes needed
+ * @returns pointer to the buffer
+ * @retval NULL no free buffer is large enough
+*/
+uint8_t* zenoh_buf_acquire(zenoh_t* zenoh, size_t size);
+
+/**
+ * @brief Gives a buffer back to the pool without publishing it.
+ * @param zenoh pointer to zenoh_t struct
+ * @param buffer buffer returned by zenoh_buf_acquire()
+*/
+void zenoh_buf_release(zenoh_t* zenoh, uint8_t* buffer);
+
+/**
+ * @brief Publishes a CBOR encoded message held in a pooled buffer, without copying it. zenoh takes the buffer and
+ * gives it back to the pool once sent, also when the publication fails.
+ * @param zenoh pointer to zenoh_t struct
+ * @param zenoh_pub pointer to zenoh_pub_t struct specifying which publisher to send over.
+ * @param buffer buffer returned by zenoh_buf_acquire(), must not be used by the caller afterwards
+ * @param buffer_len length of the message
+ * @retval true If publish successful
+ * @retval false If an error occured 
+*/
+bool zenoh_publish_pooled(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Publishes a CBOR encoded message without copying it. The buffer is referenced, not owned.
+ * @param zenoh pointer to zenoh_t struct
+ * @param zenoh_pub pointer to zenoh_pub_t struct specifying which publisher to send over.
+ * @param buffer buffer containing encoded message, must stay valid and unchanged for the program lifetime
+ * @param buffer_len length of buffer
+ * @retval true If publish successful
+ * @retval false If an error occured 
+*/
+bool zenoh_publish_static(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, const uint8_t* buffer, size_t buffer_len);
 #endif
 /**
  * @}
@@ -3,83 +3,381 @@
 #include "tboard.h"
 #include "task.h"
 #include "utils.h"
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include <sys/time.h>
 
 #define PRINT_INIT_PROGRESS // undefine to remove the initiation messages when creating a cnode
 #define CNODE_REPLY_PUB_KEYEXPR "app/replies/up"
 #define CNODE_REQUEST_PUB_KEYEXPR "app/requests/up"
-#define CNODE_SUB_KEYEXPR "app/**"
+#define CNODE_REQUEST_SUB_KEYEXPR "app/requests/down/**"
+#define CNODE_REPLY_SUB_KEYEXPR "app/replies/down/**"
+#define CNODE_RESULT_QUERYABLE_KEYEXPR "app/results" // followed by the node id
 #define QUEUE_LENGTH 50 // size of task processing queue
+#define STACK_PROFILE_SAVE_PERIOD_MS 10000 // how often a changed tboard stack profile is written to NVS
 #define ITEM_SIZE sizeof(command_t *)
 
 // function prototypes
 bool cnode_send_ack(cnode_t* cn, command_t* cmd);
+bool cnode_send_ack_waited(cnode_t* cn, command_t* cmd, uint32_t waited_ms);
 bool cnode_send_response(cnode_t* cn, command_t* cmd, arg_t* retarg);
 bool cnode_send_error(cnode_t* cn, command_t* cmd);
+bool cnode_send_error_code(cnode_t* cn, command_t* cmd, rexec_error_t error);
+static bool _cnode_send_response_taking(cnode_t* cn, command_t* cmd, arg_t* retarg);
+static void _cnode_close_batch(cnode_t* cn);
+static void _cnode_flush_outbox(cnode_t* cn);
 
 /* PRIVATE FUNCTIONS */
-arg_t* _cnode_return_task(cnode_t* cn, command_t* cmd) {
-    if (!cn || !cmd){
-        printf("one of _cnode_return_task parameter is null");
-        return NULL;
+/* Drops the query a command was received with: the requester then gets the end of the replies, if its session is
+   still there */
+static void _cnode_drop_query(command_t* cmd) {
+    if (cmd->reply_query != NULL) {
+        z_owned_query_t* query = (z_owned_query_t*) cmd->reply_query;
+        z_drop(z_move(*query));
+        free(query);
+        cmd->reply_query = NULL;
     }
+}
+
+/* Frees a command, dropping the query it was received with */
+static void _cnode_command_free(command_t* cmd) {
+    _cnode_drop_query(cmd);
+    command_free(cmd);
+}
 
+/* Whether a command came with a query that can no longer be answered: its session was lost, even if a new one is open
+   by now (the requester is gone with it) */
+static bool _cnode_query_lost(cnode_t* cn, command_t* cmd) {
+    return cmd->reply_query != NULL &&
+           (!zenoh_is_connected(cn->zenoh) || cmd->reply_session != cn->zenoh->session_seq);
+}
+
+/* Frees the parked result queries received on a lost session, nobody is waiting for their reply */
+static void _cnode_drop_lost_queries(cnode_t* cn) {
+    for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+        command_t* cmd = cn->pending_results[i];
+        if (cmd == NULL || !_cnode_query_lost(cn, cmd)) continue;
+        cn->pending_results[i] = NULL;
+        _cnode_command_free(cmd);
+    }
+}
+
+/* Looks up the instance a command refers to, in the slots of its task or among the finished instances moved out of
+   them, NULL if there is none */
+static task_instance_t* _cnode_find_instance(cnode_t* cn, command_t* cmd) {
     task_t *task = tboard_find_task_name(cn->tboard, cmd->fn_name);
     if (!task) return NULL;
     int task_instance_idx = task_get_instance_index(task, cmd->task_id);
-    if (task_instance_idx == -1) return NULL;
-
-    task_instance_t *task_instance = task->instances[task_instance_idx];
+    if (task_instance_idx != -1) return task->instances[task_instance_idx];
+    for (int i = 0; i < CNODE_MAX_FINISHED; i++) {
+        task_instance_t* instance = cn->finished[i];
+        if (instance != NULL && instance->parent_task == task && instance->serial_id == cmd->task_id) return instance;
+    }
+    return NULL;
+}
 
-    // this is blocking........ open a thread for this? can potentially use one of the esp32 cores
-    while (!task_instance->has_finished) {
-        sleep(1);
+/* Frees the instance slots of a task held by finished instances whose result was not fetched yet: they move to
+   cn->finished (as long as it has room), so a waiting REXEC starts as soon as an instance completes */
+static void _cnode_release_finished(cnode_t* cn, task_t* task) {
+    int free_slot = 0;
+    for (uint32_t i = 0; i < task->max_instances; i++) {
+        task_instance_t* instance = task->instances[i];
+        if (instance == NULL || !instance->has_finished) continue;
+        while (free_slot < CNODE_MAX_FINISHED && cn->finished[free_slot] != NULL) free_slot++;
+        if (free_slot == CNODE_MAX_FINISHED) return;
+        task_instance_detach(instance);
+        cn->finished[free_slot] = instance;
     }
-    // get return value
-    arg_t *retarg = task_instance_get_return_args(task_instance);
+}
 
+/* Answers a GET_REXEC_RES whose instance is over, then frees the instance and the command */
+static void _cnode_reply_result(cnode_t* cn, command_t* cmd, task_instance_t* task_instance) {
+    if (task_instance == NULL) {
+        printf("Failed to get task return value\n");
+        cnode_send_error_code(cn, cmd, REXEC_ERR_FAILED);
+        _cnode_command_free(cmd);
+        return;
+    }
+    /* Dropped, timed out or cancelled: there is no return value */
+    if (task_instance->error != REXEC_ERR_NONE) {
+        cnode_send_error_code(cn, cmd, task_instance->error);
+    } else {
+        /* The result is moved into the response and released with it, it is never copied */
+        arg_t *retarg = task_instance_take_return_arg(task_instance);
+        if (retarg == NULL) {
+            printf("Failed to get task return value\n");
+            cnode_send_error_code(cn, cmd, REXEC_ERR_FAILED);
+        } else if (!_cnode_send_response_taking(cn, cmd, retarg)) {
+            printf("Could not send response \r\n");
+        }
+    }
+    for (int i = 0; i < CNODE_MAX_FINISHED; i++) {
+        if (cn->finished[i] == task_instance) cn->finished[i] = NULL;
+    }
     task_instance_destroy(task_instance);
-    return retarg;
+    _cnode_command_free(cmd);
+}
+
+/* Whether the REXEC a command refers to is waiting for an instance slot */
+static bool _cnode_is_waiting(cnode_t* cn, command_t* cmd) {
+    for (uint32_t i = 0; i < cn->num_waiting; i++) {
+        command_t* waiting = cn->waiting[i].cmd;
+        if (waiting->task_id == cmd->task_id && strcmp(waiting->fn_name, cmd->fn_name) == 0) return true;
+    }
+    return false;
+}
+
+/* Answers a GET_REXEC_RES right away if its instance is over, otherwise parks it until the tboard reports the
+   completion: the processing task never blocks on a running instance */
+static void _cnode_get_result(cnode_t* cn, command_t* cmd) {
+    task_instance_t* task_instance = _cnode_find_instance(cn, cmd);
+    if ((task_instance == NULL && !_cnode_is_waiting(cn, cmd)) || (task_instance != NULL && task_instance->has_finished)) {
+        _cnode_reply_result(cn, cmd, task_instance);
+        return;
+    }
+    for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+        if (cn->pending_results[i] == NULL) {
+            cn->pending_results[i] = cmd;
+            cn->pending_since_us[i] = jam_time_us();
+            return;
+        }
+    }
+    printf("Too many pending result queries \r\n");
+    cnode_send_error_code(cn, cmd, REXEC_ERR_FAILED);
+    _cnode_command_free(cmd);
 }
 
+/* Answers the parked GET_REXEC_RES queries whose instance completed since the last call */
+static void _cnode_dispatch_completions(cnode_t* cn) {
+    completion_event_t event;
+    while (tboard_poll_completion(cn->tboard, &event)) {
+        task_t* task = (task_t*) event.task;
+        for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+            command_t* cmd = cn->pending_results[i];
+            if (cmd == NULL || cmd->task_id != event.serial_id || strcmp(cmd->fn_name, task->name) != 0) continue;
+            cn->pending_results[i] = NULL;
+            _cnode_reply_result(cn, cmd, _cnode_find_instance(cn, cmd));
+            break;
+        }
+    }
 
-static bool _is_own_message(z_view_string_t* keystr, const cnode_t* cnode) {
-    const char* pub_ke_reply = CNODE_REPLY_PUB_KEYEXPR;
-    const char* pub_ke_request = CNODE_REQUEST_PUB_KEYEXPR;
-    const char* key_data = z_string_data(z_view_string_loan(keystr));
+    /* Completions were lost because the ring was full, fall back to the flags of the parked queries */
+    uint32_t overflows = atomic_load(&cn->tboard->completions.overflows);
+    if (overflows == cn->completion_overflows) return;
+    cn->completion_overflows = overflows;
+    for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+        command_t* cmd = cn->pending_results[i];
+        if (cmd == NULL) continue;
+        task_instance_t* task_instance = _cnode_find_instance(cn, cmd);
+        if (task_instance != NULL ? !task_instance->has_finished : _cnode_is_waiting(cn, cmd)) continue;
+        cn->pending_results[i] = NULL;
+        _cnode_reply_result(cn, cmd, task_instance);
+    }
+}
 
-    // ignore "app/replies/up" messages
-    if (strncmp(key_data, pub_ke_reply, strlen(pub_ke_reply)) == 0) {
-        return true;
+/* Answers the parked GET_REXEC_RES queries that waited longer than CNODE_RESULT_WAIT_MS with REXEC_ERR_TIMEOUT, so a
+   lost completion or an instance that never ends does not hold the query forever */
+static void _cnode_expire_pending_results(cnode_t* cn) {
+    int64_t now = jam_time_us();
+    for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+        command_t* cmd = cn->pending_results[i];
+        if (cmd == NULL || now - cn->pending_since_us[i] < (int64_t) CNODE_RESULT_WAIT_MS * 1000) continue;
+        cn->pending_results[i] = NULL;
+        task_instance_t* task_instance = _cnode_find_instance(cn, cmd);
+        if (task_instance != NULL && task_instance->has_finished) {
+            _cnode_reply_result(cn, cmd, task_instance);
+            continue;
+        }
+        cnode_send_error_code(cn, cmd, REXEC_ERR_TIMEOUT);
+        _cnode_command_free(cmd);
     }
+}
 
-    // ignore "app/requests/up" messages
-    if (strncmp(key_data, pub_ke_request, strlen(pub_ke_request)) == 0) {
-        return true;
+/* Answers a GET_STATS with the accounting of task fn_name (see task_stats_to_args()) */
+static void _cnode_send_stats(cnode_t* cn, command_t* cmd) {
+    task_t* task = tboard_find_task_name(cn->tboard, cmd->fn_name);
+    if (task == NULL) {
+        printf("Unknown task in stats query \r\n");
+        cnode_send_error(cn, cmd);
+        return;
+    }
+    arg_t* values = calloc(TASK_STATS_NUM_VALUES, sizeof(arg_t));
+    if (values == NULL) {
+        cnode_send_error(cn, cmd);
+        return;
+    }
+    task_stats_to_args(task, values);
+    if (!_cnode_send_response_taking(cn, cmd, values)) {
+        printf("Could not send stats \r\n");
+    }
+}
+
+/* Converts the deadline carried by a received command to the local jam_time_us() clock */
+static int64_t _cnode_command_deadline(const command_t* cmd, int64_t now_us) {
+    int64_t deadline_us = 0;
+    if (cmd->deadline_at > 0) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        int64_t now_ms = (int64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+        deadline_us = now_us + (cmd->deadline_at - now_ms) * 1000;
+    } else if (cmd->deadline_ms > 0) {
+        deadline_us = now_us + cmd->deadline_ms * 1000;
+    } else {
+        return 0;
+    }
+    return deadline_us > 0 ? deadline_us : 1; // already expired, but 0 would mean no deadline
+}
+
+/* Starts the instance of a REXEC or REXEC_BATCH, NULL if it could not start */
+static task_instance_t* _cnode_start_instance(cnode_t* cn, command_t* cmd) {
+    tboard_start_options_t opts;
+    tboard_start_options_default(&opts);
+    opts.deadline_us = cmd->deadline_us;
+    if (cmd->cmd == CMD_REXEC_BATCH) {
+        /* One instance iterates the entry point over all argument tuples */
+        if (cmd->batch_size <= 0) return NULL;
+        opts.batch_size = cmd->batch_size;
+    }
+    return tboard_start_task_opts(cn->tboard, cmd->fn_name, cmd->task_id, cmd->args, &opts);
+}
+
+/* Number of REXECs of the task waiting for an instance slot */
+static uint32_t _cnode_count_waiting(cnode_t* cn, task_t* task) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < cn->num_waiting; i++) {
+        if (strcmp(cn->waiting[i].cmd->fn_name, task->name) == 0) count++;
+    }
+    return count;
+}
+
+/* Starts a REXEC or REXEC_BATCH and acknowledges it, then frees it. When every instance slot of its task is taken
+   and the task has a wait queue, the command waits in cn->waiting instead and is acknowledged once it starts. */
+static void _cnode_start_rexec(cnode_t* cn, command_t* cmd) {
+    task_t* task = tboard_find_task_name(cn->tboard, cmd->fn_name);
+    if (task != NULL && task->num_instances >= task->max_instances) {
+        _cnode_release_finished(cn, task);
+    }
+    if (task != NULL && task->wait_depth > 0) {
+        /* Earlier REXECs that are still waiting go first */
+        uint32_t waiting = _cnode_count_waiting(cn, task);
+        if (waiting > 0 || task->num_instances >= task->max_instances) {
+            if (waiting >= task->wait_depth || cn->num_waiting >= CNODE_MAX_WAITING) {
+                task->wait_drops++;
+                cnode_send_error_code(cn, cmd, REXEC_ERR_BUSY);
+                command_free(cmd);
+                return;
+            }
+            cn->waiting[cn->num_waiting].cmd = cmd;
+            cn->waiting[cn->num_waiting].queued_us = jam_time_us();
+            cn->num_waiting++;
+            return;
+        }
     }
 
+    if (_cnode_start_instance(cn, cmd) == NULL) {
+        printf("Could not start task \r\n");
+        cnode_send_error(cn, cmd);
+    } else if (!cnode_send_ack(cn, cmd)) {
+        printf("Could not send ack \r\n");
+    }
+    command_free(cmd);
+}
+
+/* Answers the result queries parked for the REXEC of a command with an error */
+static void _cnode_fail_pending_results(cnode_t* cn, command_t* cmd, rexec_error_t error) {
+    for (int j = 0; j < CNODE_MAX_PENDING_RESULTS; j++) {
+        command_t* query = cn->pending_results[j];
+        if (query == NULL || query->task_id != cmd->task_id || strcmp(query->fn_name, cmd->fn_name) != 0) continue;
+        cn->pending_results[j] = NULL;
+        cnode_send_error_code(cn, query, error);
+        _cnode_command_free(query);
+    }
+}
+
+/* Drops the waiting REXEC a CANCEL refers to, which gets a REXEC_ERR with REXEC_ERR_CANCELLED (as do the result
+   queries parked for it). Keeps the order of the other waiting REXECs. */
+static bool _cnode_cancel_waiting(cnode_t* cn, command_t* cancel) {
+    for (uint32_t i = 0; i < cn->num_waiting; i++) {
+        command_t* cmd = cn->waiting[i].cmd;
+        if (cmd->task_id != cancel->task_id || strcmp(cmd->fn_name, cancel->fn_name) != 0) continue;
+        memmove(&cn->waiting[i], &cn->waiting[i + 1], (cn->num_waiting - i - 1) * sizeof(cnode_waiting_t));
+        cn->num_waiting--;
+        task_t* task = tboard_find_task_name(cn->tboard, cmd->fn_name);
+        if (task != NULL) task->cancellations++;
+        cnode_send_error_code(cn, cmd, REXEC_ERR_CANCELLED);
+        _cnode_fail_pending_results(cn, cmd, REXEC_ERR_CANCELLED);
+        command_free(cmd);
+        return true;
+    }
     return false;
 }
 
+/* Starts the waiting REXECs whose task got a free instance slot, in arrival order, and rejects the ones that waited
+   longer than the wait timeout of their task */
+static void _cnode_dispatch_waiting(cnode_t* cn) {
+    int64_t now = jam_time_us();
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < cn->num_waiting; i++) {
+        cnode_waiting_t entry = cn->waiting[i];
+        command_t* cmd = entry.cmd;
+        task_t* task = tboard_find_task_name(cn->tboard, cmd->fn_name);
+        if (task != NULL && task->num_instances >= task->max_instances) {
+            _cnode_release_finished(cn, task);
+        }
+        if (task != NULL && task->num_instances < task->max_instances) {
+            if (_cnode_start_instance(cn, cmd) == NULL) {
+                printf("Could not start task \r\n");
+                cnode_send_error(cn, cmd);
+            } else if (!cnode_send_ack_waited(cn, cmd, (uint32_t) ((now - entry.queued_us) / 1000))) {
+                printf("Could not send ack \r\n");
+            }
+            command_free(cmd);
+            continue;
+        }
+        if (task == NULL || (task->wait_timeout_ms > 0 && now - entry.queued_us >= (int64_t) task->wait_timeout_ms * 1000)) {
+            rexec_error_t error = task != NULL ? REXEC_ERR_BUSY : REXEC_ERR_FAILED;
+            if (task != NULL) task->wait_drops++;
+            cnode_send_error_code(cn, cmd, error);
+            _cnode_fail_pending_results(cn, cmd, error);
+            command_free(cmd);
+            continue;
+        }
+        cn->waiting[kept++] = entry;
+    }
+    cn->num_waiting = kept;
+}
+
+
+/* Whether the processing task handles a command type */
+static bool _cnode_handles(jamcommand_t cmd) {
+    return cmd == CMD_REXEC || cmd == CMD_REXEC_BATCH || cmd == CMD_REXEC_CANCEL || cmd == CMD_GET_REXEC_RES ||
+           cmd == CMD_GET_STATS;
+}
+
+/* Handler of the request and reply subscriptions. They only match what the controller sends down, so the messages
+   this node publishes (on the up keys) are not delivered back to it. */
 static void _cnode_data_handler(z_loaned_sample_t* sample, void* arg) {
     /* Argument should be a cnode pointer */
     cnode_t* cnode = (cnode_t*) arg;
-    z_view_string_t keystr;
-    z_keyexpr_as_view_string(z_sample_keyexpr(sample), &keystr);
-    z_owned_string_t value;
-    z_bytes_to_string(z_sample_payload(sample), &value);
 
-    /* Do not want to print out what we send out */
-    if (_is_own_message(&keystr, cnode)) {
-        z_string_drop(z_string_move(&value));
-        return;
+    /* The attachment (if any) is enough to drop messages for another node or of a type this node does not handle,
+       before the CBOR decode */
+    bool urgent = false;
+    uint8_t raw_attachment[COMMAND_ATTACHMENT_LEN];
+    command_attachment_t attachment;
+    if (command_attachment_decode(raw_attachment, zenoh_sample_attachment(sample, raw_attachment, sizeof(raw_attachment)), &attachment)) {
+        if ((attachment.target != 0 && attachment.target != cnode->node_hash) || !_cnode_handles(attachment.cmd)) {
+            cnode->filtered_messages++;
+            return;
+        }
+        /* Only a REXEC may overtake: a CANCEL must stay behind the REXEC it refers to */
+        urgent = attachment.priority > 0 && (attachment.cmd == CMD_REXEC || attachment.cmd == CMD_REXEC_BATCH);
     }
 
-    // debug_log(" >> [Subscriber handler] Received ('%.*s': '%.*s')\n", (int)z_string_len(z_view_string_loan(&keystr)),
-    //        z_string_data(z_view_string_loan(&keystr)), (int)z_string_len(z_string_loan(&value)),
-    //        z_string_data(z_string_loan(&value)));
+    z_owned_string_t value;
+    z_bytes_to_string(z_sample_payload(sample), &value);
 
     /* Call the new function to process the message */
     command_t *cmd = cnode_process_received_cmd(cnode, z_string_data(z_string_loan(&value)), (int) z_string_len(z_string_loan(&value)));   
@@ -91,49 +389,93 @@ static void _cnode_data_handler(z_loaned_sample_t* sample, void* arg) {
         printf("Failed to process command\n");
         return;
     }
-    /* Instead of processing here, push the command onto the queue */
-    if (xQueueSendToBack(cnode->commandQueue, &cmd, (TickType_t)10) != pdPASS) {
+    /* Instead of processing here, push the command onto the queue, urgent REXECs first */
+    BaseType_t queued = urgent ? xQueueSendToFront(cnode->commandQueue, &cmd, (TickType_t)10)
+                               : xQueueSendToBack(cnode->commandQueue, &cmd, (TickType_t)10);
+    if (queued != pdPASS) {
         printf("Failed to enqueue command\n");
         command_free(cmd);
         
     }
 }
 
+/* Handler of the result queryable. The payload of a query is a GET_REXEC_RES: the query goes with the command to the
+   processing task and is answered, to the requester alone, once the instance is over. */
+static void _cnode_result_query_handler(z_loaned_query_t* query, void* arg) {
+    cnode_t* cnode = (cnode_t*) arg;
+    z_owned_string_t value;
+    z_bytes_to_string(z_query_payload(query), &value);
+    command_t *cmd = cnode_process_received_cmd(cnode, z_string_data(z_string_loan(&value)), (int) z_string_len(z_string_loan(&value)));
+    z_string_drop(z_string_move(&value));
+
+    if (cmd == NULL) {
+        printf("Failed to process result query\n");
+        return;
+    }
+    if (cmd->cmd != CMD_GET_REXEC_RES) {
+        printf("Result query is not a GET_REXEC_RES\n");
+        command_free(cmd);
+        return;
+    }
+    /* Keep the query past this callback, it is finalized when the command is freed */
+    z_owned_query_t* owned = malloc(sizeof(z_owned_query_t));
+    if (owned == NULL || z_query_clone(owned, query) != Z_OK) {
+        printf("Could not keep result query\n");
+        if (owned != NULL) {
+            free(owned);
+        }
+        command_free(cmd);
+        return;
+    }
+    cmd->reply_query = owned;
+    cmd->reply_session = cnode->zenoh->session_seq;
+    if (xQueueSendToBack(cnode->commandQueue, &cmd, (TickType_t)10) != pdPASS) {
+        printf("Failed to enqueue result query\n");
+        _cnode_command_free(cmd);
+    }
+}
 
 void cnode_cmd_processing_task(void* pvParameters) {
     cnode_t* cn = (cnode_t*) pvParameters;
     command_t* received_cmd;
+    TickType_t last_profile_save = xTaskGetTickCount();
     while (1) {
+        /* Persist newly observed stack maxima, rate limited to spare the flash */
+        if (cn->tboard->stack_profile_dirty &&
+            xTaskGetTickCount() - last_profile_save >= pdMS_TO_TICKS(STACK_PROFILE_SAVE_PERIOD_MS)) {
+            tboard_save_stack_profile(cn->tboard);
+            last_profile_save = xTaskGetTickCount();
+        }
         if (xQueueReceive(cn->commandQueue, &received_cmd, (TickType_t)10) == pdPASS) {
-            /* Process the command based on its type */
-            if (received_cmd->cmd == CMD_REXEC) {
-                if (!tboard_start_task(cn->tboard, received_cmd->fn_name,
-                                       received_cmd->task_id, received_cmd->args)) {
-                    printf("Could not start task \r\n");
-                    command_free(received_cmd);
+            /* Process the command based on its type. Task ids from TBOARD_INTERNAL_SERIAL_BASE up belong to the
+               instances the tboard creates itself (periodic releases, tboard_invoke()). */
+            if (received_cmd->task_id >= TBOARD_INTERNAL_SERIAL_BASE &&
+                (received_cmd->cmd == CMD_REXEC || received_cmd->cmd == CMD_REXEC_BATCH ||
+                 received_cmd->cmd == CMD_REXEC_CANCEL || received_cmd->cmd == CMD_GET_REXEC_RES)) {
+                printf("Task id out of range \r\n");
+                cnode_send_error(cn, received_cmd);
+                _cnode_command_free(received_cmd);
+            }
+            else if (received_cmd->cmd == CMD_REXEC || received_cmd->cmd == CMD_REXEC_BATCH) {
+                _cnode_start_rexec(cn, received_cmd);
+            }
+            else if (received_cmd->cmd == CMD_REXEC_CANCEL) {
+                /* The result query of the cancelled instance gets a REXEC_ERR with REXEC_ERR_CANCELLED. A REXEC still
+                   waiting for an instance slot has no instance yet: it is dropped from the wait queue. */
+                if (!_cnode_cancel_waiting(cn, received_cmd) &&
+                    !tboard_cancel_task(cn->tboard, received_cmd->fn_name, received_cmd->task_id)) {
+                    printf("Could not cancel task \r\n");
                     cnode_send_error(cn, received_cmd);
-                    continue;
-                } 
-                
-                /* Send ack */
-                if (!cnode_send_ack(cn, received_cmd)) {
+                } else if (!cnode_send_ack(cn, received_cmd)) {
                     printf("Could not send ack \r\n");
                 }
                 command_free(received_cmd);
             }
             else if (received_cmd->cmd == CMD_GET_REXEC_RES) {
-                arg_t* retarg = _cnode_return_task(cn, received_cmd);
-
-                if (retarg == NULL) {
-                    printf("Failed to get task return value\n");
-                    command_free(received_cmd);
-                    cnode_send_error(cn, received_cmd);
-                    continue;
-                } 
-                if (!cnode_send_response(cn, received_cmd, retarg)) {
-                    printf("Could not send response \r\n");
-                }
-                command_args_free(retarg);
+                _cnode_get_result(cn, received_cmd);
+            }
+            else if (received_cmd->cmd == CMD_GET_STATS) {
+                _cnode_send_stats(cn, received_cmd);
                 command_free(received_cmd);
             }
             else{
@@ -142,18 +484,70 @@ void cnode_cmd_processing_task(void* pvParameters) {
             }
             
         }
+        /* A session was lost: the result queries it brought are dropped, not answered on the next one */
+        if (cn->query_session != cn->zenoh->session_seq || !zenoh_is_connected(cn->zenoh)) {
+            _cnode_drop_lost_queries(cn);
+            cn->query_session = cn->zenoh->session_seq;
+        }
+        _cnode_dispatch_completions(cn);
+        _cnode_expire_pending_results(cn);
+        if (cn->num_waiting > 0) {
+            _cnode_dispatch_waiting(cn);
+        }
+        /* Replies of this pass that are still batched go out once the window is over */
+        if (cn->zenoh->batching && jam_time_us() - cn->batch_started_us >= CNODE_BATCH_WINDOW_MS * 1000) {
+            _cnode_close_batch(cn);
+        }
+        /* Replies kept while the session was lost go out once the supervisor restored it */
+        if (cn->outbox_len > 0 && zenoh_is_connected(cn->zenoh)) {
+            _cnode_flush_outbox(cn);
+        }
         vTaskDelay(1);
     }
 }
 
 
+/* Reads the "--name=value" arguments of cnode_init() into args (the fields of the other names stay NULL or 0). Returns
+   false on an unknown argument. */
+static bool _cnode_process_args(int argc, char** argv, cnode_args_t* args, bool* save) {
+    memset(args, 0, sizeof(cnode_args_t));
+    *save = false;
+    for (int i = 1; i < argc; i++) {
+        char* arg = argv[i];
+        char* value = strchr(arg, '=');
+        if (strcmp(arg, "--save") == 0) {
+            *save = true;
+        } else if (strncmp(arg, "--", 2) != 0 || value == NULL) {
+            printf("cnode: invalid argument %s \r\n", arg);
+            return false;
+        } else if (strncmp(arg, "--zmode=", value - arg + 1) == 0) {
+            args->zmode = value + 1;
+        } else if (strncmp(arg, "--transport=", value - arg + 1) == 0) {
+            args->transport = value + 1;
+        } else if (strncmp(arg, "--host=", value - arg + 1) == 0) {
+            args->host = value + 1;
+        } else if (strncmp(arg, "--port=", value - arg + 1) == 0) {
+            args->port = atoi(value + 1);
+        } else if (strncmp(arg, "--iface=", value - arg + 1) == 0) {
+            args->iface = value + 1;
+        } else {
+            printf("cnode: unknown argument %s \r\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
 /* PUBLIC FUNCTIONS */
 cnode_t* cnode_init(int argc, char** argv) {
     /* Dynamically allocate cn */
     cnode_t* cn = (cnode_t *)calloc(1, sizeof(cnode_t));
 
-    /* Process args */
-    // TODO: args = process_args(argc, argv);
+    /* Process args, applied to the session parameters once they are loaded */
+    cnode_args_t args;
+    bool save_args;
+    bool args_valid = _cnode_process_args(argc, argv, &args, &save_args);
+#if !CONFIG_IDF_TARGET_LINUX /* the host build uses the network of the host */
 #ifdef PRINT_INIT_PROGRESS
 printf("Initiating system ... \r\n");
 #endif
@@ -174,6 +568,7 @@ printf("Initiating Wi-Fi ... \r\n");
         cnode_destroy(cn);
         return false;
     }
+#endif
     
     /* Init core */
     uint32_t serial_num = 0; // serial num should be determined by args 
@@ -198,19 +593,18 @@ printf("Initiating core ... \r\n");
     }
     // Do we really need the node_id field? Its already in core_state
     cn->node_id = cn->core_state->device_id; 
+    cn->node_hash = command_node_hash(cn->node_id);
+
+    /* Session parameters of this deployment, the built-in ones if none were stored */
+    if (!zenoh_config_load(&cn->zenoh_config)) {
+        printf("No stored zenoh configuration, using %s %s \r\n", cn->zenoh_config.mode, cn->zenoh_config.connect);
+    }
+    if (!args_valid || !cnode_apply_args(cn, &args, save_args)) {
+        printf("Arguments ignored, using %s %s \r\n", cn->zenoh_config.mode, cn->zenoh_config.connect);
+    }
+
+    /* The controller is found by cnode_start() when no connect locator is configured, see zenoh_init_discovered() */
 
-/*
-TODO: Currently calling zenoh_scout() creates buggy behavior for zenoh communication
-*/
-// #ifdef PRINT_INIT_PROGRESS
-// printf("Scouting for JNodes ... \r\n");
-// #endif
-//     /* Using Zenoh to scout for JNodes */
-//     if (!zenoh_scout()) {
-//         printf("Could not find any JNodes. \r\n");
-//         //cnode_destroy(cn);
-//         return false;
-//     }
     /* Create the command queue */
     
     cn->commandQueue = xQueueCreate(QUEUE_LENGTH, sizeof(command_t *));
@@ -227,6 +621,35 @@ printf("cnode %lu initialized. \r\n", serial_num);
     return cn;
 }
 
+bool cnode_apply_args(cnode_t* cn, const cnode_args_t* args, bool save) {
+    if (cn == NULL || args == NULL) {
+        return false;
+    }
+    zenoh_config_t config = cn->zenoh_config;
+    if (args->zmode != NULL) {
+        if (strcmp(args->zmode, "peer") != 0 && strcmp(args->zmode, "client") != 0) {
+            printf("cnode_apply_args: invalid zenoh mode %s \r\n", args->zmode);
+            return false;
+        }
+        strcpy(config.mode, args->zmode);
+    }
+    if (args->transport != NULL && strcmp(args->transport, "scout") == 0) {
+        config.connect[0] = '\0';
+    } else if (args->transport != NULL) {
+        zenoh_transport_t transport = zenoh_transport_from_str(args->transport);
+        if (args->host == NULL ||
+            !zenoh_config_set_endpoint(&config, transport, args->host, args->port, args->iface)) {
+            printf("cnode_apply_args: invalid transport %s \r\n", args->transport);
+            return false;
+        }
+    }
+    if (save && !zenoh_config_save(&config)) {
+        return false;
+    }
+    cn->zenoh_config = config;
+    return true;
+}
+
 // NOTE: comment given from the previous esp32 version
 // Many of the cnode start/stop/destryo commands aren't necessary to use on the esp32 as we have our
 // own boot phase before the user program executes.
@@ -247,6 +670,10 @@ void cnode_destroy(cnode_t* cn) {
         //free(cn->zenoh_pub_reply->keyexpr);
     }
 
+    if (cn->zenoh_pub_ack != NULL) {
+        free(cn->zenoh_pub_ack);
+    }
+
     if (cn->zenoh_pub_request != NULL) {
         //z_drop(z_move(cn->zenoh_pub_request->z_pub));
         free(cn->zenoh_pub_request);
@@ -258,6 +685,21 @@ void cnode_destroy(cnode_t* cn) {
 
     if (cn->commandQueue != NULL)
         vQueueDelete(cn->commandQueue);
+
+    for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+        if (cn->pending_results[i] != NULL) {
+            _cnode_command_free(cn->pending_results[i]);
+        }
+    }
+    for (uint32_t i = 0; i < cn->num_waiting; i++) {
+        command_free(cn->waiting[i].cmd);
+    }
+    for (int i = 0; i < CNODE_MAX_FINISHED; i++) {
+        task_instance_destroy(cn->finished[i]);
+    }
+    for (uint32_t i = 0; i < cn->outbox_len; i++) {
+        command_free(cn->outbox[i].retcmd);
+    }
     free(cn);
 }
 
@@ -272,7 +714,12 @@ bool cnode_start(cnode_t* cn) {
 #ifdef PRINT_INIT_PROGRESS
 printf("cnode %d: declaring Zenoh session ... \r\n", serial_num);
 #endif
-    cn->zenoh = zenoh_init();
+    /* Without a configured locator the controller is found from the cache, or by scouting */
+    if (cn->zenoh_config.connect[0] == '\0') {
+        cn->zenoh = zenoh_init_discovered(&cn->zenoh_config);
+    } else {
+        cn->zenoh = zenoh_init_with_config(&cn->zenoh_config);
+    }
     if (cn->zenoh == NULL) {
         printf("Could not open Zenoh session. \r\n");
         return false;
@@ -293,24 +740,56 @@ printf("cnode %d: declaring Zenoh pubs ... \r\n", serial_num);
     //char* cnode_request_pub_ke = malloc(strlen(CNODE_REQUEST_PUB_KEYEXPR)*sizeof(char));
     //cnode_request_pub_ke = CNODE_REQUEST_PUB_KEYEXPR;
     cn->zenoh_pub_request = calloc(1, sizeof(zenoh_pub_t));
+    cn->zenoh_pub_ack = calloc(1, sizeof(zenoh_pub_t));
 
-    if (!zenoh_declare_pub(cn->zenoh, CNODE_REPLY_PUB_KEYEXPR, cn->zenoh_pub_reply)) {
+    zenoh_qos_t qos;
+    zenoh_qos_init(&qos, ZENOH_QOS_DATA);
+    if (!zenoh_declare_pub_qos(cn->zenoh, CNODE_REPLY_PUB_KEYEXPR, cn->zenoh_pub_reply, &qos)) {
         printf("Could not declare reply publisher. \r\n");
         return false;
     }
     
-    if (!zenoh_declare_pub(cn->zenoh, CNODE_REQUEST_PUB_KEYEXPR, cn->zenoh_pub_request)) {
+    if (!zenoh_declare_pub_qos(cn->zenoh, CNODE_REQUEST_PUB_KEYEXPR, cn->zenoh_pub_request, &qos)) {
         printf("Could not declare request publisher. \r\n");
         return false;
     }
+
+    /* ACKs and errors are small and go express at a higher priority, so they do not queue behind large results */
+    zenoh_qos_init(&qos, ZENOH_QOS_CONTROL);
+    if (!zenoh_declare_pub_qos(cn->zenoh, CNODE_REPLY_PUB_KEYEXPR, cn->zenoh_pub_ack, &qos)) {
+        printf("Could not declare ack publisher. \r\n");
+        return false;
+    }
     
 #ifdef PRINT_INIT_PROGRESS
-printf("cnode %d: declaring Zenoh sub ... \r\n", serial_num);
+printf("cnode %d: declaring Zenoh subs ... \r\n", serial_num);
 #endif
-    if (!zenoh_declare_sub(cn->zenoh, CNODE_SUB_KEYEXPR, _cnode_data_handler, (void*) cn)) {
-        printf("Could not declare subscriber \r\n");
+    /* One subscription per traffic class, each with its own statistics */
+    cn->zenoh_sub_requests = zenoh_subscribe(cn->zenoh, CNODE_REQUEST_SUB_KEYEXPR, _cnode_data_handler, (void*) cn);
+    if (cn->zenoh_sub_requests < 0) {
+        printf("Could not declare request subscriber \r\n");
         return false;
     }
+    cn->zenoh_sub_replies = zenoh_subscribe(cn->zenoh, CNODE_REPLY_SUB_KEYEXPR, _cnode_data_handler, (void*) cn);
+    if (cn->zenoh_sub_replies < 0) {
+        printf("Could not declare reply subscriber \r\n");
+        return false;
+    }
+    /* Results are fetched with z_get on the result key of the node, the reply goes to the requester only */
+    snprintf(cn->result_keyexpr, sizeof(cn->result_keyexpr), CNODE_RESULT_QUERYABLE_KEYEXPR "/%s", cn->node_id);
+    if (!zenoh_declare_queryable(cn->zenoh, cn->result_keyexpr, _cnode_result_query_handler, (void*) cn)) {
+        printf("Could not declare result queryable \r\n");
+        return false;
+    }
+    /* Reopens the session and declares everything above again when the connection is lost */
+    if (!zenoh_start_supervisor(cn->zenoh)) {
+        printf("Could not start zenoh supervisor \r\n");
+        return false;
+    }
+    /* Keeps the cached controller locators current for the next boot */
+    if (!zenoh_start_discovery(cn->zenoh)) {
+        printf("Could not start zenoh discovery \r\n");
+    }
 
 #ifdef PRINT_INIT_PROGRESS
 printf("cnode %d: successfully started. \r\n", serial_num);
@@ -327,34 +806,51 @@ bool cnode_stop(cnode_t* cn) {
     if (cn == NULL || !cn->initialized) {
         return false;
     }
-    /* Stop all tasks */
-    if (zp_stop_read_task(z_loan(cn->zenoh->z_session)) < 0) {
-        printf("Could not stop read task \r\n");
-        return false; 
-    } 
-    if (zp_stop_lease_task(z_loan(cn->zenoh->z_session)) < 0) {
-        printf("Could not stop lease task \r\n");
-        return false;
+    /* Stop all tasks, the supervisor first so it does not reopen the session */
+    zenoh_stop_discovery(cn->zenoh);
+    zenoh_stop_supervisor(cn->zenoh);
+    /* A session lost and not reopened was closed with its read and lease tasks */
+    if (cn->zenoh->session_open) {
+        if (zp_stop_read_task(z_loan(cn->zenoh->z_session)) < 0) {
+            printf("Could not stop read task \r\n");
+            return false; 
+        } 
+        if (zp_stop_lease_task(z_loan(cn->zenoh->z_session)) < 0) {
+            printf("Could not stop lease task \r\n");
+            return false;
+        }
     }
 
-    /* Undeclare subscriber and publisher */
-    if (z_undeclare_subscriber(z_move(cn->zenoh->z_sub)) < 0) {
+    _cnode_close_batch(cn);
+
+    /* Undeclare subscribers and publishers */
+    if (!zenoh_unsubscribe(cn->zenoh, cn->zenoh_sub_requests) || !zenoh_unsubscribe(cn->zenoh, cn->zenoh_sub_replies)) {
         printf("Could not undeclare sub \r\n");
         return false;
     }
 
-    if (z_undeclare_publisher(z_move(cn->zenoh_pub_reply->z_pub)) < 0){ 
+    if (!zenoh_undeclare_queryable(cn->zenoh)) {
+        printf("Could not undeclare result queryable \r\n");
+        return false;
+    }
+
+    if (!zenoh_undeclare_pub(cn->zenoh, cn->zenoh_pub_reply)) {
         printf("Could not undeclare reply pub \r\n");
         return false;
     }
 
-    if (z_undeclare_publisher(z_move(cn->zenoh_pub_request->z_pub)) < 0){ 
+    if (!zenoh_undeclare_pub(cn->zenoh, cn->zenoh_pub_request)) {
         printf("Could not undeclare request pub \r\n");
         return false;
     }
 
+    if (!zenoh_undeclare_pub(cn->zenoh, cn->zenoh_pub_ack)) {
+        printf("Could not undeclare ack pub \r\n");
+        return false;
+    }
+
     /* Drop session */
-    if (!z_session_is_closed(z_loan(cn->zenoh->z_session))) {
+    if (cn->zenoh->session_open && !z_session_is_closed(z_loan(cn->zenoh->z_session))) {
         z_session_drop(z_move(cn->zenoh->z_session));
     }
 
@@ -376,6 +872,8 @@ command_t* cnode_process_received_cmd(cnode_t* cn, const char* buf, size_t bufle
         fprintf(stderr, "[ERROR] Failed to parse command from data\n");
         return NULL;
     }
+    /* Relative deadlines count from reception, not from when the processing task gets to the command */
+    cmd->deadline_us = _cnode_command_deadline(cmd, jam_time_us());
 
     return cmd;
 }
@@ -384,16 +882,125 @@ bool cnode_send_cmd(cnode_t* cn, command_t* cmd){
     if (!cn || !cmd) {
         return false;
     }
+    command_attachment_t attachment;
+    command_attachment_init(&attachment, cmd, NULL, 0);
+    uint8_t raw_attachment[COMMAND_ATTACHMENT_LEN];
+    size_t attachment_len = command_attachment_encode(&attachment, raw_attachment);
     // Publish the command to the Zenoh network
-    return zenoh_publish_encoded(cn->zenoh, cn->zenoh_pub_request, (const uint8_t *)cmd->buffer, (size_t) cmd->length);
+    return zenoh_publish_encoded_attached(cn->zenoh, cn->zenoh_pub_request, (const uint8_t *)cmd->buffer, (size_t) cmd->length,
+                                          raw_attachment, attachment_len);
 }   
 
-bool cnode_send_response(cnode_t* cn, command_t* cmd, arg_t* retarg) {
+/* Sends the open send batch and closes it, messages go out one by one until the next batched reply */
+static void _cnode_close_batch(cnode_t* cn) {
+    if (!cn->zenoh->batching) return;
+    if (!zenoh_batch_stop(cn->zenoh)) {
+        printf("Could not send batch \r\n");
+    }
+    cn->batch_bytes = 0;
+    cn->batches_sent++;
+}
+
+/* Makes room for a reply of len bytes in the send batch, opening the batch if needed. Returns false when batching is
+   not available: the reply is then sent on its own. */
+static bool _cnode_batch_add(cnode_t* cn, size_t len) {
+    if (!cn->zenoh->batching) {
+        if (!zenoh_batch_start(cn->zenoh)) return false;
+        cn->batch_started_us = jam_time_us();
+        cn->batch_bytes = 0;
+    } else if (cn->batch_bytes + len > CNODE_BATCH_MAX_BYTES) {
+        /* One frame is full, send it and keep batching */
+        if (!zenoh_batch_flush(cn->zenoh)) {
+            printf("Could not send batch \r\n");
+        }
+        cn->batch_bytes = 0;
+        cn->batches_sent++;
+    }
+    cn->batch_bytes += len;
+    return true;
+}
+
+/* Publishes retcmd with zenoh_pub. Results are grouped in the send batch; ACKs and errors are latency sensitive and
+   flush it. */
+static bool _cnode_publish_reply(cnode_t* cn, zenoh_pub_t* zenoh_pub, command_t* retcmd) {
+    /* Routing metadata for the controller, ACKs and errors are marked urgent */
+    bool urgent = zenoh_pub == cn->zenoh_pub_ack;
+    command_attachment_t attachment;
+    command_attachment_init(&attachment, retcmd, NULL, urgent ? 1 : 0);
+    uint8_t raw_attachment[COMMAND_ATTACHMENT_LEN];
+    size_t attachment_len = command_attachment_encode(&attachment, raw_attachment);
+
+    if (!urgent && _cnode_batch_add(cn, (size_t)retcmd->length + attachment_len)) {
+        /* Sent with the other replies of the window, see cnode_cmd_processing_task() */
+        return zenoh_publish_encoded_attached(cn->zenoh, zenoh_pub, (const uint8_t *)retcmd->buffer, (size_t)retcmd->length,
+                                              raw_attachment, attachment_len);
+    }
+    /* No pacing here: the ACK publisher blocks on a congested transport (ZENOH_QOS_CONTROL) instead of dropping */
+    bool sent = zenoh_publish_encoded_attached(cn->zenoh, zenoh_pub, (const uint8_t *)retcmd->buffer, (size_t)retcmd->length,
+                                               raw_attachment, attachment_len);
+    /* Also sends the results batched before it, in order */
+    _cnode_close_batch(cn);
+    return sent;
+}
+
+/* Keeps retcmd in the outbox until the session is back. Returns false when the outbox is full and the reply is lost. */
+static bool _cnode_outbox_push(cnode_t* cn, zenoh_pub_t* zenoh_pub, command_t* retcmd) {
+    if (cn->outbox_len >= CNODE_OUTBOX_LEN) {
+        cn->outbox_drops++;
+        printf("cnode: outbox full, reply of task %llu dropped \r\n", (unsigned long long) retcmd->task_id);
+        return false;
+    }
+    command_hold(retcmd);
+    cn->outbox[cn->outbox_len].retcmd = retcmd;
+    cn->outbox[cn->outbox_len].zenoh_pub = zenoh_pub;
+    cn->outbox_len++;
+    return true;
+}
+
+/* Publishes the outbox in order, up to the first reply that fails again */
+static void _cnode_flush_outbox(cnode_t* cn) {
+    uint32_t sent = 0;
+    while (sent < cn->outbox_len && _cnode_publish_reply(cn, cn->outbox[sent].zenoh_pub, cn->outbox[sent].retcmd)) {
+        command_free(cn->outbox[sent].retcmd);
+        sent++;
+    }
+    _cnode_close_batch(cn);
+    memmove(cn->outbox, cn->outbox + sent, (cn->outbox_len - sent) * sizeof(cnode_outbox_t));
+    cn->outbox_len -= sent;
+}
+
+/* Sends the reply retcmd of cmd: to the requester alone when cmd came with a query, published with zenoh_pub otherwise.
+   Published replies wait in the outbox while the session is lost, and behind the ones already waiting there. */
+static bool _cnode_send_reply(cnode_t* cn, zenoh_pub_t* zenoh_pub, command_t* cmd, command_t* retcmd) {
+    if (_cnode_query_lost(cn, cmd)) {
+        _cnode_drop_query(cmd);
+        return false;
+    }
+    if (cmd->reply_query != NULL) {
+        z_owned_query_t* query = (z_owned_query_t*) cmd->reply_query;
+        bool sent = zenoh_reply_encoded(z_loan(*query), cn->result_keyexpr, (const uint8_t *)retcmd->buffer,
+                                        (size_t)retcmd->length);
+        _cnode_close_batch(cn);
+        return sent;
+    }
+    if (!zenoh_is_connected(cn->zenoh) || cn->outbox_len > 0) {
+        return _cnode_outbox_push(cn, zenoh_pub, retcmd);
+    }
+    if (!_cnode_publish_reply(cn, zenoh_pub, retcmd)) {
+        return _cnode_outbox_push(cn, zenoh_pub, retcmd);
+    }
+    return true;
+}
+
+/* Sends the REXEC_RES of cmd (see _cnode_send_reply()). The response takes ownership of retarg (see command_new_taking_arg()). */
+static bool _cnode_send_response_taking(cnode_t* cn, command_t* cmd, arg_t* retarg) {
     if (!cn || !cmd || !retarg) {
+        command_args_free(retarg);
         return false;
     }
     if (!cn->zenoh || !cn->zenoh_pub_request) {
         printf("cnode_send_ack: cn->zenoh or cn->zenoh_pub_request is NULL\n");
+        command_args_free(retarg);
         return false;
     }
     jamcommand_t cmdName = CMD_REXEC_RES;
@@ -403,28 +1010,39 @@ bool cnode_send_response(cnode_t* cn, command_t* cmd, arg_t* retarg) {
     const char* node_id = cmd->node_id;
     const char* fn_argsig = cmd->fn_argsig;
     
-    command_t *retcmd = command_new_using_arg(cmdName, subcmd, fn_name, task_id, node_id, fn_argsig, retarg);
+    command_t *retcmd = command_new_taking_arg(cmdName, subcmd, fn_name, task_id, node_id, fn_argsig, retarg);
 
     if (!retcmd) {
         printf("cnode_send_response: retcmd is NULL\n");
+        command_args_free(retarg);
         return false;
     }
 
-    sleep(1); // TODO: this sleep is necessary to ensure that messages are sent consistently. There needs to be a better method
-    // Publish the command to the Zenoh network
-    bool sent = zenoh_publish_encoded(cn->zenoh, cn->zenoh_pub_reply, (const uint8_t *)retcmd->buffer, (size_t) retcmd->length);
+    bool sent = _cnode_send_reply(cn, cn->zenoh_pub_reply, cmd, retcmd);
 
     command_free(retcmd);
     return sent;
 }
 
+bool cnode_send_response(cnode_t* cn, command_t* cmd, arg_t* retarg) {
+    if (!retarg) {
+        return false;
+    }
+    /* The caller keeps retarg */
+    return _cnode_send_response_taking(cn, cmd, command_args_clone(retarg));
+}
+
 bool cnode_send_error(cnode_t* cn, command_t* cmd) {
+    return cnode_send_error_code(cn, cmd, REXEC_ERR_FAILED);
+}
+
+bool cnode_send_error_code(cnode_t* cn, command_t* cmd, rexec_error_t error) {
     if (!cn || !cmd) {
         printf("cnode_send_error: null cnode or cmd\n");
         return false;
     }
-    if (!cn->zenoh || !cn->zenoh_pub_reply) {
-        printf("cnode_send_error: cn->zenoh or cn->zenoh_pub_request is NULL\n");
+    if (!cn->zenoh || !cn->zenoh_pub_ack) {
+        printf("cnode_send_error: cn->zenoh or cn->zenoh_pub_ack is NULL\n");
         return false;
     }
     jamcommand_t cmdName = CMD_REXEC_ERR;
@@ -432,29 +1050,28 @@ bool cnode_send_error(cnode_t* cn, command_t* cmd) {
     const char* fn_name = cmd->fn_name;
     uint64_t task_id = cmd->task_id;
     const char* node_id = cmd->node_id;
-    const char* fn_argsig = "";
+    const char* fn_argsig = "i";
     
-    command_t *retcmd = command_new(cmdName, subcmd, fn_name, task_id, node_id, fn_argsig, NULL);
+    command_t *retcmd = command_new(cmdName, subcmd, fn_name, task_id, node_id, fn_argsig, (int) error);
     if (!retcmd) {
-        printf("cnode_send_ack: retcmd is NULL\n");
+        printf("cnode_send_error: retcmd is NULL\n");
         return false;
     }
 
-    sleep(1); // TODO: this sleep is necessary to ensure that messages are sent consistently. There needs to be a better method
-    // Publish the command to the Zenoh network
-    bool sent = zenoh_publish_encoded(cn->zenoh, cn->zenoh_pub_reply, (const uint8_t *)retcmd->buffer, (size_t)retcmd->length);
+    bool sent = _cnode_send_reply(cn, cn->zenoh_pub_ack, cmd, retcmd);
     
     command_free(retcmd);
     return sent;
 }
 
-bool cnode_send_ack(cnode_t* cn, command_t* cmd) {
+/* Publishes a REXEC_ACK of cmd, with one int argument if fn_argsig is "i" */
+static bool _cnode_send_ack_args(cnode_t* cn, command_t* cmd, const char* fn_argsig, int value) {
     if (!cn || !cmd) {
         printf("cnode_send_ack: null cnode or cmd\n");
         return false;
     }
-    if (!cn->zenoh || !cn->zenoh_pub_reply) {
-        printf("cnode_send_ack: cn->zenoh or cn->zenoh_pub_request is NULL\n");
+    if (!cn->zenoh || !cn->zenoh_pub_ack) {
+        printf("cnode_send_ack: cn->zenoh or cn->zenoh_pub_ack is NULL\n");
         return false;
     }
     jamcommand_t cmdName = CMD_REXEC_ACK;
@@ -462,18 +1079,23 @@ bool cnode_send_ack(cnode_t* cn, command_t* cmd) {
     const char* fn_name = cmd->fn_name;
     uint64_t task_id = cmd->task_id;
     const char* node_id = cmd->node_id;
-    const char* fn_argsig = "";
     
-    command_t *retcmd = command_new(cmdName, subcmd, fn_name, task_id, node_id, fn_argsig, NULL);
+    command_t *retcmd = command_new(cmdName, subcmd, fn_name, task_id, node_id, fn_argsig, value);
     if (!retcmd) {
         printf("cnode_send_ack: retcmd is NULL\n");
         return false;
     }
 
-    sleep(1); // TODO: this sleep is necessary to ensure that messages are sent consistently. There needs to be a better method
-    // Publish the command to the Zenoh network
-    bool sent = zenoh_publish_encoded(cn->zenoh, cn->zenoh_pub_reply, (const uint8_t *)retcmd->buffer, (size_t)retcmd->length);
+    bool sent = _cnode_send_reply(cn, cn->zenoh_pub_ack, cmd, retcmd);
     
     command_free(retcmd);
     return sent;
+}
+
+bool cnode_send_ack(cnode_t* cn, command_t* cmd) {
+    return _cnode_send_ack_args(cn, cmd, "", 0);
+}
+
+bool cnode_send_ack_waited(cnode_t* cn, command_t* cmd, uint32_t waited_ms) {
+    return _cnode_send_ack_args(cn, cmd, "i", (int) waited_ms);
 }
\ No newline at end of file
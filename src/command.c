@@ -124,17 +124,53 @@ command_t* command_new(jamcommand_t cmd, int subcmd, const char* fn_name, uint64
     return c;
 }
 
-command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_name,
-                                 uint64_t taskid, const char* node_id,
-                                 const char* fn_argsig, arg_t* args)
+/*
+ * Encode a single argument value into the CBOR container.
+ */
+static void _command_encode_arg(CborEncoder* encoder, arg_t* arg)
 {
-    command_t* cmdo = (command_t*)calloc(1, sizeof(command_t));
-    
     nvoid_t* nv;
+    switch (arg->type)
+    {
+    case NVOID_TYPE:
+        nv = arg->val.nval;
+        cbor_encode_byte_string(encoder, nv->data, nv->len);
+        break;
+    case STRING_TYPE:
+        cbor_encode_text_stringz(encoder, arg->val.sval);
+        break;
+    case INT_TYPE:
+    case LONG_TYPE:
+        if (arg->val.ival < 0)
+            cbor_encode_negative_int(encoder, abs(arg->val.ival));
+        else
+            cbor_encode_int(encoder, arg->val.ival);
+        break;
+    case DOUBLE_TYPE:
+        cbor_encode_double(encoder, arg->val.dval);
+        break;
+    case NULL_TYPE:
+        cbor_encode_null(encoder);
+    default:;
+    }
+}
+
+/*
+ * Builds the command and its CBOR representation. With batch_size > 0 the args
+ * array holds batch_size tuples of equal arity and is encoded as an array of arrays,
+ * announced by a "batch" field carrying the number of tuples.
+ * With take_args the command keeps args itself instead of a clone.
+ */
+static command_t* _command_new(jamcommand_t cmd, int subcmd, const char* fn_name,
+                               uint64_t taskid, const char* node_id,
+                               const char* fn_argsig, arg_t* args, int batch_size,
+                               bool take_args)
+{
+    command_t* cmdo = (command_t*)calloc(1, sizeof(command_t));
 
-    CborEncoder encoder, mapEncoder, arrayEncoder;
+    CborEncoder encoder, mapEncoder, arrayEncoder, tupleEncoder;
     cbor_encoder_init(&encoder, cmdo->buffer, HUGE_CMD_STR_LEN, 0);
-    cbor_encoder_create_map(&encoder, &mapEncoder, 7);
+    cbor_encoder_create_map(&encoder, &mapEncoder, (args != NULL && batch_size > 0) ? 8 : 7);
 
     // store the fields into the structure and encode into the CBOR
     // store and encode cmd
@@ -167,6 +203,13 @@ command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_na
     COPY_STRING(cmdo->fn_argsig, fn_argsig, SMALL_CMD_STR_LEN);
     cbor_encode_text_stringz(&mapEncoder, "fn_argsig");
     cbor_encode_text_stringz(&mapEncoder, fn_argsig);
+
+    // encode the number of argument tuples of a batch
+    if (args != NULL && batch_size > 0)
+    {
+        cbor_encode_text_stringz(&mapEncoder, "batch");
+        cbor_encode_int(&mapEncoder, batch_size);
+    }
 	
     // store and encode the args
     cbor_encode_text_stringz(&mapEncoder, "args");
@@ -175,37 +218,26 @@ command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_na
         cmdo->args = NULL;
         cbor_encoder_create_array(&mapEncoder, &arrayEncoder, 0);
     }
+    else if (batch_size > 0)
+    {
+        int arity = args[0].nargs / batch_size;
+        cmdo->args = take_args ? args : command_args_clone(args);
+        cmdo->batch_size = batch_size;
+        cbor_encoder_create_array(&mapEncoder, &arrayEncoder, batch_size);
+        for (int k = 0; k < batch_size; k++)
+        {
+            cbor_encoder_create_array(&arrayEncoder, &tupleEncoder, arity);
+            for (int i = 0; i < arity; i++)
+                _command_encode_arg(&tupleEncoder, &args[k * arity + i]);
+            cbor_encoder_close_container(&arrayEncoder, &tupleEncoder);
+        }
+    }
     else
     {
-        cmdo->args = command_args_clone(args);
+        cmdo->args = take_args ? args : command_args_clone(args);
         cbor_encoder_create_array(&mapEncoder, &arrayEncoder, args[0].nargs);
         for (int i = 0; i < args[0].nargs; i++)
-        {
-            switch (args[i].type)
-            {
-            case NVOID_TYPE:
-                nv = args[i].val.nval;
-                cbor_encode_byte_string(&arrayEncoder, nv->data, nv->len);
-                break;
-            case STRING_TYPE:
-                cbor_encode_text_stringz(&arrayEncoder, args[i].val.sval);
-                break;
-            case INT_TYPE:
-            case LONG_TYPE:
-                if (args[i].val.ival < 0)
-                    cbor_encode_negative_int(
-                        &arrayEncoder, abs(args[i].val.ival));
-                else
-                    cbor_encode_int(&arrayEncoder, args[i].val.ival);
-                break;
-            case DOUBLE_TYPE:
-                cbor_encode_double(&arrayEncoder, args[i].val.dval);
-                break;
-            case NULL_TYPE:
-                cbor_encode_null(&arrayEncoder);
-            default:;
-            }
-        }
+            _command_encode_arg(&arrayEncoder, &args[i]);
     }
     cbor_encoder_close_container(&mapEncoder, &arrayEncoder);
     cbor_encoder_close_container(&encoder, &mapEncoder);
@@ -217,6 +249,165 @@ command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_na
     return cmdo;
 }
 
+command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_name,
+                                 uint64_t taskid, const char* node_id,
+                                 const char* fn_argsig, arg_t* args)
+{
+    return _command_new(cmd, subcmd, fn_name, taskid, node_id, fn_argsig, args, 0, false);
+}
+
+command_t* command_new_taking_arg(jamcommand_t cmd, int subcmd, const char* fn_name,
+                                  uint64_t taskid, const char* node_id,
+                                  const char* fn_argsig, arg_t* args)
+{
+    return _command_new(cmd, subcmd, fn_name, taskid, node_id, fn_argsig, args, 0, true);
+}
+
+command_t* command_new_batch_using_arg(jamcommand_t cmd, int subcmd, const char* fn_name,
+                                       uint64_t taskid, const char* node_id,
+                                       const char* fn_argsig, arg_t* args, int batch_size)
+{
+    if (batch_size <= 0 || args == NULL || args[0].nargs % batch_size != 0)
+        return NULL;
+    return _command_new(cmd, subcmd, fn_name, taskid, node_id, fn_argsig, args, batch_size, false);
+}
+
+/*
+ * Decode a single scalar CBOR value into arg. Unsupported types leave arg untouched.
+ */
+static void _command_decode_arg(CborValue* it, arg_t* arg)
+{
+    size_t length;
+    int ival;
+    double dval;
+    float fval;
+    char strbuf[LARGE_CMD_STR_LEN];
+
+    switch (cbor_value_get_type(it))
+    {
+    case CborIntegerType:
+        arg->type = INT_TYPE;
+        cbor_value_get_int(it, &ival);
+        arg->val.ival = ival;
+        break;
+    case CborTextStringType:
+        arg->type = STRING_TYPE;
+        length    = LARGE_CMD_STR_LEN;
+        cbor_value_copy_text_string(it, strbuf, &length, NULL);
+        arg->val.sval = strdup(strbuf);
+        break;
+    case CborByteStringType:
+        arg->type = NVOID_TYPE;
+        length    = LARGE_CMD_STR_LEN;
+        cbor_value_copy_byte_string(it, (uint8_t*)strbuf, &length, NULL);
+        arg->val.nval = nvoid_new(strbuf, length);
+        break;
+    case CborFloatType:
+        arg->type = DOUBLE_TYPE;
+        cbor_value_get_float(it, &fval);
+        arg->val.dval = fval;
+        break;
+    case CborDoubleType:
+        arg->type = DOUBLE_TYPE;
+        cbor_value_get_double(it, &dval);
+        arg->val.dval = dval;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Decode an integer that may have been sent as a double (JavaScript numbers).
+ */
+static int64_t _command_decode_int64(CborValue* it)
+{
+    int64_t result = 0;
+    double dresult;
+
+    if (cbor_value_get_type(it) == CborDoubleType)
+    {
+        cbor_value_get_double(it, &dresult);
+        result = (int64_t)dresult;
+    }
+    else if (cbor_value_is_integer(it))
+        cbor_value_get_int64(it, &result);
+    return result;
+}
+
+/*
+ * Decode the "args" array of a command. With a "batch" field (batch > 0) the array
+ * holds batch argument tuples: they are flattened into cmd->args and cmd->batch_size
+ * is set to the number of tuples. Without one, it holds the arguments themselves.
+ */
+static void _command_decode_args(command_t* cmd, CborValue* map, int64_t batch)
+{
+    CborValue arr, tuple;
+    size_t nelems = 0;
+    size_t arity  = 0;
+    int i = 0;
+
+    cmd->args       = NULL;
+    cmd->batch_size = 0;
+    cbor_value_get_array_length(map, &nelems);
+    if (nelems == 0)
+        return;
+    cbor_value_enter_container(map, &arr);
+
+    if (batch <= 0)
+    {
+        if (cbor_value_get_type(&arr) == CborArrayType)
+        {
+            log_error("Argument tuples without a batch field");
+            return;
+        }
+        cmd->args = (arg_t*)calloc(nelems, sizeof(arg_t));
+        while (!cbor_value_at_end(&arr))
+        {
+            cmd->args[i].nargs = nelems;
+            _command_decode_arg(&arr, &cmd->args[i]);
+            i++;
+            cbor_value_advance(&arr);
+        }
+        return;
+    }
+
+    /* Batch: as many tuples as announced, all with the arity of the first one */
+    if ((int64_t) nelems != batch || cbor_value_get_type(&arr) != CborArrayType)
+    {
+        log_error("Malformed batch arguments");
+        return;
+    }
+    cbor_value_get_array_length(&arr, &arity);
+    if (arity == 0)
+        return;
+    size_t total = nelems * arity;
+    cmd->args = (arg_t*)calloc(total, sizeof(arg_t));
+    for (size_t j = 0; j < total; j++)
+        cmd->args[j].nargs = total;
+    while (!cbor_value_at_end(&arr))
+    {
+        size_t len = 0;
+        if (cbor_value_get_type(&arr) != CborArrayType ||
+            cbor_value_get_array_length(&arr, &len) != CborNoError || len != arity)
+        {
+            log_error("Malformed batch arguments");
+            command_args_free(cmd->args);
+            cmd->args = NULL;
+            return;
+        }
+        cbor_value_enter_container(&arr, &tuple);
+        while (!cbor_value_at_end(&tuple))
+        {
+            _command_decode_arg(&tuple, &cmd->args[i]);
+            i++;
+            cbor_value_advance(&tuple);
+        }
+        cbor_value_leave_container(&arr, &tuple);
+    }
+    cmd->batch_size = nelems;
+}
+
 /*
  * Command from CBOR data. If the fmt is non NULL, then we use
  * the specification in fmt to validate the parameter ordering.
@@ -225,15 +416,10 @@ command_t* command_new_using_arg(jamcommand_t cmd, int subcmd, const char* fn_na
 command_t* command_from_data(char* fmt, void* data, int len)
 {
     CborParser parser;
-    CborValue it, map, arr;
-    CborError err;
+    CborValue it, map, args_at;
+    bool has_args = false;
+    int64_t batch = 0;
     size_t length;
-    int i = 0;
-    int ival;
-    double dval;
-    float fval;
-    char bytebuf[LARGE_CMD_STR_LEN];
-    char strbuf[LARGE_CMD_STR_LEN];
     char keybuf[32];
     int result;
     double dresult;
@@ -298,57 +484,26 @@ command_t* command_from_data(char* fmt, void* data, int len)
         }
         else if (strcmp(keybuf, "args") == 0)
         {
-            cbor_value_enter_container(&map, &arr);
-            size_t nelems = 0;
-            cbor_value_get_array_length(&map, &nelems);
-            if (nelems > 0)
-            {
-                cmd->args = (arg_t*)calloc(nelems, sizeof(arg_t));
-                while (!cbor_value_at_end(&arr))
-                {
-                    CborType ty        = cbor_value_get_type(&arr);
-                    cmd->args[i].nargs = nelems;
-                    switch (ty)
-                    {
-                    case CborIntegerType:
-                        cmd->args[i].type = INT_TYPE;
-                        cbor_value_get_int(&arr, &ival);
-                        cmd->args[i].val.ival = ival;
-                        break;
-                    case CborTextStringType:
-                        cmd->args[i].type = STRING_TYPE;
-                        length            = LARGE_CMD_STR_LEN;
-                        cbor_value_copy_text_string(
-                            &arr, strbuf, &length, NULL);
-                        cmd->args[i].val.sval = strdup(strbuf);
-                        break;
-                    case CborByteStringType:
-                        cmd->args[i].type = NVOID_TYPE;
-                        cbor_value_copy_text_string(
-                            &arr, bytebuf, &length, NULL);
-                        cmd->args[i].val.nval = nvoid_new(bytebuf, length);
-                        break;
-                    case CborFloatType:
-                        cmd->args[i].type = DOUBLE_TYPE;
-                        cbor_value_get_float(&arr, &fval);
-                        cmd->args[i].val.dval = fval;
-                    case CborDoubleType:
-                        cmd->args[i].type = DOUBLE_TYPE;
-                        cbor_value_get_double(&arr, &dval);
-                        cmd->args[i].val.dval = dval;
-                        break;
-                    default:
-                        break;
-                    }
-                    i++;
-                    err = cbor_value_advance(&arr);
-                }
-            }
-            else
-                cmd->args = NULL;
+            // decoded once the batch field, which may come later, is known
+            args_at = map;
+            has_args = true;
+        }
+        else if (strcmp(keybuf, "batch") == 0)
+        {
+            batch = _command_decode_int64(&map);
+        }
+        else if (strcmp(keybuf, "deadline") == 0)
+        {
+            cmd->deadline_ms = _command_decode_int64(&map);
+        }
+        else if (strcmp(keybuf, "deadline_at") == 0)
+        {
+            cmd->deadline_at = _command_decode_int64(&map);
         }
         cbor_value_advance(&map);
     }
+    if (has_args)
+        _command_decode_args(cmd, &args_at, batch);
     cmd->refcount = 1;
     cmd->id = id++;
     return cmd;
@@ -357,15 +512,10 @@ command_t* command_from_data(char* fmt, void* data, int len)
 void command_from_data_inplace(command_t* cmd, const char* fn_argsig, int len)
 {
     CborParser parser;
-    CborValue it, map, arr;
-    CborError err;
+    CborValue it, map, args_at;
+    bool has_args = false;
+    int64_t batch = 0;
     size_t length;
-    int i = 0;
-    int ival;
-    double dval;
-    float fval;
-    char bytebuf[LARGE_CMD_STR_LEN];
-    char strbuf[LARGE_CMD_STR_LEN];
     char keybuf[32];
     int result;
     double dresult;
@@ -428,61 +578,75 @@ void command_from_data_inplace(command_t* cmd, const char* fn_argsig, int len)
         }
         else if (strcmp(keybuf, "args") == 0)
         {
-            cbor_value_enter_container(&map, &arr);
-            size_t nelems = 0;
-            cbor_value_get_array_length(&map, &nelems);
-            if (nelems > 0)
-            {
-                cmd->args = (arg_t*)calloc(nelems, sizeof(arg_t));
-                while (!cbor_value_at_end(&arr))
-                {
-                    CborType ty        = cbor_value_get_type(&arr);
-                    cmd->args[i].nargs = nelems;
-                    switch (ty)
-                    {
-                    case CborIntegerType:
-                        cmd->args[i].type = INT_TYPE;
-                        cbor_value_get_int(&arr, &ival);
-                        cmd->args[i].val.ival = ival;
-                        break;
-                    case CborTextStringType:
-                        cmd->args[i].type = STRING_TYPE;
-                        length            = LARGE_CMD_STR_LEN;
-                        cbor_value_copy_text_string(
-                            &arr, strbuf, &length, NULL);
-                        cmd->args[i].val.sval = strdup(strbuf);
-                        break;
-                    case CborByteStringType:
-                        cmd->args[i].type = NVOID_TYPE;
-                        cbor_value_copy_text_string(
-                            &arr, bytebuf, &length, NULL);
-                        cmd->args[i].val.nval = nvoid_new(bytebuf, length);
-                        break;
-                    case CborFloatType:
-                        cmd->args[i].type = DOUBLE_TYPE;
-                        cbor_value_get_float(&arr, &fval);
-                        cmd->args[i].val.dval = fval;
-                    case CborDoubleType:
-                        cmd->args[i].type = DOUBLE_TYPE;
-                        cbor_value_get_double(&arr, &dval);
-                        cmd->args[i].val.dval = dval;
-                        break;
-                    default:
-                        break;
-                    }
-                    i++;
-                    err = cbor_value_advance(&arr);
-                }
-            }
-            else
-                cmd->args = NULL;
+            // decoded once the batch field, which may come later, is known
+            args_at = map;
+            has_args = true;
+        }
+        else if (strcmp(keybuf, "batch") == 0)
+        {
+            batch = _command_decode_int64(&map);
+        }
+        else if (strcmp(keybuf, "deadline") == 0)
+        {
+            cmd->deadline_ms = _command_decode_int64(&map);
+        }
+        else if (strcmp(keybuf, "deadline_at") == 0)
+        {
+            cmd->deadline_at = _command_decode_int64(&map);
         }
         cbor_value_advance(&map);
     }
+    if (has_args)
+        _command_decode_args(cmd, &args_at, batch);
     cmd->refcount = 1;
     cmd->id = id++;
 }
 
+uint32_t command_node_hash(const char* node_id)
+{
+    if (node_id == NULL || node_id[0] == '\0')
+        return 0;
+    uint32_t hash = jam_name_hash(node_id);
+    // 0 is reserved for "every node"
+    return hash != 0 ? hash : 1;
+}
+
+void command_attachment_init(command_attachment_t* att, const command_t* cmd, const char* target_node_id, uint8_t priority)
+{
+    att->cmd = cmd->cmd;
+    att->priority = priority;
+    att->target = command_node_hash(target_node_id);
+    att->task_id = cmd->task_id;
+}
+
+size_t command_attachment_encode(const command_attachment_t* att, uint8_t* buffer)
+{
+    buffer[0] = COMMAND_ATTACHMENT_VERSION;
+    buffer[1] = (uint8_t)att->cmd;
+    buffer[2] = att->priority;
+    buffer[3] = 0;
+    for (int i = 0; i < 4; i++)
+        buffer[4 + i] = (uint8_t)(att->target >> (8 * i));
+    for (int i = 0; i < 8; i++)
+        buffer[8 + i] = (uint8_t)(att->task_id >> (8 * i));
+    return COMMAND_ATTACHMENT_LEN;
+}
+
+bool command_attachment_decode(const uint8_t* buffer, size_t len, command_attachment_t* att)
+{
+    if (buffer == NULL || len != COMMAND_ATTACHMENT_LEN || buffer[0] != COMMAND_ATTACHMENT_VERSION)
+        return false;
+    att->cmd = (jamcommand_t)buffer[1];
+    att->priority = buffer[2];
+    att->target = 0;
+    for (int i = 0; i < 4; i++)
+        att->target |= (uint32_t)buffer[4 + i] << (8 * i);
+    att->task_id = 0;
+    for (int i = 0; i < 8; i++)
+        att->task_id |= (uint64_t)buffer[8 + i] << (8 * i);
+    return true;
+}
+
 void command_hold(command_t* cmd)
 {
     cmd->refcount++;
@@ -695,7 +859,11 @@ const char* command_to_string(jamcommand_t cmd, char* output_str, size_t max_len
         case CMD_REXEC: str = "REXEC"; break;
         case CMD_REXEC_ACK: str = "REXEC_ACK"; break;
         case CMD_REXEC_RES: str = "REXEC_RES"; break;
+        case CMD_REXEC_ERR: str = "REXEC_ERR"; break;
         case CMD_GET_REXEC_RES: str = "GET_REXEC_RES"; break;
+        case CMD_REXEC_BATCH: str = "REXEC_BATCH"; break;
+        case CMD_REXEC_CANCEL: str = "REXEC_CANCEL"; break;
+        case CMD_GET_STATS: str = "GET_STATS"; break;
         default: str = "UNKNOWN_COMMAND"; break;
     }
 
@@ -0,0 +1,59 @@
+#include "completion.h"
+
+/* Bounded MPMC queue of D. Vyukov, specialized for a single consumer: every slot carries the position it is ready for,
+   so producers only contend on head and never wait for each other. */
+
+_Static_assert((COMPLETION_RING_SIZE & (COMPLETION_RING_SIZE - 1)) == 0, "COMPLETION_RING_SIZE must be a power of two");
+
+/* PUBLIC FUNCTIONS */
+void        completion_ring_init(completion_ring_t* ring) {
+    if (ring == NULL) return;
+    for (uint32_t i = 0; i < COMPLETION_RING_SIZE; i++) {
+        atomic_init(&ring->slots[i].seq, i);
+    }
+    atomic_init(&ring->head, 0);
+    ring->tail = 0;
+    atomic_init(&ring->overflows, 0);
+}
+
+
+bool        completion_ring_push(completion_ring_t* ring, const completion_event_t* event) {
+    if (ring == NULL || event == NULL) return false;
+    uint32_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (true) {
+        completion_slot_t* slot = &ring->slots[pos & (COMPLETION_RING_SIZE - 1)];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            /* The slot is free for this position, claim it */
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->event = *event;
+                atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+                return true;
+            }
+            /* pos was reloaded by the failed exchange */
+        } else if (diff < 0) {
+            /* The consumer has not read this slot yet: full */
+            atomic_fetch_add_explicit(&ring->overflows, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+
+bool        completion_ring_pop(completion_ring_t* ring, completion_event_t* event) {
+    if (ring == NULL || event == NULL) return false;
+    completion_slot_t* slot = &ring->slots[ring->tail & (COMPLETION_RING_SIZE - 1)];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if ((int32_t)(seq - (ring->tail + 1)) != 0) {
+        return false;
+    }
+    *event = slot->event;
+    /* Hand the slot back to the producers for the next lap */
+    atomic_store_explicit(&slot->seq, ring->tail + COMPLETION_RING_SIZE, memory_order_release);
+    ring->tail++;
+    return true;
+}
@@ -4,6 +4,8 @@
 #include "nvs_flash.h"
 #include "string.h"
 #include <sys/time.h>
+#include <errno.h>
+#include "sdkconfig.h"
 #include "utils.h"
 
 corestate_t* core_init(int serialnum) {
@@ -128,4 +130,65 @@ int discountflake(char *buffer){
     x = (uint32_t)tv_now.tv_sec * 65536 + (uint32_t)tv_now.tv_usec * 64; // first 16 bits seconds, 10 bits microseconds
     sprintf(buffer,"%li",(x+counter)); // Add in counter
     return errorCode; // Code -1: snowflake failed, Code 0: Successful
-}
\ No newline at end of file
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+/* Host builds have no flash, so every key is kept in its own small file */
+static void core_store_path(char* path, size_t size, const char* space, const char* key) {
+    snprintf(path, size, "%s/%s.%s", CORE_HOST_STORE_DIR, space, key);
+}
+
+bool core_store_get_blob(const char* space, const char* key, void* data, size_t* len) {
+    char path[64];
+    core_store_path(path, sizeof(path), space, key);
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return false;
+    size_t n = fread(data, 1, *len, f);
+    fclose(f);
+    *len = n;
+    return n > 0;
+}
+
+bool core_store_set_blob(const char* space, const char* key, const void* data, size_t len) {
+    char path[64];
+    core_store_path(path, sizeof(path), space, key);
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return false;
+    bool ok = fwrite(data, 1, len, f) == len;
+    fclose(f);
+    return ok;
+}
+
+bool core_store_erase(const char* space, const char* key) {
+    char path[64];
+    core_store_path(path, sizeof(path), space, key);
+    return remove(path) == 0 || errno == ENOENT;
+}
+#else
+bool core_store_get_blob(const char* space, const char* key, void* data, size_t* len) {
+    nvs_handle_t handle;
+    if (nvs_open(space, NVS_READONLY, &handle) != ESP_OK) return false;
+    esp_err_t err = nvs_get_blob(handle, key, data, len);
+    nvs_close(handle);
+    return err == ESP_OK;
+}
+
+bool core_store_set_blob(const char* space, const char* key, const void* data, size_t len) {
+    nvs_handle_t handle;
+    if (nvs_open(space, NVS_READWRITE, &handle) != ESP_OK) return false;
+    esp_err_t err = nvs_set_blob(handle, key, data, len);
+    if (err == ESP_OK) err = nvs_commit(handle);
+    nvs_close(handle);
+    return err == ESP_OK;
+}
+
+bool core_store_erase(const char* space, const char* key) {
+    nvs_handle_t handle;
+    if (nvs_open(space, NVS_READWRITE, &handle) != ESP_OK) return false;
+    esp_err_t err = nvs_erase_key(handle, key);
+    if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+    if (err == ESP_OK) err = nvs_commit(handle);
+    nvs_close(handle);
+    return err == ESP_OK;
+}
+#endif
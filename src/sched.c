@@ -0,0 +1,146 @@
+#include "sched.h"
+
+/* PRIVATE FUNCTIONS */
+static bool sched_entry_before(const sched_queue_t* queue, const sched_entry_t* a, const sched_entry_t* b) {
+    if (queue->policy == SCHED_POLICY_EDF && a->deadline != b->deadline) {
+        return a->deadline < b->deadline;
+    }
+    /* Sequence numbers wrap, compare them as a signed distance */
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void sched_swap(sched_entry_t* a, sched_entry_t* b) {
+    sched_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void sched_sift_up(sched_queue_t* queue, uint32_t i) {
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!sched_entry_before(queue, &queue->entries[i], &queue->entries[parent])) break;
+        sched_swap(&queue->entries[i], &queue->entries[parent]);
+        i = parent;
+    }
+}
+
+static void sched_sift_down(sched_queue_t* queue, uint32_t i) {
+    while (true) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t first = i;
+        if (left < queue->size && sched_entry_before(queue, &queue->entries[left], &queue->entries[first])) first = left;
+        if (right < queue->size && sched_entry_before(queue, &queue->entries[right], &queue->entries[first])) first = right;
+        if (first == i) break;
+        sched_swap(&queue->entries[i], &queue->entries[first]);
+        i = first;
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+void        sched_queue_init(sched_queue_t* queue, sched_policy_t policy) {
+    if (queue == NULL) return;
+    queue->size = 0;
+    queue->next_seq = 0;
+    queue->policy = policy;
+}
+
+
+bool        sched_queue_push(sched_queue_t* queue, void* item, uint64_t deadline) {
+    if (queue == NULL || queue->size >= SCHED_QUEUE_CAPACITY) return false;
+    sched_entry_t* entry = &queue->entries[queue->size];
+    entry->deadline = deadline;
+    entry->seq = queue->next_seq++;
+    entry->item = item;
+    sched_sift_up(queue, queue->size++);
+    return true;
+}
+
+
+const sched_entry_t* sched_queue_peek(const sched_queue_t* queue) {
+    if (queue == NULL || queue->size == 0) return NULL;
+    return &queue->entries[0];
+}
+
+
+bool        sched_queue_pop(sched_queue_t* queue, sched_entry_t* entry) {
+    if (queue == NULL || queue->size == 0) return false;
+    if (entry != NULL) *entry = queue->entries[0];
+    queue->entries[0] = queue->entries[--queue->size];
+    sched_sift_down(queue, 0);
+    return true;
+}
+
+
+bool        sched_queue_remove(sched_queue_t* queue, void* item) {
+    if (queue == NULL) return false;
+    for (uint32_t i = 0; i < queue->size; i++) {
+        if (queue->entries[i].item != item) continue;
+        queue->entries[i] = queue->entries[--queue->size];
+        if (i < queue->size) {
+            sched_sift_up(queue, i);
+            sched_sift_down(queue, i);
+        }
+        return true;
+    }
+    return false;
+}
+
+
+void        sched_dispatcher_init(sched_dispatcher_t* dispatcher, sched_policy_t policy, uint32_t max_running,
+                                  uint32_t max_deadline_running) {
+    if (dispatcher == NULL) return;
+    sched_queue_init(&dispatcher->deadline_queue, policy);
+    sched_queue_init(&dispatcher->fifo_queue, SCHED_POLICY_FIFO);
+    dispatcher->max_running = max_running;
+    dispatcher->max_deadline_running = max_deadline_running;
+    dispatcher->num_running = 0;
+    dispatcher->num_deadline_running = 0;
+}
+
+
+bool        sched_dispatcher_push(sched_dispatcher_t* dispatcher, void* item, uint64_t deadline) {
+    if (dispatcher == NULL) return false;
+    return sched_queue_push(deadline != SCHED_NO_DEADLINE ? &dispatcher->deadline_queue : &dispatcher->fifo_queue,
+                            item, deadline);
+}
+
+
+sched_dispatch_t sched_dispatcher_next(sched_dispatcher_t* dispatcher, uint64_t now, sched_entry_t* entry) {
+    if (dispatcher == NULL || entry == NULL || dispatcher->num_running >= dispatcher->max_running) {
+        return SCHED_DISPATCH_NONE;
+    }
+    if (dispatcher->num_deadline_running < dispatcher->max_deadline_running &&
+        sched_queue_pop(&dispatcher->deadline_queue, entry)) {
+        if (entry->deadline <= now) return SCHED_DISPATCH_EXPIRED;
+        dispatcher->num_running++;
+        dispatcher->num_deadline_running++;
+        return SCHED_DISPATCH_START;
+    }
+    if (sched_queue_pop(&dispatcher->fifo_queue, entry)) {
+        dispatcher->num_running++;
+        return SCHED_DISPATCH_START;
+    }
+    return SCHED_DISPATCH_NONE;
+}
+
+
+void        sched_dispatcher_done(sched_dispatcher_t* dispatcher, uint64_t deadline) {
+    if (dispatcher == NULL || dispatcher->num_running == 0) return;
+    dispatcher->num_running--;
+    if (deadline != SCHED_NO_DEADLINE && dispatcher->num_deadline_running > 0) {
+        dispatcher->num_deadline_running--;
+    }
+}
+
+
+bool        sched_dispatcher_remove(sched_dispatcher_t* dispatcher, void* item) {
+    if (dispatcher == NULL) return false;
+    return sched_queue_remove(&dispatcher->deadline_queue, item) || sched_queue_remove(&dispatcher->fifo_queue, item);
+}
+
+
+uint32_t    sched_dispatcher_queued(const sched_dispatcher_t* dispatcher) {
+    if (dispatcher == NULL) return 0;
+    return dispatcher->deadline_queue.size + dispatcher->fifo_queue.size;
+}
@@ -1,6 +1,12 @@
 #include "task.h"
 #include "utils.h"
+#define TASK_CO_LOCALS_WORDS(task) (((task)->co_locals_size + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
 /* PRIVATE FUNCTIONS */
+static  int32_t     clamp_to_int(int64_t value) {
+    return value > INT32_MAX ? INT32_MAX : (int32_t) value;
+}
+
 static  argtype_t    char_to_argtype(char c) {
     switch (c) {
         case 'n':
@@ -78,7 +84,7 @@ static  void    task_print_retval(arg_t* return_arg) {
 /* This is dumb code but the free macro doesn't know to remove (num_args) * sizeof(arg_t) from the count so we will lose track of the correct count
 if we just call free(instance->args) */
 static  void   task_instance_args_destroy(task_instance_t* instance) {
-    int num_args = instance->args->nargs;
+    int num_args = instance->args->nargs * (instance->batch_size > 0 ? instance->batch_size : 1);
     #ifdef MEMORY_DEBUG
     total_mem_usage -= (num_args-1) * sizeof(arg_t);
     #endif
@@ -86,8 +92,57 @@ static  void   task_instance_args_destroy(task_instance_t* instance) {
     instance->args = NULL;
 }
 
+/* Same issue as above for the result array of a batch invocation. String and nvoid results belong to the instance
+   (see execution_context_t.return_arg), the generated stubs store copies. */
+static  void   task_instance_return_arg_destroy(task_instance_t* instance) {
+    uint32_t results = instance->batch_size > 0 ? instance->batch_size : 1;
+    for (uint32_t k = 0; k < results; k++) {
+        arg_t* result = &instance->return_arg[k];
+        if (result->type == STRING_TYPE && result->val.sval != NULL) {
+            free(result->val.sval);
+        } else if (result->type == NVOID_TYPE && result->val.nval != NULL) {
+            nvoid_free(result->val.nval);
+        }
+    }
+    #ifdef MEMORY_DEBUG
+    if (instance->batch_size > 0) total_mem_usage -= (instance->batch_size-1) * sizeof(arg_t);
+    #endif
+    free(instance->return_arg);
+    instance->return_arg = NULL;
+}
+
+/* Same issue as above: the coroutine locals are allocated as an array of words */
+static  void   task_instance_co_locals_destroy(task_instance_t* instance) {
+    if (instance->ctx.co_locals == NULL) return;
+    #ifdef MEMORY_DEBUG
+    total_mem_usage -= (TASK_CO_LOCALS_WORDS(instance->parent_task) - 1) * sizeof(uint32_t);
+    #endif
+    free((uint32_t*) instance->ctx.co_locals);
+    instance->ctx.co_locals = NULL;
+}
+
+/* Same issue as above for the array of instance pointers */
+static  void   task_instances_array_destroy(task_t* task) {
+    #ifdef MEMORY_DEBUG
+    total_mem_usage -= (task->max_instances-1) * sizeof(task_instance_t*);
+    #endif
+    free(task->instances);
+    task->instances = NULL;
+}
+
 /* PUBLIC FUNCTIONS */
 task_t*     task_create(char* name, argtype_t return_type, char* fn_argsig, function_stub_t entry_point) {
+    /* The argsig is checked once here, stubs rely on it when they read their arguments */
+    if (name == NULL || fn_argsig == NULL || strlen(fn_argsig) > MAX_ARGS) {
+        log_error("Invalid task name or argsig");
+        return NULL;
+    }
+    for (int i = 0; fn_argsig[i] != '\0'; i++) {
+        if (char_to_argtype(fn_argsig[i]) == NULL_TYPE) {
+            log_error("Invalid type in argsig");
+            return NULL;
+        }
+    }
     /* Initialize task_t struct */
     task_t* task = calloc(1, sizeof(task_t));
     
@@ -97,24 +152,67 @@ task_t*     task_create(char* name, argtype_t return_type, char* fn_argsig, func
         return NULL;
     }
     task->name = name;
+    task->name_hash = jam_name_hash(name);
     task->return_type = return_type;
     task->fn_argsig = fn_argsig;
     task->entry_point = entry_point;
+    task->exec_mode = TASK_EXEC_THREAD;
+    task->co_locals_size = 0;
 
     /* Make sure all instances are set to NULL */
-    for (int i = 0; i < MAX_INSTANCES; i++) {
-        task->instances[i] = NULL;
+    task_instance_t** instances = calloc(MAX_INSTANCES, sizeof(task_instance_t*));
+    if (instances == NULL) {
+        printf("Could not allocate dynamically");
+        free(task);
+        return NULL;
     }
+    task->instances = instances;
+    task->max_instances = MAX_INSTANCES;
     task->num_instances = 0;
     return task;
 }
 
 
+task_t*     task_create_from_desc(const task_desc_t* desc) {
+    if (desc == NULL) return NULL;
+    /* The strings are never written through the task, they can stay in flash */
+    task_t* task = task_create((char*) desc->name, desc->return_type, (char*) desc->fn_argsig, desc->entry_point);
+    if (task == NULL) return NULL;
+    if (desc->exec_mode == TASK_EXEC_COROUTINE && !task_set_coroutine_mode(task, desc->co_locals_size)) {
+        task_destroy(task);
+        return NULL;
+    }
+    task_set_timeout(task, desc->timeout_ms);
+    return task;
+}
+
+
+bool        task_set_coroutine_mode(task_t* task, uint32_t locals_size) {
+    if (task == NULL) return false;
+    if (task->num_instances > 0) {
+        log_error("Cannot change the execution mode of a task with live instances");
+        return false;
+    }
+    /* Coroutine instances are cheap, so give the task room for more of them */
+    task_instance_t** instances = calloc(MAX_CO_INSTANCES, sizeof(task_instance_t*));
+    if (instances == NULL) {
+        log_error("Could not allocate dynamically");
+        return false;
+    }
+    task_instances_array_destroy(task);
+    task->instances = instances;
+    task->max_instances = MAX_CO_INSTANCES;
+    task->exec_mode = TASK_EXEC_COROUTINE;
+    task->co_locals_size = locals_size;
+    return true;
+}
+
+
 task_instance_t* task_instance_create(task_t* parent_task, uint32_t serial_id) {
     if (parent_task == NULL) return NULL;
 
     /* Check if the maximum number of instances allowable has been reached */
-    if (parent_task->num_instances >= MAX_INSTANCES) {
+    if (parent_task->num_instances >= parent_task->max_instances) {
         log_error("Maximum number of instances per task reached");
         return NULL;
     }
@@ -131,19 +229,39 @@ task_instance_t* task_instance_create(task_t* parent_task, uint32_t serial_id) {
     /* Create new instance of task using parent_task */
     instance->has_finished = false;
     instance->is_running = false;
+    atomic_init(&instance->state, TASK_INSTANCE_PENDING);
     instance->return_arg->type = parent_task->return_type;
     instance->return_arg->nargs = 1;
     instance->task_handle_frtos = NULL;
     instance->serial_id = serial_id;
     instance->parent_task = parent_task;
     instance->args = NULL;
+    instance->deadline_us = 0;
+    instance->release_us = 0;
+    instance->start_us = 0;
+    instance->timeout_at_us = 0;
+    instance->kill_at_us = 0;
+    instance->cancel_requested = false;
+    instance->ctx.cancelled = &instance->cancel_requested;
+    instance->error = REXEC_ERR_NONE;
+    if (parent_task->exec_mode == TASK_EXEC_COROUTINE && parent_task->co_locals_size > 0) {
+        uint32_t* co_locals = calloc(TASK_CO_LOCALS_WORDS(parent_task), sizeof(uint32_t));
+        if (co_locals == NULL) {
+            log_error("Could not allocate dynamically");
+            free(return_arg);
+            free(instance);
+            return NULL;
+        }
+        instance->ctx.co_locals = co_locals;
+    }
 
     /* Set this instance in parent_task, find first non null entry */
-    for (int i = 0; i < MAX_INSTANCES; i++) {
+    for (int i = 0; i < parent_task->max_instances; i++) {
         if (parent_task->instances[i] != NULL) {
             /* If instance is not null, check if the serial ID already exists */
             if (parent_task->instances[i]->serial_id == instance->serial_id) {
                 log_error("Task instance with same serial ID found when creating instance.");
+                task_instance_co_locals_destroy(instance);
                 free(return_arg);
                 free(instance);
                 return NULL;
@@ -162,25 +280,37 @@ task_instance_t* task_instance_create(task_t* parent_task, uint32_t serial_id) {
 void        task_destroy(task_t* task) {
     /* FREE ALL MEMBERS THAT ARE ALLOCATED USING MALLOC, CALLOC */
     if (task == NULL) return;
-    for (int i = 0; i < MAX_INSTANCES; i++) {
+    for (int i = 0; i < task->max_instances; i++) {
         if (task->instances[i] != NULL) task_instance_destroy(task->instances[i]);
     }
+    task_instances_array_destroy(task);
     free(task);
 }
 
 
 void        task_instance_destroy(task_instance_t* instance) {
     if (instance == NULL) return;
+    if (!instance->detached) {
+        task_instance_detach(instance);
+        if (!instance->detached) return;
+    }
+    if (instance->return_arg != NULL) {task_instance_return_arg_destroy(instance);}
+    if (instance->args != NULL) {task_instance_args_destroy(instance);}
+    task_instance_co_locals_destroy(instance);
+    free(instance);
+}
+
+
+void        task_instance_detach(task_instance_t* instance) {
+    if (instance == NULL || instance->detached) return;
     int i = task_get_instance_index(instance->parent_task, instance->serial_id);
     if (i == -1) {
-        log_error("Instance to destroy is not in parent task");
+        log_error("Instance to detach is not in parent task");
         return;
     }
     instance->parent_task->instances[i] = NULL;
     instance->parent_task->num_instances--; // decrement parent task's instance counter
-    if (instance->return_arg != NULL) {free(instance->return_arg);}
-    if (instance->args != NULL) {task_instance_args_destroy(instance);}
-    free(instance);
+    instance->detached = true;
 }
 
 
@@ -196,22 +326,50 @@ arg_t*      task_instance_get_return_args(task_instance_t* instance) {
 }
 
 
+arg_t*      task_instance_take_return_arg(task_instance_t* instance) {
+    if (instance == NULL) return NULL;
+    arg_t* return_arg = instance->return_arg;
+    instance->return_arg = NULL;
+    return return_arg;
+}
+
+
 void        task_instance_set_return_arg(task_instance_t* instance, arg_t* return_arg) {
-    if (instance == NULL || instance->return_arg == NULL) return;
+    if (instance == NULL || instance->return_arg == NULL || return_arg == NULL) return;
     /* Check that the return type matches */
     if (return_arg->type != instance->return_arg->type) {
        log_error("Return type does not match");
        return; 
     } 
-    instance->return_arg->type = return_arg->type;
-    instance->return_arg->val = return_arg->val;
+    /* The instance owns its string and nvoid results (see execution_context_t.return_arg): it keeps a copy, the
+       caller's value stays the caller's */
+    arg_t* result = instance->return_arg;
+    if (result->type == STRING_TYPE) {
+        char* sval = task_return_string(return_arg->val.sval);
+        if (return_arg->val.sval != NULL && sval == NULL) {
+            log_error("Could not copy the return value");
+            return;
+        }
+        if (result->val.sval != NULL) free(result->val.sval);
+        result->val.sval = sval;
+    } else if (result->type == NVOID_TYPE) {
+        nvoid_t* nval = task_return_nvoid(return_arg->val.nval);
+        if (return_arg->val.nval != NULL && nval == NULL) {
+            log_error("Could not copy the return value");
+            return;
+        }
+        if (result->val.nval != NULL) nvoid_free(result->val.nval);
+        result->val.nval = nval;
+    } else {
+        result->val = return_arg->val;
+    }
     return;
 }
 
 
 int    task_get_instance_index(task_t* task, uint32_t serial_id) {
     if (task == NULL) return -1;
-    for (int i = 0; i < MAX_INSTANCES; i++) {
+    for (int i = 0; i < task->max_instances; i++) {
         if (task->instances[i] != NULL && task->instances[i]->serial_id == serial_id) {
             return i;
         }
@@ -219,16 +377,35 @@ int    task_get_instance_index(task_t* task, uint32_t serial_id) {
     return -1;
 }
 
+char*       task_return_string(const char* value) {
+    if (value == NULL) return NULL;
+    size_t len = strlen(value) + 1;
+    char* copy = malloc(len);
+    if (copy == NULL) return NULL;
+    memcpy(copy, value, len);
+    return copy;
+}
+
+nvoid_t*    task_return_nvoid(const nvoid_t* value) {
+    if (value == NULL) return NULL;
+    return nvoid_new(value->data, value->len);
+}
+
 bool        task_instance_set_args(task_instance_t* instance, arg_t* args) {
     if (instance == NULL) return false;
-    /* If args == NULL assume that the task has no arguments */
+    /* args == NULL is only valid for a task without arguments: the stubs read fn_argsig arguments without checking */
     if (args == NULL) {
+        if (instance->parent_task->fn_argsig[0] != '\0') {
+            log_error("No arguments passed to task_set_args() for a task that takes some");
+            return false;
+        }
         instance->args = NULL;
         return true;
     }
 
+    /* Same bound as task_create(), so that every registered task can be invoked */
     int num_args = args[0].nargs;
-    if (strlen(instance->parent_task->fn_argsig) != num_args || num_args >= MAX_ARGS) {
+    if (strlen(instance->parent_task->fn_argsig) != num_args || num_args > MAX_ARGS) {
         log_error("Number of arguments passed to task_set_args() does not match fn_argsig length or is too large");
         return false;
     }
@@ -257,6 +434,48 @@ bool        task_instance_set_args(task_instance_t* instance, arg_t* args) {
     return true;
 }
 
+bool        task_instance_set_batch_args(task_instance_t* instance, arg_t* args, uint32_t batch_size) {
+    if (instance == NULL || args == NULL || instance->args != NULL) return false;
+
+    int arity = strlen(instance->parent_task->fn_argsig);
+    if (batch_size == 0 || batch_size > MAX_BATCH || arity == 0 || arity > MAX_ARGS ||
+        args[0].nargs != batch_size * arity) {
+        log_error("Batch arguments do not split into tuples matching fn_argsig");
+        return false;
+    }
+
+    for (int i = 0; i < batch_size * arity; i++) {
+        if (char_to_argtype(instance->parent_task->fn_argsig[i % arity]) != args[i].type) {
+            log_error("Incompatible type passed to task_instance_set_batch_args()");
+            return false;
+        }
+    }
+
+    arg_t* batch_args = calloc(batch_size * arity, sizeof(arg_t));
+    arg_t* results = calloc(batch_size, sizeof(arg_t));
+    if (batch_args == NULL || results == NULL) {
+        log_error("Could not allocate dynamically");
+        if (batch_args != NULL) {free(batch_args);}
+        if (results != NULL) {free(results);}
+        return false;
+    }
+
+    /* Each tuple looks like a normal argument array to the entry point */
+    for (int i = 0; i < batch_size * arity; i++) {
+        batch_args[i] = args[i];
+        batch_args[i].nargs = arity;
+    }
+    for (int k = 0; k < batch_size; k++) {
+        results[k].type = instance->parent_task->return_type;
+        results[k].nargs = batch_size;
+    }
+    free(instance->return_arg);
+    instance->batch_size = batch_size;
+    instance->args = batch_args;
+    instance->return_arg = results;
+    return true;
+}
+
 // void        task_set_args_va(task_t* task, int num_args, ...) {
 //     if (task == NULL) return;
 
@@ -283,6 +502,67 @@ bool        task_instance_set_args(task_instance_t* instance, arg_t* args) {
 
 
 
+void        task_set_timeout(task_t* task, uint32_t timeout_ms) {
+    if (task == NULL) return;
+    task->timeout_ms = timeout_ms;
+}
+
+
+void        task_set_wait_queue(task_t* task, uint32_t depth, uint32_t timeout_ms) {
+    if (task == NULL) return;
+    task->wait_depth = depth;
+    task->wait_timeout_ms = timeout_ms;
+}
+
+
+bool        task_accepts_single_arg(task_t* task, argtype_t type) {
+    if (task == NULL || strlen(task->fn_argsig) != 1) return false;
+    return char_to_argtype(task->fn_argsig[0]) == type;
+}
+
+
+void        task_record_stats(task_t* task, task_instance_t* instance) {
+    if (task == NULL || instance == NULL || instance->start_us == 0) return;
+    task_stats_t* stats = &task->stats;
+    int64_t wall_us = instance->end_us - instance->start_us;
+    int64_t wait_us = instance->queued_us != 0 ? instance->start_us - instance->queued_us : 0;
+    stats->runs++;
+    stats->total_wall_us += wall_us;
+    if (wall_us > stats->max_wall_us) stats->max_wall_us = wall_us;
+    stats->total_cpu_us += instance->cpu_us;
+    if (instance->cpu_us > stats->max_cpu_us) stats->max_cpu_us = instance->cpu_us;
+    stats->total_wait_us += wait_us;
+    if (wait_us > stats->max_wait_us) stats->max_wait_us = wait_us;
+    stats->total_heap_bytes += instance->heap_bytes;
+    if (instance->heap_bytes > stats->max_heap_bytes) stats->max_heap_bytes = instance->heap_bytes;
+}
+
+
+void        task_get_stats(task_t* task, task_stats_t* stats) {
+    if (task == NULL || stats == NULL) return;
+    *stats = task->stats;
+}
+
+
+void        task_stats_to_args(task_t* task, arg_t* values) {
+    task_stats_t stats;
+    task_get_stats(task, &stats);
+    int64_t runs = stats.runs > 0 ? stats.runs : 1;
+    int32_t ints[TASK_STATS_NUM_VALUES] = {
+        clamp_to_int(stats.runs),
+        clamp_to_int(stats.total_wall_us / runs), clamp_to_int(stats.max_wall_us),
+        clamp_to_int(stats.total_cpu_us / runs),
+        clamp_to_int(stats.total_wait_us / runs), clamp_to_int(stats.max_wait_us),
+        clamp_to_int((int64_t) (stats.total_heap_bytes / runs)), clamp_to_int(stats.max_heap_bytes),
+    };
+    for (int i = 0; i < TASK_STATS_NUM_VALUES; i++) {
+        values[i].nargs = TASK_STATS_NUM_VALUES;
+        values[i].type = INT_TYPE;
+        values[i].val.ival = ints[i];
+    }
+}
+
+
 void        task_print(task_t* task) {
     if (task == NULL) {
         log_error("Uninitialized task given to task_print() \r\n");
@@ -334,6 +614,18 @@ void        task_print(task_t* task) {
         printf("null \r\n");
         break;
     }
+    printf("max stack used:          %lu bytes (%lu samples)\r\n", task->max_stack_used, task->stack_samples);
+    printf("deadline drops / misses: %lu / %lu\r\n", task->deadline_drops, task->deadline_misses);
+    printf("timeout:                 %lu ms (%lu timeouts, %lu cancellations)\r\n", task->timeout_ms, task->timeouts, task->cancellations);
+    printf("wait queue:              %lu deep, %lu ms (%lu rejected)\r\n", task->wait_depth, task->wait_timeout_ms, task->wait_drops);
+    task_stats_t stats;
+    task_get_stats(task, &stats);
+    int64_t runs = stats.runs > 0 ? stats.runs : 1;
+    printf("runs:                    %lu\r\n", stats.runs);
+    printf("wall time avg / max:     %lld / %lld us\r\n", stats.total_wall_us / runs, stats.max_wall_us);
+    printf("cpu time avg / max:      %lld / %lld us\r\n", stats.total_cpu_us / runs, stats.max_cpu_us);
+    printf("queue wait avg / max:    %lld / %lld us\r\n", stats.total_wait_us / runs, stats.max_wait_us);
+    printf("heap alloc avg / max:    %llu / %lu bytes\r\n", stats.total_heap_bytes / runs, stats.max_heap_bytes);
     printf("number of instances:     %lu\r\n\r\n", task->num_instances);
 
     for (int i = 0; i < task->num_instances; i++) {
@@ -350,6 +642,14 @@ void        task_print(task_t* task) {
         } else {
             printf("has_finished:            false \r\n");
         }
+        if (instance->has_finished) {
+            printf("stack used:              %lu / %lu bytes\r\n", instance->stack_used, instance->stack_size);
+        }
+        if (instance->has_finished && instance->start_us != 0) {
+            printf("wall / cpu / wait:       %lld / %lu / %lld us\r\n", instance->end_us - instance->start_us,
+                   instance->cpu_us, instance->queued_us != 0 ? instance->start_us - instance->queued_us : 0);
+            printf("heap allocated:          %lu bytes\r\n", instance->heap_bytes);
+        }
         printf("arguments:               ");
         task_print_args(instance->args, strlen(instance->parent_task->fn_argsig));
         printf("\r\n");
@@ -1,38 +1,602 @@
 #include "tboard.h"
 #include "command.h"
+#include "core.h"
+#define TBOARD_WAITER_DONE ((TaskHandle_t) 1) // task_instance_t.waiter once the instance completed
 static tboard_t* _global_tboard; // NOTE: Temp fix to be able to update tboard correctly. Ideally there is a better solutiion.
 
+/* NVS keys are limited to 15 characters, so the task name is hashed */
+static void _tboard_stack_profile_key(task_t* task, char* key, size_t size) {
+    snprintf(key, size, "stk%08lx", (unsigned long) task->name_hash);
+}
+
+static void _tboard_load_stack_profile(task_t* task) {
+    char key[16];
+    uint32_t max_stack_used = 0;
+    size_t len = sizeof(max_stack_used);
+    _tboard_stack_profile_key(task, key, sizeof(key));
+    if (core_store_get_blob(TBOARD_NVS_NAMESPACE, key, &max_stack_used, &len) && len == sizeof(max_stack_used)) {
+        task->max_stack_used = max_stack_used;
+    }
+}
+
+/* Binary search of the registry, the table is sorted by name */
+static const task_desc_t* _tboard_find_desc(tboard_t* tboard, const char* name)
+{
+    uint32_t low = 0;
+    uint32_t high = tboard->registry_size;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const task_desc_t* desc = &tboard->registry[mid];
+        int cmp = strcmp(name, desc->name);
+        if (cmp == 0) {
+            return desc;
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/* Creates and registers the task_t of a registry function the first time it is used */
+static task_t* _tboard_materialize_desc(tboard_t* tboard, const task_desc_t* desc)
+{
+    task_t* task = NULL;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) {
+        return NULL;
+    }
+    /* Another task may have looked the function up in the meantime */
+    for (int i = 0; i < MAX_TASKS && task == NULL; i++) {
+        if (tboard->tasks[i] != NULL && tboard->tasks[i]->name_hash == desc->name_hash &&
+            strcmp(tboard->tasks[i]->name, desc->name) == 0) {
+            task = tboard->tasks[i];
+        }
+    }
+    if (task == NULL && tboard->num_tasks >= MAX_TASKS) {
+        log_error("Maximum number of tasks reached");
+    } else if (task == NULL) {
+        task = task_create_from_desc(desc);
+        if (task != NULL) {
+            tboard_register_task(tboard, task);
+        }
+    }
+    xSemaphoreGive(tboard->task_management_mutex);
+    return task;
+}
+
+/* Bookkeeping once an instance is over, whether it ran or not. It only touches atomics, so the scheduler, the coroutine
+   worker and the cancellation paths call it without extra locking; the caller is whoever took the instance out of the
+   ready queue, the coroutine table or the running slots. The finished state is published before the completion event,
+   so a consumer of the event always sees has_finished set. has_finished is the last access to the instance: its owner
+   may destroy it as soon as it sees the flag, so the event and the waiter handle are read before. */
+static void _tboard_instance_complete(tboard_t* tboard, task_instance_t* instance)
+{
+    task_t* task = instance->parent_task;
+    int64_t now = jam_time_us();
+    if (instance->start_us != 0) {
+        if (instance->end_us == 0) instance->end_us = now; // coroutine, or a thread instance that was deleted
+        task_record_stats(task, instance);
+    }
+    if (instance->stack_used > 0) {
+        task->stack_samples++;
+        uint32_t max_stack_used = atomic_load(&task->max_stack_used);
+        while (instance->stack_used > max_stack_used) {
+            if (atomic_compare_exchange_weak(&task->max_stack_used, &max_stack_used, instance->stack_used)) {
+                tboard->stack_profile_dirty = true;
+                break;
+            }
+        }
+    }
+    if (instance->error == REXEC_ERR_NONE && instance->deadline_us != 0 && now > instance->deadline_us) {
+        task->deadline_misses++;
+    }
+    atomic_store(&tboard->last_dead_task_id, instance->serial_id);
+    atomic_fetch_add(&tboard->num_dead_tasks, 1);
+
+    completion_event_t event = { .task = task, .serial_id = instance->serial_id, .error = instance->error };
+
+    /* Claim the task blocked in tboard_future_wait(), if any, while the instance is still guaranteed to exist */
+    TaskHandle_t waiter = atomic_exchange(&instance->waiter, TBOARD_WAITER_DONE);
+    instance->is_running = false;
+    atomic_store(&instance->state, TASK_INSTANCE_FINISHED);
+    instance->has_finished = true;
+    completion_ring_push(&tboard->completions, &event);
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+/* Bookkeeping of an instance that will not run */
+static void _tboard_instance_dropped(tboard_t* tboard, task_instance_t* instance, rexec_error_t error)
+{
+    if (error == REXEC_ERR_DEADLINE_EXPIRED) {
+        instance->parent_task->deadline_drops++;
+    } else if (error == REXEC_ERR_CANCELLED) {
+        instance->parent_task->cancellations++;
+    }
+    instance->error = error;
+    _tboard_instance_complete(tboard, instance);
+}
+
+#ifdef MEMORY_DEBUG
+/* Charges a tracked allocation to the instance running on the calling task, if any (see jam_alloc_hook) */
+static void _tboard_account_alloc(uint32_t bytes)
+{
+    task_instance_t* instance = (task_instance_t*) pvTaskGetThreadLocalStoragePointer(NULL, TLSTORE_TASK_PTR_IDX);
+    if (instance != NULL) {
+        instance->heap_bytes += bytes;
+    }
+}
+#endif
+
+/* Asks a started instance to stop. Must be called with task_management_mutex held. */
+static void _tboard_request_cancel_locked(task_instance_t* instance, rexec_error_t reason)
+{
+    if (instance->cancel_requested) return;
+    if (reason == REXEC_ERR_TIMEOUT) {
+        instance->parent_task->timeouts++;
+    } else {
+        instance->parent_task->cancellations++;
+    }
+    instance->error = reason;
+    instance->kill_at_us = jam_time_us() + (int64_t) TBOARD_CANCEL_GRACE_MS * 1000;
+    instance->cancel_requested = true;
+}
+
 void _task_freertos_entrypoint_wrapper(void* param)
 {
     
     task_instance_t* instance = (task_instance_t*) param;
     assert(instance != NULL);
     execution_context_t ctx;
-    ctx.query_args = instance->args;
-    ctx.return_arg = instance->return_arg;
 
     vTaskSetThreadLocalStoragePointer( NULL,  
                                        TLSTORE_TASK_PTR_IDX,     
                                        param );
 
     instance->is_running = true;
-    /* Call entry point here */
-    instance->parent_task->entry_point(&ctx);
-
-    assert(ctx.return_arg != NULL);
+    instance->start_us = jam_time_us();
+    uint32_t cpu_start = jam_task_cpu_ticks();
+    ctx.cancelled = &instance->cancel_requested;
+    /* A batch instance runs the entry point once per argument tuple, a normal one runs it once */
+    uint32_t runs = instance->batch_size > 0 ? instance->batch_size : 1;
+    uint32_t arity = strlen(instance->parent_task->fn_argsig);
+    for (uint32_t k = 0; k < runs && !instance->cancel_requested; k++) {
+        ctx.query_args = instance->args != NULL ? &instance->args[k * arity] : NULL;
+        ctx.return_arg = &instance->return_arg[k];
+        /* Call entry point here */
+        instance->parent_task->entry_point(&ctx);
+        assert(ctx.return_arg != NULL);
+    }
     /* Entry point has returned */
-    instance->has_finished = true;
+    instance->end_us = jam_time_us();
+    instance->cpu_us = jam_cpu_ticks_to_us(jam_task_cpu_ticks() - cpu_start);
+
+    /* Sample how much of its stack this instance needed (the high-water mark is the minimum free space seen) */
+    instance->stack_used = instance->stack_size - uxTaskGetStackHighWaterMark(NULL);
+
+    /* Hand the instance over to the scheduler without taking any lock, it gives the execution slot back and completes
+       the instance. The exchange only fails if the scheduler is deleting this task after an ignored cancellation. */
+    task_instance_state_t running = TASK_INSTANCE_RUNNING;
+    if (atomic_compare_exchange_strong(&instance->state, &running, TASK_INSTANCE_EXITED)) {
+        xTaskNotifyGive(_global_tboard->scheduler);
+        vTaskDelete(0);
+    }
+    vTaskSuspend(NULL);
+}
+
+static tboard_pipeline_t* _tboard_find_pipeline(tboard_t* tboard, task_t* task)
+{
+    for (int i = 0; i < TBOARD_MAX_PIPELINES; i++) {
+        if (tboard->pipelines[i].task == task) return &tboard->pipelines[i];
+    }
+    return NULL;
+}
+
+/* Frees the string or nvoid value of an intermediate pipeline result, owned by the pipeline once its stage returned */
+static void _tboard_pipeline_result_free(arg_t* result)
+{
+    if (result->type == STRING_TYPE && result->val.sval != NULL) {
+        free(result->val.sval);
+    } else if (result->type == NVOID_TYPE && result->val.nval != NULL) {
+        nvoid_free(result->val.nval);
+    }
+}
+
+/* Entry point of every pipeline task: runs the stages in the calling instance, the result of a stage becomes the
+   argument of the next one and the last stage writes the result of the instance. An intermediate result is freed once
+   the next stage consumed it. */
+static void _tboard_pipeline_entry_point(execution_context_t* ctx)
+{
+    task_instance_t* instance = (task_instance_t*) pvTaskGetThreadLocalStoragePointer(NULL, TLSTORE_TASK_PTR_IDX);
+    tboard_pipeline_t* pipeline = _tboard_find_pipeline(_global_tboard, instance->parent_task);
+    assert(pipeline != NULL);
+
+    arg_t results[2]; // a stage reads one while it writes the other
+    execution_context_t stage_ctx = *ctx;
+    for (uint32_t k = 0; k < pipeline->num_stages; k++) {
+        task_t* stage = pipeline->stages[k];
+        bool last = (k == pipeline->num_stages - 1);
+        arg_t* result = last ? ctx->return_arg : &results[k % 2];
+        if (!last) {
+            memset(result, 0, sizeof(arg_t));
+            result->nargs = 1;
+            result->type = stage->return_type;
+        }
+        stage_ctx.return_arg = result;
+        stage->entry_point(&stage_ctx);
+        if (k > 0) {
+            _tboard_pipeline_result_free(&results[(k - 1) % 2]);
+        }
+        stage_ctx.query_args = result;
+        if (!last && TASK_CANCELLED(ctx)) {
+            _tboard_pipeline_result_free(result);
+            return;
+        }
+    }
+}
+
+/* Removes a coroutine that is over from the worker and completes it */
+static void _tboard_coroutine_finished(tboard_t* tboard, int index, task_instance_t* instance)
+{
+    bool periodic = instance->release_us != 0; // read first, the instance may be reaped once it is complete
+    tboard->co_instances[index] = NULL;
+    _tboard_instance_complete(tboard, instance);
+    if (periodic) {
+        xTaskNotifyGive(tboard->scheduler);
+    }
+}
+
+/* Resumes every live coroutine instance once per round. Only this task removes entries from co_instances. */
+static void _tboard_coroutine_worker(void* param)
+{
+    tboard_t* tboard = (tboard_t*) param;
+    while (1) {
+        bool any_live = false;
+        TickType_t now = xTaskGetTickCount();
+        for (int i = 0; i < TBOARD_MAX_COROUTINES; i++) {
+            task_instance_t* instance = tboard->co_instances[i];
+            if (instance == NULL) continue;
+            any_live = true;
+            execution_context_t* ctx = &instance->ctx;
+            if (ctx->co_status == TASK_CO_WAITING && (int32_t)(ctx->co_wake_tick - now) > 0) continue;
+
+            /* A coroutine that has not started yet is dropped once its deadline has passed */
+            if (ctx->co_line == 0 && instance->deadline_us != 0 && instance->deadline_us <= jam_time_us()) {
+                tboard->co_instances[i] = NULL;
+                _tboard_instance_dropped(tboard, instance, REXEC_ERR_DEADLINE_EXPIRED);
+                continue;
+            }
+
+            /* Cancelled or timed out coroutines are not resumed again */
+            if (!instance->cancel_requested && instance->timeout_at_us != 0 && instance->timeout_at_us <= jam_time_us() &&
+                xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) == pdTRUE) {
+                _tboard_request_cancel_locked(instance, REXEC_ERR_TIMEOUT);
+                xSemaphoreGive(tboard->task_management_mutex);
+            }
+            if (instance->cancel_requested) {
+                _tboard_coroutine_finished(tboard, i, instance);
+                continue;
+            }
+
+            if (instance->start_us == 0) {
+                instance->start_us = jam_time_us();
+                if (instance->parent_task->timeout_ms > 0) {
+                    instance->timeout_at_us = instance->start_us + (int64_t) instance->parent_task->timeout_ms * 1000;
+                }
+            }
+            vTaskSetThreadLocalStoragePointer(NULL, TLSTORE_TASK_PTR_IDX, instance);
+            ctx->co_status = TASK_CO_DONE;
+            uint32_t cpu_start = jam_task_cpu_ticks();
+            instance->parent_task->entry_point(ctx);
+            instance->cpu_us += jam_cpu_ticks_to_us(jam_task_cpu_ticks() - cpu_start);
+            if (ctx->co_status != TASK_CO_DONE) continue;
+
+            /* Coroutine has returned for good */
+            _tboard_coroutine_finished(tboard, i, instance);
+        }
+        vTaskSetThreadLocalStoragePointer(NULL, TLSTORE_TASK_PTR_IDX, NULL);
+        if (any_live) {
+            vTaskDelay(1); // let lower priority tasks run between rounds
+        } else {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // sleep until tboard_start_task() hands over a new coroutine
+        }
+    }
+}
+
+/* The helpers ending in _locked must be called with task_management_mutex held */
+static void _tboard_scheduler(void* param);
+
+static bool _tboard_add_coroutine_locked(tboard_t* tboard, task_instance_t* instance)
+{
+    instance->ctx.query_args = instance->args;
+    instance->ctx.return_arg = instance->return_arg;
+    instance->ctx.co_line = 0;
+    instance->ctx.co_status = TASK_CO_YIELDED;
+    instance->stack_size = 0; // runs on the worker stack
+    instance->queued_us = jam_time_us();
+    instance->is_running = true;
+    atomic_store(&instance->state, TASK_INSTANCE_RUNNING);
+
+    if (tboard->co_worker == NULL) {
+        xTaskCreatePinnedToCore(_tboard_coroutine_worker, "tboard_co", TBOARD_CO_WORKER_STACK_SIZE,
+                                tboard, 1, &tboard->co_worker, TASK_DEFAULT_CORE);
+    }
+    for (int i = 0; i < TBOARD_MAX_COROUTINES; i++) {
+        if (tboard->co_instances[i] == NULL) {
+            tboard->co_instances[i] = instance;
+            return true;
+        }
+    }
+    log_error("Maximum number of live coroutines reached");
     instance->is_running = false;
-    if (ctx.return_arg->type != NULL_TYPE) instance->return_arg->val = ctx.return_arg->val;
+    atomic_store(&instance->state, TASK_INSTANCE_PENDING);
+    return false;
+}
+
+static void _tboard_ensure_scheduler_locked(tboard_t* tboard)
+{
+    if (tboard->scheduler == NULL) {
+        xTaskCreatePinnedToCore(_tboard_scheduler, "tboard_sched", TBOARD_SCHED_STACK_SIZE,
+                                tboard, TBOARD_SCHED_PRIORITY, &tboard->scheduler, TASK_DEFAULT_CORE);
+    }
+}
+
+/* Deadline of an instance in the time base of the dispatcher */
+static uint64_t _tboard_sched_deadline(const task_instance_t* instance)
+{
+    return instance->deadline_us != 0 ? (uint64_t) instance->deadline_us : SCHED_NO_DEADLINE;
+}
 
-    /* Need to use Mutex since we access shared data structure */
-    if(xSemaphoreTake(_global_tboard->task_management_mutex, MUTEX_WAIT) == pdTRUE) {
-        _global_tboard->last_dead_task_id = instance->serial_id;
-        _global_tboard->num_dead_tasks++;
-        xSemaphoreGive(_global_tboard->task_management_mutex);
+static bool _tboard_queue_instance_locked(tboard_t* tboard, task_instance_t* instance)
+{
+    _tboard_ensure_scheduler_locked(tboard);
+    instance->queued_us = jam_time_us();
+    if (!sched_dispatcher_push(&tboard->dispatcher, instance, _tboard_sched_deadline(instance))) {
+        log_error("Could not queue instance, ready queue is full");
+        return false;
+    }
+    return true;
+}
+
+/* Hands a new instance over to the coroutine worker or to the ready queue of the scheduler */
+static bool _tboard_submit(tboard_t* tboard, task_instance_t* instance)
+{
+    bool submitted = false;
+    bool coroutine = instance->parent_task->exec_mode == TASK_EXEC_COROUTINE;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) == pdTRUE) {
+        submitted = coroutine ? _tboard_add_coroutine_locked(tboard, instance)
+                              : _tboard_queue_instance_locked(tboard, instance);
+        xSemaphoreGive(tboard->task_management_mutex);
+    }
+    if (!submitted) return false;
+    xTaskNotifyGive(coroutine ? tboard->co_worker : tboard->scheduler);
+    return true;
+}
+
+
+/* Creates the FreeRTOS task of a thread instance the dispatcher gave a slot to and puts it in tboard->running. Must be
+   called with task_management_mutex held. */
+static void _tboard_start_thread_locked(tboard_t* tboard, task_instance_t* instance, int64_t now)
+{
+    task_t* task = instance->parent_task;
+    instance->stack_size = tboard_get_task_stack_size(tboard, task);
+    atomic_store(&instance->state, TASK_INSTANCE_RUNNING);
+    if (xTaskCreatePinnedToCore(_task_freertos_entrypoint_wrapper,
+                                task->name,
+                                instance->stack_size,
+                                instance,
+                                1,
+                                &instance->task_handle_frtos,
+                                TASK_DEFAULT_CORE) != pdPASS) {
+        sched_dispatcher_done(&tboard->dispatcher, _tboard_sched_deadline(instance));
+        _tboard_instance_dropped(tboard, instance, REXEC_ERR_FAILED);
+        return;
+    }
+    if (task->timeout_ms > 0) {
+        instance->timeout_at_us = now + (int64_t) task->timeout_ms * 1000;
+    }
+    for (int i = 0; i < TBOARD_MAX_THREADS; i++) {
+        if (tboard->running[i] == NULL) {
+            tboard->running[i] = instance;
+            break;
+        }
+    }
+}
+
+/* Starts queued instances while execution slots are free: the ones with a deadline earliest deadline first (at most
+   TBOARD_MAX_RUNNING of them), then the others in arrival order. Expired instances are dropped. The decisions are the
+   dispatcher's (sched.c), tests/tboard/tboard_sim_test.c plays traces against the same code on a virtual clock. */
+static void _tboard_dispatch(tboard_t* tboard)
+{
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) {
+        xTaskNotifyGive(tboard->scheduler); // try again on the next pass
+        return;
+    }
+    sched_entry_t entry;
+    sched_dispatch_t decision;
+    int64_t now = jam_time_us();
+    while ((decision = sched_dispatcher_next(&tboard->dispatcher, (uint64_t) now, &entry)) != SCHED_DISPATCH_NONE) {
+        task_instance_t* instance = (task_instance_t*) entry.item;
+        if (decision == SCHED_DISPATCH_EXPIRED) {
+            _tboard_instance_dropped(tboard, instance, REXEC_ERR_DEADLINE_EXPIRED);
+        } else {
+            _tboard_start_thread_locked(tboard, instance, now);
+        }
+    }
+    xSemaphoreGive(tboard->task_management_mutex);
+}
+
+/* Ticks the scheduler sleeps for an event wait_us ahead. A wait shorter than a tick rounds to 0 with pdMS_TO_TICKS, which
+   would spin the scheduler until the event: it sleeps at least one tick instead. */
+static TickType_t _tboard_wait_ticks(int64_t wait_us)
+{
+    if (wait_us <= 0) return 0;
+    TickType_t ticks = pdMS_TO_TICKS((wait_us + 999) / 1000);
+    return ticks > 0 ? ticks : 1;
+}
+
+/* Gives the execution slots of returned instances back, cancels the running thread instances that exceeded their
+   timeout and deletes the cancelled ones that did not return within the grace period. Returns how long the scheduler
+   can sleep until the next of these events. */
+static TickType_t _tboard_check_running(tboard_t* tboard)
+{
+    int64_t next_event = INT64_MAX;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) {
+        return 1; // try again on the next tick
+    }
+    int64_t now = jam_time_us();
+    for (int i = 0; i < TBOARD_MAX_THREADS; i++) {
+        task_instance_t* instance = tboard->running[i];
+        if (instance == NULL) continue;
+        bool over = atomic_load(&instance->state) == TASK_INSTANCE_EXITED;
+        if (!over && !instance->cancel_requested && instance->timeout_at_us != 0 && instance->timeout_at_us <= now) {
+            _tboard_request_cancel_locked(instance, REXEC_ERR_TIMEOUT);
+        }
+        if (!over && instance->cancel_requested && instance->kill_at_us <= now) {
+            /* Last resort: the stub ignored the cancellation, reclaim its stack and slot. Losing the exchange means
+               that the instance returned in the meantime. */
+            task_instance_state_t running = TASK_INSTANCE_RUNNING;
+            if (atomic_compare_exchange_strong(&instance->state, &running, TASK_INSTANCE_KILLED)) {
+                vTaskDelete(instance->task_handle_frtos);
+                instance->task_handle_frtos = NULL;
+            }
+            over = true;
+        }
+        if (over) {
+            tboard->running[i] = NULL;
+            sched_dispatcher_done(&tboard->dispatcher, _tboard_sched_deadline(instance));
+            _tboard_instance_complete(tboard, instance);
+            continue;
+        }
+        int64_t event = instance->cancel_requested ? instance->kill_at_us : instance->timeout_at_us;
+        if (event != 0 && event < next_event) {
+            next_event = event;
+        }
+    }
+    xSemaphoreGive(tboard->task_management_mutex);
+
+    if (next_event == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    int64_t wait_us = next_event - jam_time_us();
+    return _tboard_wait_ticks(wait_us);
+}
+
+/* Records the statistics of the last release of a periodic task and frees its instance */
+static void _tboard_periodic_reap_locked(tboard_periodic_t* periodic)
+{
+    task_instance_t* instance = periodic->current;
+    if (instance->error == REXEC_ERR_NONE) {
+        int64_t jitter = instance->start_us - instance->release_us;
+        periodic->completions++;
+        periodic->total_jitter_us += jitter;
+        if (jitter > periodic->max_jitter_us) periodic->max_jitter_us = jitter;
+        if (jitter > periodic->jitter_budget_us) periodic->jitter_violations++;
+    }
+    task_instance_destroy(instance);
+    periodic->current = NULL;
+}
+
+static uint32_t _tboard_next_internal_serial_locked(tboard_t* tboard)
+{
+    return TBOARD_INTERNAL_SERIAL_BASE | (tboard->internal_serials++ & ~TBOARD_INTERNAL_SERIAL_BASE);
+}
+
+static void _tboard_periodic_release_locked(tboard_t* tboard, tboard_periodic_t* periodic, int64_t now, bool* wake_co_worker)
+{
+    /* Periods that went by entirely while the scheduler could not run are skipped */
+    while (periodic->next_release_us + periodic->period_us <= now) {
+        periodic->next_release_us += periodic->period_us;
+        periodic->overruns++;
+    }
+    int64_t release = periodic->next_release_us;
+    periodic->next_release_us += periodic->period_us;
+
+    /* The previous release is still queued or running */
+    if (periodic->current != NULL) {
+        periodic->overruns++;
+        return;
+    }
+
+    task_instance_t* instance = task_instance_create(periodic->task, _tboard_next_internal_serial_locked(tboard));
+    if (instance == NULL) {
+        periodic->overruns++;
+        return;
+    }
+    if (!task_instance_set_args(instance, periodic->args)) {
+        task_instance_destroy(instance);
+        periodic->overruns++;
+        return;
+    }
+    instance->release_us = release;
+    instance->deadline_us = release + periodic->period_us; // implicit deadline: the next release
+
+    bool coroutine = periodic->task->exec_mode == TASK_EXEC_COROUTINE;
+    bool submitted = coroutine ? _tboard_add_coroutine_locked(tboard, instance)
+                               : _tboard_queue_instance_locked(tboard, instance);
+    if (!submitted) {
+        task_instance_destroy(instance);
+        periodic->overruns++;
+        return;
+    }
+    if (coroutine) *wake_co_worker = true;
+    periodic->current = instance;
+    periodic->releases++;
+}
+
+/* Releases the periodic instances that are due and returns how long the scheduler can sleep until the next release */
+static TickType_t _tboard_release_periodics(tboard_t* tboard)
+{
+    bool wake_co_worker = false;
+    int64_t next_release = INT64_MAX;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) {
+        return 1; // try again on the next tick
+    }
+    int64_t now = jam_time_us();
+    for (int i = 0; i < TBOARD_MAX_PERIODIC; i++) {
+        tboard_periodic_t* periodic = &tboard->periodics[i];
+        if (periodic->current != NULL && periodic->current->has_finished) {
+            _tboard_periodic_reap_locked(periodic);
+        }
+        if (periodic->task == NULL) continue;
+        if (periodic->next_release_us <= now) {
+            _tboard_periodic_release_locked(tboard, periodic, now, &wake_co_worker);
+        }
+        if (periodic->next_release_us < next_release) {
+            next_release = periodic->next_release_us;
+        }
+    }
+    xSemaphoreGive(tboard->task_management_mutex);
+
+    if (wake_co_worker) {
+        xTaskNotifyGive(tboard->co_worker);
+    }
+    if (next_release == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    int64_t wait_us = next_release - jam_time_us();
+    return _tboard_wait_ticks(wait_us);
+}
+
+/* Woken up whenever an instance is queued, completes or is cancelled, at every periodic release and when a running
+   instance times out */
+static void _tboard_scheduler(void* param)
+{
+    tboard_t* tboard = (tboard_t*) param;
+    TickType_t wait = 0;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        _tboard_check_running(tboard); // frees the slots of the instances that returned
+        wait = _tboard_release_periodics(tboard);
+        _tboard_dispatch(tboard);
+        TickType_t running_wait = _tboard_check_running(tboard); // arms the timeouts of the dispatched instances
+        if (running_wait < wait) {
+            wait = running_wait;
+        }
     }
-    // TODO: should be some way to signal if the semaphore is not taken in time without printing (printing will cause stack to be used excessively)
-    vTaskDelete(0);
 }
 
 
@@ -48,6 +612,21 @@ tboard_t*   tboard_create() {
     for (int i = 0; i < MAX_TASKS; i++) {
         tboard->tasks[i] = NULL;
     }
+    for (int i = 0; i < TBOARD_MAX_COROUTINES; i++) {
+        tboard->co_instances[i] = NULL;
+    }
+    tboard->co_worker = NULL; // created when the first coroutine is started
+    tboard->scheduler = NULL; // created when the first instance is queued
+    sched_dispatcher_init(&tboard->dispatcher, SCHED_POLICY_EDF, TBOARD_MAX_THREADS, TBOARD_MAX_RUNNING);
+    for (int i = 0; i < TBOARD_MAX_THREADS; i++) {
+        tboard->running[i] = NULL;
+    }
+    memset(tboard->periodics, 0, sizeof(tboard->periodics));
+    memset(tboard->pipelines, 0, sizeof(tboard->pipelines));
+    tboard->internal_serials = 0;
+    completion_ring_init(&tboard->completions);
+    tboard->registry = NULL;
+    tboard->registry_size = 0;
 
     //implement the semaphores
     tboard->task_management_mutex = xSemaphoreCreateMutexStatic(&tboard->task_management_mutex_data);
@@ -56,8 +635,13 @@ tboard_t*   tboard_create() {
     tboard->num_tasks = 0;
     tboard->num_dead_tasks = 0;
     tboard->last_dead_task_id = 0;
+    tboard->adaptive_stack = false;
+    tboard->stack_profile_dirty = false;
     // NOTE: This is a temporary solution in order to be able to update the tboard
     _global_tboard = tboard;
+#ifdef MEMORY_DEBUG
+    jam_alloc_hook = _tboard_account_alloc;
+#endif
     return tboard;
 }
 
@@ -67,6 +651,21 @@ void        tboard_destroy(tboard_t* tboard) {
         return;
     }
 
+    /* Make sure no instance is still executing before its memory goes away */
+    tboard_shutdown(tboard);
+#ifdef MEMORY_DEBUG
+    if (jam_alloc_hook == _tboard_account_alloc) {
+        jam_alloc_hook = NULL;
+    }
+#endif
+
+    if (tboard->co_worker != NULL) {
+        vTaskDelete(tboard->co_worker);
+    }
+    if (tboard->scheduler != NULL) {
+        vTaskDelete(tboard->scheduler);
+    }
+
     //Free memory of all tasks 
     for (int i=0; i<MAX_TASKS; i++){
         if (tboard->tasks[i] != NULL){
@@ -78,6 +677,27 @@ void        tboard_destroy(tboard_t* tboard) {
 }
 
 
+bool        tboard_set_registry(tboard_t* tboard, const task_desc_t* table, uint32_t size) {
+    if (tboard == NULL || (table == NULL && size > 0)) {
+        log_error("Invalid task registry");
+        return false;
+    }
+#ifdef DEBUG
+    /* Lookups are binary searches over the names, and argsigs can only be checked character by character here */
+    for (uint32_t i = 0; i < size; i++) {
+        if ((i > 0 && strcmp(table[i - 1].name, table[i].name) >= 0) ||
+            strspn(table[i].fn_argsig, "nsif") != strlen(table[i].fn_argsig)) {
+            log_error("Task registry is not sorted by name or has an invalid argsig");
+            return false;
+        }
+    }
+#endif
+    tboard->registry = table;
+    tboard->registry_size = size;
+    return true;
+}
+
+
 void        tboard_register_task(tboard_t* tboard, task_t* task) {
 
     if (tboard == NULL || task == NULL){
@@ -101,16 +721,24 @@ void        tboard_register_task(tboard_t* tboard, task_t* task) {
         }
     }
 
+    // pick up the stack usage learned during previous boots
+    _tboard_load_stack_profile(task);
+
     // Update tboard parameters
     tboard->num_tasks++;
     return;
 }
 
-task_instance_t*    tboard_start_task(tboard_t* tboard, char* name, int task_serial_id, arg_t* args) {
-    if (tboard == NULL) {
-        return NULL;
+/* Starts an instance with any serial id, including the ones from TBOARD_INTERNAL_SERIAL_BASE up */
+static task_instance_t* _tboard_start_instance(tboard_t* tboard, char* name, uint32_t task_serial_id, arg_t* args,
+                                               const tboard_start_options_t* opts) {
+    tboard_start_options_t defaults;
+    if (opts == NULL) {
+        tboard_start_options_default(&defaults);
+        opts = &defaults;
     }
-    /* Find target task by name */
+    /* Find target task by name. Only pipelines registered locally run: a chain named by a remote peer is not
+       registered on the fly, it could fill the pipeline and task tables. */
     task_t* task_target = tboard_find_task_name(tboard, name);
 
     if (task_target == NULL) {
@@ -122,20 +750,375 @@ task_instance_t*    tboard_start_task(tboard_t* tboard, char* name, int task_ser
     if (task_target_inst == NULL) return NULL;
     
     /* Try to set arguments for this instance */
-    if (!task_instance_set_args(task_target_inst, args)) return NULL;
-
-    /* Create task using FreeRTOS */
-    xTaskCreatePinnedToCore(_task_freertos_entrypoint_wrapper, 
-                            task_target->name, 
-                            TASK_STACK_SIZE, 
-                            task_target_inst, 
-                            1,
-                            &task_target_inst->task_handle_frtos, 
-                            TASK_DEFAULT_CORE);
+    bool args_set = (opts->batch_size > 0) ? task_instance_set_batch_args(task_target_inst, args, opts->batch_size)
+                                           : task_instance_set_args(task_target_inst, args);
+    if (!args_set) {
+        task_instance_destroy(task_target_inst);
+        return NULL;
+    }
+    task_target_inst->deadline_us = opts->deadline_us;
+
+    if (task_target->exec_mode == TASK_EXEC_COROUTINE && opts->batch_size > 0) {
+        log_error("Batch invocation of a coroutine task is not supported");
+        task_instance_destroy(task_target_inst);
+        return NULL;
+    }
+
+    /* Coroutines are multiplexed onto the coroutine worker, thread instances get their FreeRTOS task
+       from the scheduler once an execution slot is free */
+    if (!_tboard_submit(tboard, task_target_inst)) {
+        task_instance_destroy(task_target_inst);
+        return NULL;
+    }
     return task_target_inst;
 }
 
 
+task_instance_t*    tboard_start_task_opts(tboard_t* tboard, char* name, int task_serial_id, arg_t* args,
+                                           const tboard_start_options_t* opts) {
+    if (tboard == NULL) {
+        return NULL;
+    }
+    if ((uint32_t) task_serial_id >= TBOARD_INTERNAL_SERIAL_BASE) {
+        log_error("Serial id reserved for the instances of the tboard");
+        return NULL;
+    }
+    return _tboard_start_instance(tboard, name, (uint32_t) task_serial_id, args, opts);
+}
+
+
+task_instance_t*    tboard_start_task(tboard_t* tboard, char* name, int task_serial_id, arg_t* args) {
+    return tboard_start_task_opts(tboard, name, task_serial_id, args, NULL);
+}
+
+
+task_instance_t*    tboard_start_batch_task(tboard_t* tboard, char* name, int task_serial_id, arg_t* args, uint32_t batch_size) {
+    if (batch_size == 0) {
+        log_error("Empty batch");
+        return NULL;
+    }
+    tboard_start_options_t opts;
+    tboard_start_options_default(&opts);
+    opts.batch_size = batch_size;
+    return tboard_start_task_opts(tboard, name, task_serial_id, args, &opts);
+}
+
+
+void        tboard_start_options_default(tboard_start_options_t* opts) {
+    if (opts == NULL) return;
+    opts->batch_size = 0;
+    opts->deadline_us = 0;
+}
+
+
+task_t*     tboard_register_pipeline(tboard_t* tboard, const char* name, const char* chain) {
+    if (tboard == NULL || name == NULL || chain == NULL || strlen(name) >= SMALL_CMD_STR_LEN) {
+        log_error("Invalid pipeline registration");
+        return NULL;
+    }
+    if (tboard_find_task_name(tboard, (char*) name) != NULL || tboard->num_tasks >= MAX_TASKS) {
+        log_error("Duplicate pipeline name or maximum number of tasks reached");
+        return NULL;
+    }
+    tboard_pipeline_t* pipeline = NULL;
+    for (int i = 0; i < TBOARD_MAX_PIPELINES; i++) {
+        if (tboard->pipelines[i].task == NULL) {
+            pipeline = &tboard->pipelines[i];
+            break;
+        }
+    }
+    if (pipeline == NULL) {
+        log_error("Maximum number of pipelines reached");
+        return NULL;
+    }
+
+    /* Resolve the stages and check that every result can be passed to the next stage */
+    uint32_t num_stages = 0;
+    const char* stage_name = chain;
+    while (true) {
+        const char* end = strchr(stage_name, TBOARD_PIPELINE_SEPARATOR);
+        size_t len = (end != NULL) ? (size_t)(end - stage_name) : strlen(stage_name);
+        char buf[SMALL_CMD_STR_LEN];
+        if (len == 0 || len >= SMALL_CMD_STR_LEN || num_stages == TBOARD_MAX_PIPELINE_STAGES) {
+            log_error("Malformed pipeline chain");
+            return NULL;
+        }
+        memcpy(buf, stage_name, len);
+        buf[len] = '\0';
+        task_t* stage = tboard_find_task_name(tboard, buf);
+        /* A pipeline stage would run its own stages from the entry point, without any bound on the nesting */
+        if (stage == NULL || stage->exec_mode != TASK_EXEC_THREAD || _tboard_find_pipeline(tboard, stage) != NULL) {
+            log_error("Unknown, coroutine or nested pipeline stage");
+            return NULL;
+        }
+        if (num_stages > 0 && !task_accepts_single_arg(stage, pipeline->stages[num_stages - 1]->return_type)) {
+            log_error("Pipeline stage does not take the result of the previous stage");
+            return NULL;
+        }
+        pipeline->stages[num_stages++] = stage;
+        if (end == NULL) break;
+        stage_name = end + 1;
+    }
+
+    /* The pipeline is a task of its own, with the signature of the first stage and the result of the last one */
+    strcpy(pipeline->name, name);
+    task_t* task = task_create(pipeline->name, pipeline->stages[num_stages - 1]->return_type,
+                               pipeline->stages[0]->fn_argsig, _tboard_pipeline_entry_point);
+    if (task == NULL) return NULL;
+    tboard_register_task(tboard, task);
+    pipeline->num_stages = num_stages;
+    pipeline->task = task;
+    return task;
+}
+
+
+bool        tboard_register_periodic(tboard_t* tboard, char* name, arg_t* args,
+                                     uint32_t period_ms, uint32_t phase_ms, uint32_t jitter_budget_ms) {
+    if (tboard == NULL || name == NULL || period_ms == 0) {
+        log_error("Invalid periodic registration");
+        return false;
+    }
+    task_t* task = tboard_find_task_name(tboard, name);
+    if (task == NULL) {
+        log_error("Could not find task name");
+        return false;
+    }
+    int num_args = (args == NULL) ? 0 : args[0].nargs;
+    if (num_args != strlen(task->fn_argsig)) {
+        log_error("Number of periodic arguments does not match fn_argsig length");
+        return false;
+    }
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) {
+        return false;
+    }
+    tboard_periodic_t* slot = NULL;
+    for (int i = 0; i < TBOARD_MAX_PERIODIC; i++) {
+        tboard_periodic_t* periodic = &tboard->periodics[i];
+        if (periodic->task == task) {
+            log_error("Task is already periodic");
+            xSemaphoreGive(tboard->task_management_mutex);
+            return false;
+        }
+        /* A slot is reusable once the last instance of an unregistered periodic task has been reaped */
+        if (slot == NULL && periodic->task == NULL && periodic->current == NULL) {
+            slot = periodic;
+        }
+    }
+    if (slot == NULL) {
+        log_error("Maximum number of periodic tasks reached");
+        xSemaphoreGive(tboard->task_management_mutex);
+        return false;
+    }
+    memset(slot, 0, sizeof(tboard_periodic_t));
+    slot->task = task;
+    slot->args = args;
+    slot->period_us = (int64_t) period_ms * 1000;
+    slot->jitter_budget_us = (int64_t) jitter_budget_ms * 1000;
+    slot->next_release_us = jam_time_us() + (int64_t) phase_ms * 1000;
+    _tboard_ensure_scheduler_locked(tboard);
+    xSemaphoreGive(tboard->task_management_mutex);
+
+    /* The scheduler recomputes its timeout */
+    xTaskNotifyGive(tboard->scheduler);
+    return true;
+}
+
+
+bool        tboard_unregister_periodic(tboard_t* tboard, char* name) {
+    tboard_periodic_t* periodic = tboard_find_periodic(tboard, name);
+    if (periodic == NULL) return false;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) {
+        return false;
+    }
+    /* An instance still in flight is reaped by the scheduler once it has finished */
+    periodic->task = NULL;
+    xSemaphoreGive(tboard->task_management_mutex);
+    xTaskNotifyGive(tboard->scheduler);
+    return true;
+}
+
+
+tboard_periodic_t*  tboard_find_periodic(tboard_t* tboard, char* name) {
+    if (tboard == NULL || name == NULL) return NULL;
+    for (int i = 0; i < TBOARD_MAX_PERIODIC; i++) {
+        task_t* task = tboard->periodics[i].task;
+        if (task != NULL && strcmp(task->name, name) == 0) {
+            return &tboard->periodics[i];
+        }
+    }
+    return NULL;
+}
+
+
+bool        tboard_cancel_task(tboard_t* tboard, char* name, uint32_t task_serial_id) {
+    if (tboard == NULL) return false;
+    task_t* task = tboard_find_task_name(tboard, name);
+    if (task == NULL) return false;
+    int index = task_get_instance_index(task, task_serial_id);
+    if (index == -1) return false;
+
+    bool cancelled = false;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) == pdTRUE) {
+        task_instance_t* instance = task->instances[index];
+        if (instance != NULL && !instance->has_finished) {
+            if (sched_dispatcher_remove(&tboard->dispatcher, instance)) {
+                /* Still waiting for a slot: it never runs */
+                _tboard_instance_dropped(tboard, instance, REXEC_ERR_CANCELLED);
+                cancelled = true;
+            } else if (atomic_load(&instance->state) == TASK_INSTANCE_RUNNING) {
+                _tboard_request_cancel_locked(instance, REXEC_ERR_CANCELLED);
+                cancelled = true;
+            }
+        }
+        xSemaphoreGive(tboard->task_management_mutex);
+    }
+    /* The scheduler arms the forced termination of the instance */
+    if (cancelled && tboard->scheduler != NULL) {
+        xTaskNotifyGive(tboard->scheduler);
+    }
+    return cancelled;
+}
+
+
+bool        tboard_invoke(tboard_t* tboard, char* name, arg_t* args, tboard_future_t* future) {
+    if (tboard == NULL || name == NULL || future == NULL) return false;
+    future->tboard = tboard;
+    future->instance = NULL;
+    if (xSemaphoreTake(tboard->task_management_mutex, MUTEX_WAIT) != pdTRUE) return false;
+    uint32_t serial_id = _tboard_next_internal_serial_locked(tboard);
+    xSemaphoreGive(tboard->task_management_mutex);
+
+    /* Same path as a REXEC, minus the command decoding and the response encoding */
+    future->instance = _tboard_start_instance(tboard, name, serial_id, args, NULL);
+    return future->instance != NULL;
+}
+
+
+bool        tboard_future_ready(const tboard_future_t* future) {
+    return future != NULL && future->instance != NULL && future->instance->has_finished;
+}
+
+
+bool        tboard_future_wait(tboard_future_t* future, uint32_t timeout_ms) {
+    if (future == NULL || future->instance == NULL) return false;
+    task_instance_t* instance = future->instance;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    /* Register as the waiter, unless the instance already completed */
+    TaskHandle_t expected = NULL;
+    if (!atomic_compare_exchange_strong(&instance->waiter, &expected, self)) {
+        if (expected != TBOARD_WAITER_DONE) return false;
+        /* Claimed by _tboard_instance_complete(), which publishes has_finished right after: tboard_future_get() must
+           not see the instance unfinished */
+        while (!instance->has_finished) {
+            vTaskDelay(1);
+        }
+        return true;
+    }
+    if (ulTaskNotifyTake(pdTRUE, timeout_ms > 0 ? pdMS_TO_TICKS(timeout_ms) : portMAX_DELAY) > 0) {
+        return true;
+    }
+
+    /* Timed out. If the tboard claimed the waiter meanwhile, its notification is on the way: take it so that it does
+       not wake a later wait. */
+    expected = self;
+    if (atomic_compare_exchange_strong(&instance->waiter, &expected, NULL)) {
+        return false;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return true;
+}
+
+
+bool        tboard_future_cancel(tboard_future_t* future) {
+    if (future == NULL || future->instance == NULL) return false;
+    task_instance_t* instance = future->instance;
+    return tboard_cancel_task(future->tboard, instance->parent_task->name, instance->serial_id);
+}
+
+
+rexec_error_t tboard_future_get(tboard_future_t* future, arg_t** result) {
+    if (result != NULL) *result = NULL;
+    if (!tboard_future_ready(future)) return REXEC_ERR_FAILED;
+    rexec_error_t error = future->instance->error;
+    if (error == REXEC_ERR_NONE && result != NULL) {
+        *result = task_instance_take_return_arg(future->instance);
+    }
+    task_instance_destroy(future->instance);
+    future->instance = NULL;
+    return error;
+}
+
+
+rexec_error_t tboard_invoke_sync(tboard_t* tboard, char* name, arg_t* args, arg_t** result, uint32_t timeout_ms) {
+    if (result != NULL) *result = NULL;
+    if (tboard == NULL) return REXEC_ERR_FAILED;
+    /* Blocking a tboard task would keep the invocation from ever running (coroutines, scheduler) or hold a worker slot
+       it may need */
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (pvTaskGetThreadLocalStoragePointer(NULL, TLSTORE_TASK_PTR_IDX) != NULL || self == tboard->co_worker ||
+        self == tboard->scheduler) {
+        printf("tboard_invoke_sync: %s invoked from a tboard task, use tboard_invoke() instead\n", name);
+        return REXEC_ERR_FAILED;
+    }
+    tboard_future_t future;
+    if (!tboard_invoke(tboard, name, args, &future)) return REXEC_ERR_FAILED;
+    if (!tboard_future_wait(&future, timeout_ms) && tboard_future_cancel(&future)) {
+        tboard_future_wait(&future, 0);
+        tboard_future_get(&future, NULL);
+        return REXEC_ERR_TIMEOUT;
+    }
+    /* Over, or completing right now if the cancellation came too late */
+    tboard_future_wait(&future, 0);
+    return tboard_future_get(&future, result);
+}
+
+
+void        tboard_set_adaptive_stack(tboard_t* tboard, bool enable) {
+    if (tboard == NULL) return;
+    tboard->adaptive_stack = enable;
+}
+
+
+uint32_t    tboard_get_task_stack_size(tboard_t* tboard, task_t* task) {
+    if (tboard == NULL || task == NULL || !tboard->adaptive_stack || task->max_stack_used == 0) {
+        return TASK_STACK_SIZE;
+    }
+    uint32_t stack_size = task->max_stack_used + TASK_STACK_MARGIN;
+    return (stack_size < TASK_STACK_MIN_SIZE) ? TASK_STACK_MIN_SIZE : stack_size;
+}
+
+
+bool        tboard_save_stack_profile(tboard_t* tboard) {
+    if (tboard == NULL) return false;
+    if (!tboard->stack_profile_dirty) return true;
+
+    bool saved = true;
+    tboard->stack_profile_dirty = false;
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_t* task = tboard->tasks[i];
+        if (task == NULL || task->stack_samples == 0) continue;
+        char key[16];
+        uint32_t max_stack_used = task->max_stack_used;
+        _tboard_stack_profile_key(task, key, sizeof(key));
+        if (!core_store_set_blob(TBOARD_NVS_NAMESPACE, key, &max_stack_used, sizeof(max_stack_used))) {
+            saved = false;
+        }
+    }
+    if (!saved) {
+        log_error("Could not save stack profile");
+        tboard->stack_profile_dirty = true;
+    }
+    return saved;
+}
+
+
+bool        tboard_poll_completion(tboard_t* tboard, completion_event_t* event) {
+    if (tboard == NULL) return false;
+    return completion_ring_pop(&tboard->completions, event);
+}
+
+
 task_t*     tboard_find_task_name(tboard_t* tboard, char* name){
     
     if (tboard == NULL){
@@ -144,8 +1127,9 @@ task_t*     tboard_find_task_name(tboard_t* tboard, char* name){
         return NULL;
     }
 
+    uint32_t name_hash = jam_name_hash(name);
     for (int i=0; i<MAX_TASKS; i++){
-        if (tboard->tasks[i] == NULL){
+        if (tboard->tasks[i] == NULL || tboard->tasks[i]->name_hash != name_hash){
             continue;
         }
         char* target_name = tboard->tasks[i]->name;
@@ -153,7 +1137,10 @@ task_t*     tboard_find_task_name(tboard_t* tboard, char* name){
             return tboard->tasks[i];
         }
     }
-    return NULL;
+
+    /* Functions of the registry get their task_t on first use */
+    const task_desc_t* desc = _tboard_find_desc(tboard, name);
+    return (desc != NULL) ? _tboard_materialize_desc(tboard, desc) : NULL;
 }
 
 
@@ -166,6 +1153,20 @@ void tboard_print_tasks(tboard_t* tboard) {
     printf("Number of tasks:             %lu\n", tboard->num_tasks);
     printf("Number of dead tasks:        %lu\n", tboard->num_dead_tasks);
     printf("Last dead task ID:           %lu\n", tboard->last_dead_task_id);
+    printf("Adaptive stack sizing:       %s\n", tboard->adaptive_stack ? "on" : "off");
+    printf("Running / queued instances:  %lu / %lu\n", tboard->dispatcher.num_running,
+           sched_dispatcher_queued(&tboard->dispatcher));
+    
+    for (int i = 0; i < TBOARD_MAX_PERIODIC; i++) {
+        tboard_periodic_t* periodic = &tboard->periodics[i];
+        if (periodic->task == NULL) continue;
+        printf("Periodic task %s: period %lld us, %lu releases, %lu overruns, release jitter max %lld us / avg %lld us, "
+               "%lu over the %lld us budget\n",
+               periodic->task->name, periodic->period_us, periodic->releases, periodic->overruns,
+               periodic->max_jitter_us,
+               periodic->completions > 0 ? periodic->total_jitter_us / periodic->completions : 0,
+               periodic->jitter_violations, periodic->jitter_budget_us);
+    }
     
     for (int i = 0; i < MAX_TASKS; i++) {
         if (tboard->tasks[i] == NULL) {
@@ -178,7 +1179,49 @@ void tboard_print_tasks(tboard_t* tboard) {
     printf("---------- TBOARD INFO END ----------\n");
 }
 
-void           tboard_shutdown(tboard_t*tboard){
-    return;
-}
+void           tboard_shutdown(tboard_t* tboard){
+    if (tboard == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(tboard->task_management_mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    /* No more releases, queued instances never run and started ones are asked to stop */
+    for (int i = 0; i < TBOARD_MAX_PERIODIC; i++) {
+        tboard->periodics[i].task = NULL;
+    }
+    sched_entry_t entry;
+    while (sched_queue_pop(&tboard->dispatcher.deadline_queue, &entry) ||
+           sched_queue_pop(&tboard->dispatcher.fifo_queue, &entry)) {
+        _tboard_instance_dropped(tboard, (task_instance_t*) entry.item, REXEC_ERR_CANCELLED);
+    }
+    for (int i = 0; i < TBOARD_MAX_THREADS; i++) {
+        if (tboard->running[i] != NULL) {
+            _tboard_request_cancel_locked(tboard->running[i], REXEC_ERR_CANCELLED);
+        }
+    }
+    for (int i = 0; i < TBOARD_MAX_COROUTINES; i++) {
+        if (tboard->co_instances[i] != NULL) {
+            _tboard_request_cancel_locked(tboard->co_instances[i], REXEC_ERR_CANCELLED);
+        }
+    }
+    xSemaphoreGive(tboard->task_management_mutex);
+
+    if (tboard->scheduler != NULL) {
+        xTaskNotifyGive(tboard->scheduler);
+    }
+    if (tboard->co_worker != NULL) {
+        xTaskNotifyGive(tboard->co_worker);
+    }
 
+    /* Instances that do not reach a checkpoint within the grace period are deleted by the scheduler */
+    TickType_t give_up = xTaskGetTickCount() + pdMS_TO_TICKS(2 * TBOARD_CANCEL_GRACE_MS);
+    while ((int32_t)(give_up - xTaskGetTickCount()) > 0) {
+        bool any_live = tboard->dispatcher.num_running > 0;
+        for (int i = 0; i < TBOARD_MAX_COROUTINES && !any_live; i++) {
+            any_live = tboard->co_instances[i] != NULL;
+        }
+        if (!any_live) break;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
@@ -1,8 +1,19 @@
 #include "utils.h"
 #include "stdlib.h"
 #include "string.h"
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
 
 int32_t total_mem_usage = 0;
+#ifdef MEMORY_DEBUG
+void (*jam_alloc_hook)(uint32_t bytes) = NULL;
+#endif
 
 char* concat(const char *s1, const char *s2)
 {
@@ -13,4 +24,50 @@ char* concat(const char *s1, const char *s2)
     memcpy(result, s1, len1);
     memcpy(result + len1, s2, len2 + 1); // +1 to copy the null-terminator
     return result;
-}
\ No newline at end of file
+}
+
+uint32_t jam_name_hash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int64_t jam_time_us(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+uint32_t jam_task_cpu_ticks(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    /* FreeRTOS tasks are pthreads on the host, ticks are microseconds */
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint32_t) ((int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#elif CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    TaskStatus_t status;
+    vTaskGetInfo(NULL, &status, pdFALSE, eRunning);
+    return status.ulRunTimeCounter;
+#else
+    return 0;
+#endif
+}
+
+uint32_t jam_cpu_ticks_to_us(uint32_t ticks)
+{
+#if !CONFIG_IDF_TARGET_LINUX && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_RUN_TIME_STATS_USING_CPU_CLK
+    return ticks / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ; // cycle counter
+#else
+    return ticks; // esp_timer based counter or host thread clock, already in microseconds
+#endif
+}
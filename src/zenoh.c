@@ -1,12 +1,9 @@
 #include "zenoh.h"
+#include "core.h"
 #include "utils.h" 
 
-/* Connection parameters for Zenoh */
-#define MODE "peer"
-#define CONNECT "udp/224.0.0.224:7446#iface=eth0"
-
 /* Scouting parameters */
-#define PRINT_HELLO true// Print out scout results on zenoh_scout() callback
+// #define PRINT_HELLO // Print out scout results on zenoh_scout() callback
 
 /* PRIVATE FUNCTIONS */
 static void fprintzid(FILE *stream, z_id_t zid) {
@@ -70,23 +67,260 @@ static void drop(void *context) {
     }
 }
 
-/* PUBLIC FUNCTIONS */
-zenoh_t* zenoh_init() {
-    /* Initialize Zenoh Session and other parameters */
-    zenoh_t* zenoh = calloc(1, sizeof(zenoh_t));
+/* Forwards a sample to the callback of its subscription, after counting it */
+static void _zenoh_sub_handler(z_loaned_sample_t* sample, void* context) {
+    zenoh_sub_t* sub = (zenoh_sub_t*) context;
+    sub->samples++;
+    sub->bytes += z_bytes_len(z_sample_payload(sample));
+    sub->last_us = jam_time_us();
+    sub->callback(sample, sub->cb_arg);
+}
+
+/* Takes the lowest free buffer of a pool class, NULL if all are taken */
+static uint8_t* _zenoh_pool_take(_Atomic uint32_t* free_mask, uint8_t* base, size_t size) {
+    uint32_t bits = atomic_load(free_mask);
+    while (bits != 0) {
+        int i = __builtin_ctz(bits);
+        if (atomic_compare_exchange_weak(free_mask, &bits, bits & ~(1u << i))) {
+            return base + (size_t) i * size;
+        }
+    }
+    return NULL;
+}
+
+/* Release callback of the pooled payloads, called by zenoh once the buffer is no longer needed */
+static void _zenoh_pool_deleter(void* data, void* context) {
+    zenoh_buf_release((zenoh_t*) context, (uint8_t*) data);
+}
+
+/* Whether a configuration can be opened: known mode, NUL terminated locators of a known transport */
+static bool _zenoh_config_valid(const zenoh_config_t* config) {
+    if (strnlen(config->mode, ZENOH_MODE_LEN) == ZENOH_MODE_LEN ||
+        strnlen(config->connect, ZENOH_LOCATOR_LEN) == ZENOH_LOCATOR_LEN ||
+        strnlen(config->listen, ZENOH_LOCATOR_LEN) == ZENOH_LOCATOR_LEN) {
+        return false;
+    }
+    if (strcmp(config->mode, "peer") != 0 && strcmp(config->mode, "client") != 0) {
+        return false;
+    }
+    if (config->connect[0] != '\0' && zenoh_locator_transport(config->connect) == ZENOH_TRANSPORT_UNKNOWN) {
+        return false;
+    }
+    return config->listen[0] == '\0' || zenoh_locator_transport(config->listen) != ZENOH_TRANSPORT_UNKNOWN;
+}
+
+/* Puts a CBOR payload with an optional attachment, the QoS was set when the publisher was declared */
+static bool _zenoh_put_cbor(zenoh_pub_t* zenoh_pub, z_owned_bytes_t* payload, const uint8_t* attachment, size_t attachment_len) {
+    z_publisher_put_options_t options;
+    z_publisher_put_options_default(&options);
+    z_owned_encoding_t encoding;
+    z_encoding_clone(&encoding, z_encoding_application_cbor());
+    options.encoding = z_move(encoding);
+    z_owned_bytes_t attachment_bytes;
+    if (attachment != NULL && attachment_len > 0) {
+        z_bytes_copy_from_buf(&attachment_bytes, attachment, attachment_len);
+        options.attachment = z_move(attachment_bytes);
+    }
+
+    // Publish using the key expression
+    if (z_publisher_put(z_loan(zenoh_pub->z_pub), z_move(*payload), &options) != Z_OK) {
+        printf("z_publisher_put failed");
+        return false;
+    }
+    return true;
+}
+
+/* Takes the session lock. Returns false, without the lock, while the session is lost and being reopened. */
+static bool _zenoh_lock(zenoh_t* zenoh) {
+    if (!zenoh->connected) {
+        return false;
+    }
+    xSemaphoreTake(zenoh->lock, portMAX_DELAY);
+    if (!zenoh->connected) {
+        xSemaphoreGive(zenoh->lock);
+        return false;
+    }
+    return true;
+}
+
+static void _zenoh_unlock(zenoh_t* zenoh) {
+    xSemaphoreGive(zenoh->lock);
+}
+
+/* Counts consecutive failed publications, the supervisor takes a run of them as a lost session */
+static bool _zenoh_count_tx(zenoh_t* zenoh, bool sent) {
+    zenoh->tx_failures = sent ? 0 : zenoh->tx_failures + 1;
+    return sent;
+}
+
+/* Opens the session with the parameters of zenoh->config */
+static bool _zenoh_open_session(zenoh_t* zenoh) {
     z_owned_config_t config;
     z_config_default(&config);
-    zp_config_insert(z_loan_mut(config), Z_CONFIG_MODE_KEY, MODE);
-    if (strcmp(CONNECT, "") != 0) {
-        zp_config_insert(z_loan_mut(config), Z_CONFIG_CONNECT_KEY, CONNECT);
+    zp_config_insert(z_loan_mut(config), Z_CONFIG_MODE_KEY, zenoh->config.mode);
+    if (zenoh->config.connect[0] != '\0') {
+        zp_config_insert(z_loan_mut(config), Z_CONFIG_CONNECT_KEY, zenoh->config.connect);
+    }
+    if (zenoh->config.listen[0] != '\0') {
+        zp_config_insert(z_loan_mut(config), Z_CONFIG_LISTEN_KEY, zenoh->config.listen);
     }
 
     /* Open Zenoh session */
     int retval = z_open(&zenoh->z_session, z_move(config), NULL); 
     if (retval < 0) {
         printf("Unable to open Zenoh session! Error code: %d\n", retval);
+        return false;
+    }
+    zenoh->session_open = true;
+    zenoh->session_seq++;
+    return true;
+}
+
+/* Declares the subscriber of a table entry on the current session */
+static bool _zenoh_declare_sub_entry(zenoh_t* zenoh, zenoh_sub_t* sub) {
+    z_owned_closure_sample_t cb;
+    z_closure_sample(&cb, _zenoh_sub_handler, NULL, sub);
+    z_view_keyexpr_t ke;
+    z_view_keyexpr_from_str_unchecked(&ke, sub->keyexpr);
+    return z_declare_subscriber(z_loan(zenoh->z_session), &sub->z_sub, z_loan(ke), z_move(cb), NULL) >= 0;
+}
+
+/* Declares a publisher on the current session, with its key expression and QoS */
+static bool _zenoh_declare_pub_entry(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub) {
+    z_publisher_options_t options;
+    z_publisher_options_default(&options);
+    options.priority = zenoh_pub->qos.priority;
+    options.congestion_control = zenoh_pub->qos.congestion_control;
+    options.is_express = zenoh_pub->qos.is_express;
+
+    z_view_keyexpr_t ke;
+    z_view_keyexpr_from_str_unchecked(&ke, zenoh_pub->keyexpr);
+    return z_declare_publisher(z_loan(zenoh->z_session), &(zenoh_pub->z_pub), z_loan(ke), &options) >= 0;
+}
+
+/* Declares the queryable on the current session */
+static bool _zenoh_declare_queryable_entry(zenoh_t* zenoh) {
+    z_owned_closure_query_t cb;
+    z_closure_query(&cb, zenoh->queryable_callback, NULL, zenoh->queryable_arg);
+    z_view_keyexpr_t ke;
+    z_view_keyexpr_from_str_unchecked(&ke, zenoh->queryable_key);
+    return z_declare_queryable(z_loan(zenoh->z_session), &zenoh->z_queryable, z_loan(ke), z_move(cb), NULL) >= 0;
+}
+
+/* Drops the entities of a lost session and closes it (which stops its read and lease tasks). The tables keep what
+   has to be declared again. */
+static void _zenoh_close_session(zenoh_t* zenoh) {
+    if (!zenoh->session_open) {
+        return;
+    }
+    for (int i = 0; i < ZENOH_MAX_SUBS; i++) {
+        zenoh_sub_t* sub = &zenoh->subs[i];
+        if (!sub->declared) continue;
+        z_drop(z_move(sub->z_sub));
+    }
+    for (int i = 0; i < ZENOH_MAX_PUBS; i++) {
+        zenoh_pub_t* zenoh_pub = zenoh->pubs[i];
+        if (zenoh_pub == NULL) continue;
+        z_drop(z_move(zenoh_pub->z_pub));
+    }
+    if (zenoh->queryable_declared) {
+        z_drop(z_move(zenoh->z_queryable));
+    }
+    zenoh->batching = false;
+    z_close(z_loan_mut(zenoh->z_session), NULL);
+    z_drop(z_move(zenoh->z_session));
+    zenoh->session_open = false;
+}
+
+/* Whether the session still works: open, keep-alive accepted by the transport and publications not failing */
+static bool _zenoh_session_alive(zenoh_t* zenoh) {
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    bool alive = !z_session_is_closed(z_loan(zenoh->z_session)) &&
+                 zp_send_keep_alive(z_loan(zenoh->z_session), NULL) >= 0 &&
+                 zenoh->tx_failures < ZENOH_MAX_TX_FAILURES;
+    _zenoh_unlock(zenoh);
+    return alive;
+}
+
+/* Connects to the next known locator after a failed reconnection, or to the first one when the locator in use is not
+   known (anymore) */
+static void _zenoh_next_locator(zenoh_t* zenoh) {
+    xSemaphoreTake(zenoh->lock, portMAX_DELAY);
+    uint32_t count = zenoh->locators.count;
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(zenoh->locators.locators[i], zenoh->config.connect) == 0) {
+            next = (i + 1) % count;
+            break;
+        }
+    }
+    if (count > 0) {
+        strcpy(zenoh->config.connect, zenoh->locators.locators[next]);
+    }
+    xSemaphoreGive(zenoh->lock);
+}
+
+static void _zenoh_supervisor_task(void* pvParameters) {
+    zenoh_t* zenoh = (zenoh_t*) pvParameters;
+    while (!zenoh->supervisor_stop) {
+        vTaskDelay(pdMS_TO_TICKS(ZENOH_SUPERVISOR_PERIOD_MS));
+        if (zenoh->supervisor_stop || _zenoh_session_alive(zenoh)) {
+            continue;
+        }
+        printf("zenoh session lost, reconnecting \r\n");
+        int64_t lost_us = jam_time_us();
+        uint32_t backoff_ms = ZENOH_RECONNECT_MIN_MS;
+        uint32_t attempts = 1;
+        while (!zenoh_reconnect(zenoh)) {
+            if (zenoh->supervisor_stop) break;
+            /* The controller may have moved, the next attempt goes to another known one */
+            if (zenoh->discovery) {
+                _zenoh_next_locator(zenoh);
+            }
+            vTaskDelay(pdMS_TO_TICKS(backoff_ms));
+            backoff_ms = backoff_ms * 2 < ZENOH_RECONNECT_MAX_MS ? backoff_ms * 2 : ZENOH_RECONNECT_MAX_MS;
+            attempts++;
+        }
+        if (!zenoh->connected) {
+            break;
+        }
+        zenoh->reconnects++;
+        zenoh->last_reconnect_ms = (uint32_t) ((jam_time_us() - lost_us) / 1000);
+        if (zenoh->last_reconnect_ms > zenoh->max_reconnect_ms) {
+            zenoh->max_reconnect_ms = zenoh->last_reconnect_ms;
+        }
+        printf("zenoh session restored in %lu ms (%lu attempts) \r\n", (unsigned long) zenoh->last_reconnect_ms,
+               (unsigned long) attempts);
+    }
+    zenoh->supervisor = NULL;
+    vTaskDelete(NULL);
+}
+
+/* PUBLIC FUNCTIONS */
+zenoh_t* zenoh_init() {
+    zenoh_config_t config;
+    zenoh_config_load(&config);
+    return zenoh_init_with_config(&config);
+}
+
+zenoh_t* zenoh_init_with_config(const zenoh_config_t* config) {
+    if (config == NULL || !_zenoh_config_valid(config)) {
+        printf("zenoh_init_with_config: invalid configuration\n");
+        return NULL;
+    }
+    /* Initialize Zenoh Session and other parameters */
+    zenoh_t* zenoh = calloc(1, sizeof(zenoh_t));
+    zenoh->config = *config;
+    atomic_store(&zenoh->pool.small_free, (uint32_t) ((1ull << ZENOH_POOL_SMALL_COUNT) - 1));
+    atomic_store(&zenoh->pool.large_free, (uint32_t) ((1ull << ZENOH_POOL_LARGE_COUNT) - 1));
+    zenoh->lock = xSemaphoreCreateMutex();
+    if (zenoh->lock == NULL || !_zenoh_open_session(zenoh)) {
+        zenoh_destroy(zenoh);
         return NULL;
     }
+    zenoh->connected = true;
     return zenoh;
 }
 
@@ -95,115 +329,526 @@ void zenoh_destroy(zenoh_t* zenoh) {
     if (zenoh == NULL) {
         return;
     }
-    z_drop(z_move(zenoh->z_sub));
-    z_drop(z_move(zenoh->z_session));
+    zenoh_stop_discovery(zenoh);
+    zenoh_stop_supervisor(zenoh);
+    for (int i = 0; i < ZENOH_MAX_SUBS; i++) {
+        if (zenoh->subs[i].declared) {
+            z_drop(z_move(zenoh->subs[i].z_sub));
+        }
+    }
+    if (zenoh->queryable_declared) {
+        z_drop(z_move(zenoh->z_queryable));
+    }
+    if (zenoh->session_open) {
+        z_drop(z_move(zenoh->z_session));
+    }
+    if (zenoh->lock != NULL) {
+        vSemaphoreDelete(zenoh->lock);
+    }
     free(zenoh);
 }
 
-/*
-* TODO: How do we determine which of the nodes are J nodes? 
-* Should we send a message (pub) and wait for a response for identification ?
-* TODO: Refactor: we do not need the zenoh object as a parameter
-*/
-#define SCOUT_TIMEOUT_MS 3000  // 3 seconds
+void zenoh_config_default(zenoh_config_t* config) {
+    memset(config, 0, sizeof(zenoh_config_t));
+    strcpy(config->mode, ZENOH_DEFAULT_MODE);
+    strcpy(config->connect, ZENOH_DEFAULT_CONNECT);
+}
 
+bool zenoh_config_load(zenoh_config_t* config) {
+    size_t len = sizeof(zenoh_config_t);
+    if (core_store_get_blob(ZENOH_NVS_NAMESPACE, ZENOH_NVS_CONFIG_KEY, config, &len) && len == sizeof(zenoh_config_t) &&
+        _zenoh_config_valid(config)) {
+        return true;
+    }
+    zenoh_config_default(config);
+    return false;
+}
 
-static void scout_callback(z_loaned_hello_t *hello, void *context) {
-    (*(int *)context)++;
+bool zenoh_config_save(const zenoh_config_t* config) {
+    if (config == NULL || !_zenoh_config_valid(config)) {
+        return false;
+    }
+    return core_store_set_blob(ZENOH_NVS_NAMESPACE, ZENOH_NVS_CONFIG_KEY, config, sizeof(zenoh_config_t));
+}
 
-    // Print peer information
-    printf("Discovered Zenoh peer: ");
-    fprinthello(stdout, hello);
-    printf("\n");
+bool zenoh_config_erase(void) {
+    return core_store_erase(ZENOH_NVS_NAMESPACE, ZENOH_NVS_CONFIG_KEY);
 }
 
-static void scout_drop(void *context) {
-    int count = *(int *)context;
-    free(context);
+bool zenoh_config_set_endpoint(zenoh_config_t* config, zenoh_transport_t transport, const char* host, int port,
+                               const char* iface) {
+    if (config == NULL || host == NULL || transport == ZENOH_TRANSPORT_UNKNOWN) {
+        return false;
+    }
+    char locator[ZENOH_LOCATOR_LEN];
+    /* An IPv6 address is bracketed in a locator */
+    bool ipv6 = strchr(host, ':') != NULL && host[0] != '[';
+    int len = snprintf(locator, sizeof(locator), "%s/%s%s%s:%d%s%s", transport == ZENOH_TRANSPORT_TCP ? "tcp" : "udp",
+                       ipv6 ? "[" : "", host, ipv6 ? "]" : "", port, iface != NULL ? "#iface=" : "",
+                       iface != NULL ? iface : "");
+    if (len < 0 || len >= (int) sizeof(locator) || zenoh_locator_transport(locator) != transport) {
+        return false;
+    }
+    strcpy(config->connect, locator);
+    return true;
+}
 
-    if (count == 0) {
-        printf("Did not find any Zenoh peers.\n");
-    } else {
-        printf("Scout finished. Discovered %d peer(s).\n", count);
+zenoh_transport_t zenoh_locator_transport(const char* locator) {
+    if (locator == NULL) {
+        return ZENOH_TRANSPORT_UNKNOWN;
+    }
+    if (strncmp(locator, "tcp/", 4) == 0) {
+        return ZENOH_TRANSPORT_TCP;
+    }
+    if (strncmp(locator, "udp/", 4) != 0) {
+        return ZENOH_TRANSPORT_UNKNOWN;
+    }
+    /* Multicast groups: 224.0.0.0/4 and ff00::/8, "udp/[ff02::1]:7446" */
+    if (locator[4] == '[') {
+        char* end;
+        unsigned long first_group = strtoul(locator + 5, &end, 16);
+        return *end == ':' && (first_group >> 8) == 0xff ? ZENOH_TRANSPORT_UDP_MULTICAST : ZENOH_TRANSPORT_UDP_UNICAST;
+    }
+    int first_octet = atoi(locator + 4);
+    return first_octet >= 224 && first_octet <= 239 ? ZENOH_TRANSPORT_UDP_MULTICAST : ZENOH_TRANSPORT_UDP_UNICAST;
+}
+
+zenoh_transport_t zenoh_transport_from_str(const char* name) {
+    if (name == NULL) {
+        return ZENOH_TRANSPORT_UNKNOWN;
+    }
+    if (strcmp(name, "udp-multicast") == 0) {
+        return ZENOH_TRANSPORT_UDP_MULTICAST;
+    }
+    if (strcmp(name, "udp") == 0) {
+        return ZENOH_TRANSPORT_UDP_UNICAST;
+    }
+    if (strcmp(name, "tcp") == 0) {
+        return ZENOH_TRANSPORT_TCP;
+    }
+    return ZENOH_TRANSPORT_UNKNOWN;
+}
+
+/* Adds a locator to a set, unless it is already there or the set is full */
+static void _zenoh_locators_add(zenoh_locators_t* locators, const char* locator) {
+    if (locators->count >= ZENOH_MAX_LOCATORS || strlen(locator) >= ZENOH_LOCATOR_LEN) {
+        return;
+    }
+    for (uint32_t i = 0; i < locators->count; i++) {
+        if (strcmp(locators->locators[i], locator) == 0) {
+            return;
+        }
+    }
+    strcpy(locators->locators[locators->count++], locator);
+}
+
+/* Keeps the unicast locators of the routers that answered. Multicast locators are the group itself, not a controller,
+   and peers are other nodes (or clients, which cannot be connected to). */
+static void _zenoh_discovery_hello(z_loaned_hello_t* hello, void* context) {
+    zenoh_locators_t* found = (zenoh_locators_t*) context;
+    if (z_hello_whatami(hello) != Z_WHATAMI_ROUTER) {
+        return;
+    }
+    const z_loaned_string_array_t* locs = zp_hello_locators(hello);
+    for (size_t i = 0; i < z_string_array_len(locs); i++) {
+        const z_loaned_string_t* str = z_string_array_get(locs, i);
+        char locator[ZENOH_LOCATOR_LEN];
+        size_t len = z_string_len(str);
+        if (len >= sizeof(locator)) continue;
+        memcpy(locator, z_string_data(str), len);
+        locator[len] = '\0';
+        zenoh_transport_t transport = zenoh_locator_transport(locator);
+        if (transport == ZENOH_TRANSPORT_UDP_UNICAST || transport == ZENOH_TRANSPORT_TCP) {
+            _zenoh_locators_add(found, locator);
+        }
+    }
+#ifdef PRINT_HELLO
+    fprinthello(stdout, hello);
+    fprintf(stdout, "\n");
+#endif
+}
+
+/* Caches the locators found, the one in use first while the session is up (a lost one goes in scouting order, it is
+   not tried first at the next boot). Unchanged locators are not written again, to spare the flash. */
+static void _zenoh_cache_locators(zenoh_t* zenoh, const zenoh_locators_t* found) {
+    zenoh_locators_t locators;
+    memset(&locators, 0, sizeof(locators));
+    for (uint32_t i = 0; i < found->count && zenoh->connected; i++) {
+        if (strcmp(found->locators[i], zenoh->config.connect) == 0) {
+            _zenoh_locators_add(&locators, zenoh->config.connect);
+        }
+    }
+    for (uint32_t i = 0; i < found->count; i++) {
+        _zenoh_locators_add(&locators, found->locators[i]);
+    }
+    xSemaphoreTake(zenoh->lock, portMAX_DELAY);
+    bool changed = memcmp(&locators, &zenoh->locators, sizeof(locators)) != 0;
+    zenoh->locators = locators;
+    xSemaphoreGive(zenoh->lock);
+    if (changed && !zenoh_locators_save(&locators)) {
+        printf("zenoh: could not cache the controller locators\n");
     }
 }
 
+static void _zenoh_discovery_task(void* pvParameters) {
+    zenoh_t* zenoh = (zenoh_t*) pvParameters;
+    TickType_t last_scout = xTaskGetTickCount();
+    bool first = !zenoh->from_cache;
+    while (!zenoh->discovery_stop) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        /* A boot from the cache is checked at once, a scouting at boot already refreshed it */
+        if (!first && xTaskGetTickCount() - last_scout < pdMS_TO_TICKS(ZENOH_DISCOVERY_PERIOD_MS)) {
+            continue;
+        }
+        first = false;
+        zenoh_locators_t found;
+        if (zenoh_discover(&found, ZENOH_SCOUT_TIMEOUT_MS)) {
+            _zenoh_cache_locators(zenoh, &found);
+        }
+        last_scout = xTaskGetTickCount();
+    }
+    zenoh->discovery_task = NULL;
+    vTaskDelete(NULL);
+}
 
 bool zenoh_scout() {
-    // Allocate context to track discovered peers
-    int *peer_count = (int *)malloc(sizeof(int));
-    if (!peer_count) {
-        printf("Memory allocation failed.\n");
+    zenoh_locators_t found;
+    return zenoh_discover(&found, ZENOH_SCOUT_TIMEOUT_MS);
+}
+
+bool zenoh_discover(zenoh_locators_t* found, uint32_t timeout_ms) {
+    if (found == NULL) {
         return false;
     }
-    *peer_count = 0;
+    memset(found, 0, sizeof(zenoh_locators_t));
 
-    // Create default config
     z_owned_config_t config;
     if (z_config_default(&config) < 0) {
         printf("Failed to create default Zenoh config.\n");
-        free(peer_count);
         return false;
     }
+    char timeout[12];
+    snprintf(timeout, sizeof(timeout), "%lu", (unsigned long) timeout_ms);
+    zp_config_insert(z_loan_mut(config), Z_CONFIG_SCOUTING_TIMEOUT_KEY, timeout);
+    /* Only routers are controllers, see _zenoh_discovery_hello() */
+    char what[4];
+    snprintf(what, sizeof(what), "%d", (int) Z_WHATAMI_ROUTER);
+    zp_config_insert(z_loan_mut(config), Z_CONFIG_SCOUTING_WHAT_KEY, what);
 
-    // Set up callback closure
+    /* found lives on the stack of the caller: z_scout() returns once the scouting is over and the closure dropped */
     z_owned_closure_hello_t closure;
-    if (z_closure_hello(&closure, scout_callback, scout_drop, peer_count) < 0) {
+    if (z_closure_hello(&closure, _zenoh_discovery_hello, NULL, found) < 0) {
         printf("Failed to create scout closure.\n");
-        free(peer_count);
+        z_drop(z_move(config));
+        return false;
+    }
+    if (z_scout(z_config_move(&config), z_closure_hello_move(&closure), NULL) < 0) {
+        printf("Scouting failed.\n");
+        return false;
+    }
+    return found->count > 0;
+}
+
+bool zenoh_locators_load(zenoh_locators_t* locators) {
+    size_t len = sizeof(zenoh_locators_t);
+    if (core_store_get_blob(ZENOH_NVS_NAMESPACE, ZENOH_NVS_LOCATORS_KEY, locators, &len) &&
+        len == sizeof(zenoh_locators_t) && locators->count <= ZENOH_MAX_LOCATORS) {
+        bool valid = true;
+        for (uint32_t i = 0; i < locators->count && valid; i++) {
+            valid = strnlen(locators->locators[i], ZENOH_LOCATOR_LEN) < ZENOH_LOCATOR_LEN;
+        }
+        if (valid) {
+            return locators->count > 0;
+        }
+    }
+    memset(locators, 0, sizeof(zenoh_locators_t));
+    return false;
+}
+
+bool zenoh_locators_save(const zenoh_locators_t* locators) {
+    if (locators == NULL) {
+        return false;
+    }
+    return core_store_set_blob(ZENOH_NVS_NAMESPACE, ZENOH_NVS_LOCATORS_KEY, locators, sizeof(zenoh_locators_t));
+}
+
+zenoh_t* zenoh_init_discovered(const zenoh_config_t* config) {
+    if (config == NULL) {
+        return NULL;
+    }
+    int64_t start_us = jam_time_us();
+    zenoh_config_t attempt = *config;
+    zenoh_t* zenoh = NULL;
+    /* The controller is a router: the node connects to it as a client, which does not listen */
+    strcpy(attempt.mode, "client");
+    attempt.listen[0] = '\0';
+
+    /* Cached locators first: one connection attempt instead of a scouting */
+    zenoh_locators_t cached;
+    zenoh_locators_load(&cached);
+    for (uint32_t i = 0; i < cached.count && zenoh == NULL; i++) {
+        strcpy(attempt.connect, cached.locators[i]);
+        zenoh = zenoh_init_with_config(&attempt);
+    }
+    bool from_cache = zenoh != NULL;
+
+    zenoh_locators_t found;
+    memset(&found, 0, sizeof(found));
+    if (zenoh == NULL) {
+        printf("No cached controller answered, scouting ...\n");
+        zenoh_discover(&found, ZENOH_SCOUT_TIMEOUT_MS);
+        for (uint32_t i = 0; i < found.count && zenoh == NULL; i++) {
+            strcpy(attempt.connect, found.locators[i]);
+            zenoh = zenoh_init_with_config(&attempt);
+        }
+    }
+    if (zenoh == NULL) {
+        printf("zenoh_init_discovered: no controller found\n");
+        return NULL;
+    }
+    zenoh->discovery = true;
+    zenoh->from_cache = from_cache;
+    zenoh->discovery_ms = (uint32_t) ((jam_time_us() - start_us) / 1000);
+    if (from_cache) {
+        zenoh->locators = cached;
+    } else {
+        _zenoh_cache_locators(zenoh, &found);
+    }
+    printf("zenoh: connected to %s in %lu ms (%s)\n", zenoh->config.connect, (unsigned long) zenoh->discovery_ms,
+           from_cache ? "cached" : "scouted");
+    return zenoh;
+}
+
+bool zenoh_start_discovery(zenoh_t* zenoh) {
+    if (zenoh == NULL) {
         return false;
     }
+    if (!zenoh->discovery || zenoh->discovery_task != NULL) {
+        return true;
+    }
+    zenoh->discovery_stop = false;
+    return xTaskCreate(_zenoh_discovery_task, "zenoh_discovery", 4096, zenoh, 3, &zenoh->discovery_task) == pdPASS;
+}
 
-    // Start scouting
-    printf("Scouting for Zenoh peers...\n");
-    z_scout(z_config_move(&config), z_closure_hello_move(&closure), NULL);
+void zenoh_stop_discovery(zenoh_t* zenoh) {
+    if (zenoh == NULL || zenoh->discovery_task == NULL) {
+        return;
+    }
+    zenoh->discovery_stop = true;
+    while (zenoh->discovery_task != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
 
-    // Allow time for scout to run
-    vTaskDelay(pdMS_TO_TICKS(SCOUT_TIMEOUT_MS));
+int zenoh_subscribe(zenoh_t* zenoh, const char* key_expression, zenoh_callback_t callback, void* cb_arg) {
+    /* Make sure we don't accidentally dereference a null pointer ... */
+    if (zenoh == NULL || key_expression == NULL || callback == NULL) {
+        return -1;
+    }
+    int sub_id = -1;
+    for (int i = 0; i < ZENOH_MAX_SUBS; i++) {
+        if (!zenoh->subs[i].declared) {
+            sub_id = i;
+            break;
+        }
+    }
+    if (sub_id == -1) {
+        printf("zenoh_subscribe: subscription table is full\n");
+        return -1;
+    }
 
-    // Return true if we found any peers
-    bool found = (*peer_count > 0);
-    return found;
+    zenoh_sub_t* sub = &zenoh->subs[sub_id];
+    memset(sub, 0, sizeof(zenoh_sub_t));
+    sub->keyexpr = key_expression;
+    sub->callback = callback;
+    sub->cb_arg = cb_arg;
+    if (!_zenoh_lock(zenoh)) {
+        return -1;
+    }
+    sub->declared = _zenoh_declare_sub_entry(zenoh, sub);
+    _zenoh_unlock(zenoh);
+    return sub->declared ? sub_id : -1;
+}
+
+bool zenoh_unsubscribe(zenoh_t* zenoh, int sub_id) {
+    if (zenoh == NULL || sub_id < 0 || sub_id >= ZENOH_MAX_SUBS || !zenoh->subs[sub_id].declared) {
+        return false;
+    }
+    zenoh_sub_t* sub = &zenoh->subs[sub_id];
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    /* A lost session already dropped the subscriber, only the table entry is left */
+    bool undeclared = !zenoh->session_open || z_undeclare_subscriber(z_move(sub->z_sub)) >= 0;
+    if (undeclared) {
+        sub->declared = false;
+    }
+    _zenoh_unlock(zenoh);
+    return undeclared;
+}
+
+const zenoh_sub_t* zenoh_get_sub(const zenoh_t* zenoh, int sub_id) {
+    if (zenoh == NULL || sub_id < 0 || sub_id >= ZENOH_MAX_SUBS || !zenoh->subs[sub_id].declared) {
+        return NULL;
+    }
+    return &zenoh->subs[sub_id];
 }
 
 bool zenoh_declare_sub(zenoh_t* zenoh, const char* key_expression, zenoh_callback_t* callback, void* cb_arg) {
+    return zenoh_subscribe(zenoh, key_expression, (zenoh_callback_t) callback, cb_arg) >= 0;
+}
+
+bool zenoh_declare_pub(zenoh_t* zenoh, const char* key_expression, zenoh_pub_t* zenoh_pub) {
+    return zenoh_declare_pub_qos(zenoh, key_expression, zenoh_pub, NULL);
+}
+
+void zenoh_qos_init(zenoh_qos_t* qos, zenoh_qos_class_t qos_class) {
+    if (qos == NULL) {
+        return;
+    }
+    z_publisher_options_t defaults;
+    z_publisher_options_default(&defaults);
+    qos->priority = defaults.priority;
+    qos->congestion_control = defaults.congestion_control;
+    qos->is_express = defaults.is_express;
+    switch (qos_class) {
+        case ZENOH_QOS_CONTROL:
+            qos->priority = Z_PRIORITY_INTERACTIVE_HIGH;
+            qos->congestion_control = Z_CONGESTION_CONTROL_BLOCK;
+            qos->is_express = true;
+            break;
+        case ZENOH_QOS_DATA:
+            qos->priority = Z_PRIORITY_DATA_HIGH;
+            qos->congestion_control = Z_CONGESTION_CONTROL_BLOCK;
+            qos->is_express = false;
+            break;
+        case ZENOH_QOS_TELEMETRY:
+            qos->priority = Z_PRIORITY_DATA_LOW;
+            qos->congestion_control = Z_CONGESTION_CONTROL_DROP;
+            qos->is_express = false;
+            break;
+        default:
+            break;
+    }
+}
+
+bool zenoh_declare_pub_qos(zenoh_t* zenoh, const char* key_expression, zenoh_pub_t* zenoh_pub, const zenoh_qos_t* qos) {
     /* Make sure we don't accidentally dereference a null pointer ... */
     if (zenoh == NULL) {
         return false;
     }
-    z_owned_closure_sample_t cb;
-    z_closure(&cb, callback); 
-    cb._val.context = cb_arg; /* Pass in as an argument to the callback */
-    z_view_keyexpr_t ke;
-    z_view_keyexpr_from_str_unchecked(&ke, key_expression);
-    if (z_declare_subscriber(z_loan(zenoh->z_session), &zenoh->z_sub , z_loan(ke), z_move(cb), NULL) < 0) {
+
+    if (qos != NULL) {
+        zenoh_pub->qos = *qos;
+    } else {
+        zenoh_qos_init(&zenoh_pub->qos, ZENOH_QOS_DEFAULT);
+    }
+    zenoh_pub->keyexpr = key_expression;
+    if (!_zenoh_lock(zenoh)) {
         return false;
     }
+    bool declared = _zenoh_declare_pub_entry(zenoh, zenoh_pub);
+    _zenoh_unlock(zenoh);
+    if (!declared) {
+        return false;
+    }
+    /* Remembered to be declared again after a reconnection */
+    for (int i = 0; i < ZENOH_MAX_PUBS; i++) {
+        if (zenoh->pubs[i] == NULL) {
+            zenoh->pubs[i] = zenoh_pub;
+            return true;
+        }
+    }
+    printf("zenoh_declare_pub: publisher table is full, %s is not re-declared after a reconnection\n", key_expression);
     return true;
 }
 
-bool zenoh_declare_pub(zenoh_t* zenoh, const char* key_expression, zenoh_pub_t* zenoh_pub) {
+bool zenoh_undeclare_pub(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub) {
     /* Make sure we don't accidentally dereference a null pointer ... */
-    if (zenoh == NULL) {
+    if (zenoh == NULL || zenoh_pub == NULL) {
+        return false;
+    }
+    if (!_zenoh_lock(zenoh)) {
         return false;
     }
+    /* A lost session already dropped the publisher, only the table entry is left */
+    bool undeclared = !zenoh->session_open || z_undeclare_publisher(z_move(zenoh_pub->z_pub)) >= 0;
+    if (undeclared) {
+        for (int i = 0; i < ZENOH_MAX_PUBS; i++) {
+            if (zenoh->pubs[i] == zenoh_pub) {
+                zenoh->pubs[i] = NULL;
+            }
+        }
+    }
+    _zenoh_unlock(zenoh);
+    return undeclared;
+}
+
+bool zenoh_declare_queryable(zenoh_t* zenoh, const char* key_expression, zenoh_query_callback_t callback, void* cb_arg) {
+    /* Make sure we don't accidentally dereference a null pointer ... */
+    if (zenoh == NULL || key_expression == NULL || callback == NULL || zenoh->queryable_declared) {
+        return false;
+    }
+    zenoh->queryable_key = key_expression;
+    zenoh->queryable_callback = callback;
+    zenoh->queryable_arg = cb_arg;
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    zenoh->queryable_declared = _zenoh_declare_queryable_entry(zenoh);
+    _zenoh_unlock(zenoh);
+    return zenoh->queryable_declared;
+}
+
+bool zenoh_undeclare_queryable(zenoh_t* zenoh) {
+    if (zenoh == NULL || !zenoh->queryable_declared) {
+        return false;
+    }
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    /* A lost session already dropped the queryable, only the table entry is left */
+    bool undeclared = !zenoh->session_open || z_undeclare_queryable(z_move(zenoh->z_queryable)) >= 0;
+    if (undeclared) {
+        zenoh->queryable_declared = false;
+    }
+    _zenoh_unlock(zenoh);
+    return undeclared;
+}
+
+bool zenoh_reply_encoded(const z_loaned_query_t* query, const char* key_expression, const uint8_t* buffer, size_t buffer_len) {
+    /* Make sure we don't accidentally dereference a null pointer */
+    if (query == NULL || key_expression == NULL || buffer == NULL) {
+        printf("zenoh_reply_encoded failed");
+        return false;
+    }
+    z_query_reply_options_t options;
+    z_query_reply_options_default(&options);
+    z_owned_encoding_t encoding;
+    z_encoding_clone(&encoding, z_encoding_application_cbor());
+    options.encoding = z_move(encoding);
 
     z_view_keyexpr_t ke;
-    z_view_keyexpr_from_str_unchecked(&ke, key_expression);
-    if (z_declare_publisher(z_loan(zenoh->z_session), &(zenoh_pub->z_pub), z_loan(ke), NULL) < 0) {
+    if (z_view_keyexpr_from_str(&ke, key_expression) != Z_OK) {
+        printf("zenoh_reply_encoded: invalid key expression");
+        return false;
+    }
+    z_owned_bytes_t payload;
+    z_bytes_copy_from_buf(&payload, buffer, buffer_len);
+    if (z_query_reply(query, z_loan(ke), z_move(payload), &options) != Z_OK) {
+        printf("z_query_reply failed");
         return false;
     }
-    zenoh_pub->keyexpr = key_expression;
     return true;
 }
 
-
 void zenoh_start_read_task(zenoh_t* zenoh) {
     /* Make sure we don't accidentally dereference a null pointer ... */
     if (zenoh == NULL) {
         return;
     }
     zp_start_read_task(z_loan_mut(zenoh->z_session), NULL);
+    zenoh->read_task_started = true;
 } 
  
 
@@ -213,36 +858,273 @@ void zenoh_start_lease_task(zenoh_t* zenoh) {
         return;
     }
     zp_start_lease_task(z_loan_mut(zenoh->z_session), NULL);
+    zenoh->lease_task_started = true;
 } 
  
+bool zenoh_batch_start(zenoh_t* zenoh) {
+    /* Make sure we don't accidentally dereference a null pointer ... */
+    if (zenoh == NULL) {
+        return false;
+    }
+    if (zenoh->batching) {
+        return true;
+    }
+#if defined(Z_FEATURE_BATCHING) && Z_FEATURE_BATCHING == 1
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    zenoh->batching = zp_batch_start(z_loan(zenoh->z_session)) >= 0;
+    _zenoh_unlock(zenoh);
+    return zenoh->batching;
+#else
+    return false;
+#endif
+}
+
+bool zenoh_batch_flush(zenoh_t* zenoh) {
+    if (zenoh == NULL || !zenoh->batching) {
+        return true;
+    }
+#if defined(Z_FEATURE_BATCHING) && Z_FEATURE_BATCHING == 1
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    bool flushed = _zenoh_count_tx(zenoh, zp_batch_flush(z_loan(zenoh->z_session)) >= 0);
+    _zenoh_unlock(zenoh);
+    return flushed;
+#else
+    return true;
+#endif
+}
+
+bool zenoh_batch_stop(zenoh_t* zenoh) {
+    if (zenoh == NULL || !zenoh->batching) {
+        return true;
+    }
+    zenoh->batching = false;
+#if defined(Z_FEATURE_BATCHING) && Z_FEATURE_BATCHING == 1
+    /* A lost session drops its batch with it */
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    bool stopped = _zenoh_count_tx(zenoh, zp_batch_stop(z_loan(zenoh->z_session)) >= 0);
+    _zenoh_unlock(zenoh);
+    return stopped;
+#else
+    return true;
+#endif
+}
+
 bool zenoh_publish(zenoh_t* zenoh, const char* message, zenoh_pub_t* zenoh_pub) {
     /* Make sure we don't accidentally dereference a null pointer ... */
     if (zenoh == NULL) {
         return false;
     }
 
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
     z_owned_bytes_t payload;
     z_bytes_copy_from_str(&payload, message);
-    if (z_publisher_put(z_loan(zenoh_pub->z_pub), z_move(payload), NULL) != Z_OK) {
+    bool sent = _zenoh_count_tx(zenoh, z_publisher_put(z_loan(zenoh_pub->z_pub), z_move(payload), NULL) == Z_OK);
+    _zenoh_unlock(zenoh);
+    if (!sent) {
         printf("z_publisher_put failed");
-        return false;
     }
-    return true;
+    return sent;
 }
 
 bool zenoh_publish_encoded(zenoh_t* zenoh,zenoh_pub_t* zenoh_pub, const uint8_t* buffer, size_t buffer_len) {
+    return zenoh_publish_encoded_attached(zenoh, zenoh_pub, buffer, buffer_len, NULL, 0);
+}
+
+bool zenoh_publish_encoded_attached(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, const uint8_t* buffer, size_t buffer_len,
+                                    const uint8_t* attachment, size_t attachment_len) {
     /* Make sure we don't accidentally dereference a null pointer */
     if (zenoh == NULL || buffer == NULL || zenoh_pub == NULL) {
         printf("zenoh_publish_encoded failed");
         return false;
     }
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    bool sent = false;
     z_owned_bytes_t payload;
-    z_bytes_copy_from_buf(&payload, buffer, buffer_len);
-    // Publish using the key expression
-    if (z_publisher_put(z_loan(zenoh_pub->z_pub), z_move(payload), z_encoding_application_cbor()) != Z_OK) {
-        printf("z_publisher_put failed");
+    uint8_t* pooled = zenoh_buf_acquire(zenoh, buffer_len);
+    if (pooled != NULL) {
+        /* zenoh gives the buffer back to the pool once sent, also if this fails */
+        memcpy(pooled, buffer, buffer_len);
+        if (z_bytes_from_buf(&payload, pooled, buffer_len, _zenoh_pool_deleter, zenoh) == Z_OK) {
+            sent = _zenoh_put_cbor(zenoh_pub, &payload, attachment, attachment_len);
+        } else {
+            printf("z_bytes_from_buf failed");
+        }
+    } else {
+        z_bytes_copy_from_buf(&payload, buffer, buffer_len);
+        sent = _zenoh_put_cbor(zenoh_pub, &payload, attachment, attachment_len);
+    }
+    _zenoh_count_tx(zenoh, sent);
+    _zenoh_unlock(zenoh);
+    return sent;
+}
+
+size_t zenoh_sample_attachment(const z_loaned_sample_t* sample, uint8_t* buffer, size_t buffer_len) {
+    const z_loaned_bytes_t* attachment = z_sample_attachment(sample);
+    if (attachment == NULL || buffer == NULL) {
+        return 0;
+    }
+    size_t len = z_bytes_len(attachment);
+    if (len > buffer_len) {
+        return 0;
+    }
+    z_bytes_reader_t reader = z_bytes_get_reader(attachment);
+    return z_bytes_reader_read(&reader, buffer, len);
+}
+
+uint8_t* zenoh_buf_acquire(zenoh_t* zenoh, size_t size) {
+    if (zenoh == NULL) {
+        return NULL;
+    }
+    zenoh_buf_pool_t* pool = &zenoh->pool;
+    uint8_t* buffer = NULL;
+    if (size <= ZENOH_POOL_SMALL_SIZE) {
+        buffer = _zenoh_pool_take(&pool->small_free, &pool->small[0][0], ZENOH_POOL_SMALL_SIZE);
+    }
+    /* A small message may take a large buffer rather than being copied */
+    if (buffer == NULL && size <= ZENOH_POOL_LARGE_SIZE) {
+        buffer = _zenoh_pool_take(&pool->large_free, &pool->large[0][0], ZENOH_POOL_LARGE_SIZE);
+    }
+    if (buffer == NULL) {
+        atomic_fetch_add(&pool->misses, 1);
+    }
+    return buffer;
+}
+
+void zenoh_buf_release(zenoh_t* zenoh, uint8_t* buffer) {
+    if (zenoh == NULL || buffer == NULL) {
+        return;
+    }
+    zenoh_buf_pool_t* pool = &zenoh->pool;
+    uint8_t* small = &pool->small[0][0];
+    uint8_t* large = &pool->large[0][0];
+    if (buffer >= small && buffer < small + sizeof(pool->small)) {
+        atomic_fetch_or(&pool->small_free, 1u << ((buffer - small) / ZENOH_POOL_SMALL_SIZE));
+    } else if (buffer >= large && buffer < large + sizeof(pool->large)) {
+        atomic_fetch_or(&pool->large_free, 1u << ((buffer - large) / ZENOH_POOL_LARGE_SIZE));
+    } else {
+        printf("zenoh_buf_release: buffer is not from the pool\n");
+    }
+}
+
+bool zenoh_publish_pooled(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, uint8_t* buffer, size_t buffer_len) {
+    /* Make sure we don't accidentally dereference a null pointer */
+    if (zenoh == NULL || buffer == NULL || zenoh_pub == NULL) {
+        printf("zenoh_publish_pooled failed");
+        zenoh_buf_release(zenoh, buffer);
         return false;
     }
+    if (!_zenoh_lock(zenoh)) {
+        zenoh_buf_release(zenoh, buffer);
+        return false;
+    }
+    /* From here zenoh owns the buffer: it calls the deleter once done, also if z_bytes_from_buf or the put fails */
+    bool sent = false;
+    z_owned_bytes_t payload;
+    if (z_bytes_from_buf(&payload, buffer, buffer_len, _zenoh_pool_deleter, zenoh) == Z_OK) {
+        sent = _zenoh_put_cbor(zenoh_pub, &payload, NULL, 0);
+    } else {
+        printf("z_bytes_from_buf failed");
+    }
+    _zenoh_count_tx(zenoh, sent);
+    _zenoh_unlock(zenoh);
+    return sent;
+}
+
+bool zenoh_publish_static(zenoh_t* zenoh, zenoh_pub_t* zenoh_pub, const uint8_t* buffer, size_t buffer_len) {
+    /* Make sure we don't accidentally dereference a null pointer */
+    if (zenoh == NULL || buffer == NULL || zenoh_pub == NULL) {
+        printf("zenoh_publish_static failed");
+        return false;
+    }
+    if (!_zenoh_lock(zenoh)) {
+        return false;
+    }
+    bool sent = false;
+    z_owned_bytes_t payload;
+    if (z_bytes_from_static_buf(&payload, buffer, buffer_len) == Z_OK) {
+        sent = _zenoh_put_cbor(zenoh_pub, &payload, NULL, 0);
+    } else {
+        printf("z_bytes_from_static_buf failed");
+    }
+    _zenoh_count_tx(zenoh, sent);
+    _zenoh_unlock(zenoh);
+    return sent;
+}
+
+bool zenoh_is_connected(const zenoh_t* zenoh) {
+    return zenoh != NULL && zenoh->connected;
+}
+
+bool zenoh_reconnect(zenoh_t* zenoh) {
+    if (zenoh == NULL) {
+        return false;
+    }
+    /* Publishers fail fast from here, and none is using the session once the lock is released */
+    xSemaphoreTake(zenoh->lock, portMAX_DELAY);
+    zenoh->connected = false;
+    xSemaphoreGive(zenoh->lock);
 
+    _zenoh_close_session(zenoh);
+    if (!_zenoh_open_session(zenoh)) {
+        return false;
+    }
+    bool declared = true;
+    for (int i = 0; i < ZENOH_MAX_SUBS && declared; i++) {
+        if (zenoh->subs[i].declared) {
+            declared = _zenoh_declare_sub_entry(zenoh, &zenoh->subs[i]);
+        }
+    }
+    for (int i = 0; i < ZENOH_MAX_PUBS && declared; i++) {
+        if (zenoh->pubs[i] != NULL) {
+            declared = _zenoh_declare_pub_entry(zenoh, zenoh->pubs[i]);
+        }
+    }
+    if (declared && zenoh->queryable_declared) {
+        declared = _zenoh_declare_queryable_entry(zenoh);
+    }
+    if (!declared) {
+        printf("zenoh_reconnect: could not declare the entities again\n");
+        _zenoh_close_session(zenoh);
+        return false;
+    }
+    if (zenoh->read_task_started) {
+        zp_start_read_task(z_loan_mut(zenoh->z_session), NULL);
+    }
+    if (zenoh->lease_task_started) {
+        zp_start_lease_task(z_loan_mut(zenoh->z_session), NULL);
+    }
+    zenoh->tx_failures = 0;
+    zenoh->connected = true;
     return true;
 }
+
+bool zenoh_start_supervisor(zenoh_t* zenoh) {
+    if (zenoh == NULL) {
+        return false;
+    }
+    if (zenoh->supervisor != NULL) {
+        return true;
+    }
+    zenoh->supervisor_stop = false;
+    return xTaskCreate(_zenoh_supervisor_task, "zenoh_supervisor", 4096, zenoh, 5, &zenoh->supervisor) == pdPASS;
+}
+
+void zenoh_stop_supervisor(zenoh_t* zenoh) {
+    if (zenoh == NULL || zenoh->supervisor == NULL) {
+        return;
+    }
+    zenoh->supervisor_stop = true;
+    while (zenoh->supervisor != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
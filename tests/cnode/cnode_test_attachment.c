@@ -0,0 +1,58 @@
+/***********************
+* Command attachment (routing metadata) tests.
+* Encode/decode round trip test
+* Node hash test (broadcast, stability, no 0 for a node id)
+* Malformed attachment test (length, version)
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "command.h"
+
+void app_main(void)
+{
+    command_t* cmd = command_new(CMD_REXEC_CANCEL, 0, "my_function", 0x0102030405060708ull, "node_123", "");
+    assert(cmd != NULL);
+
+    command_attachment_t att;
+    command_attachment_init(&att, cmd, "node_123", 1);
+    uint8_t raw[COMMAND_ATTACHMENT_LEN];
+    assert(command_attachment_encode(&att, raw) == COMMAND_ATTACHMENT_LEN);
+    assert(raw[0] == COMMAND_ATTACHMENT_VERSION && raw[1] == CMD_REXEC_CANCEL && raw[8] == 0x08 && raw[15] == 0x01);
+
+    command_attachment_t decoded;
+    assert(command_attachment_decode(raw, sizeof(raw), &decoded));
+    assert(decoded.cmd == CMD_REXEC_CANCEL);
+    assert(decoded.priority == 1);
+    assert(decoded.target == command_node_hash("node_123"));
+    assert(decoded.task_id == 0x0102030405060708ull);
+    printf("Round trip test passed \r\n");
+
+    assert(command_node_hash(NULL) == 0);
+    assert(command_node_hash("") == 0);
+    assert(command_node_hash("node_123") != 0);
+    assert(command_node_hash("node_123") == command_node_hash("node_123"));
+    assert(command_node_hash("node_123") != command_node_hash("node_124"));
+    command_attachment_init(&att, cmd, NULL, 0);
+    assert(att.target == 0);
+    printf("Node hash test passed \r\n");
+
+    assert(!command_attachment_decode(raw, sizeof(raw) - 1, &decoded));
+    assert(!command_attachment_decode(NULL, 0, &decoded));
+    raw[0] = COMMAND_ATTACHMENT_VERSION + 1;
+    assert(!command_attachment_decode(raw, sizeof(raw), &decoded));
+    printf("Malformed attachment test passed \r\n");
+
+    command_free(cmd);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
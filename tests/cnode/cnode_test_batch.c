@@ -0,0 +1,145 @@
+/***********************
+* cnode batch (CMD_REXEC_BATCH) tests, on the host (linux target) build.
+* NOTE: Prerequisite test(s): command_batch_test.c, cnode_test_single_task.c, the controller runs in this process over
+* the loopback interface
+* Per batch ACK test (every batch gets its own ACK or REXEC_ERR, the failing ones do not affect the others)
+* Batch result test (one REXEC_RES carrying a result per argument tuple)
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. idf.py --preview set-target linux, run the following code as the main function and check if any asserts are not met.
+2. Build with -DCONTROLLER_PORT=<port> if the default port is taken.
+***********************/
+
+#include "utils.h"
+#include "cnode.h"
+#include "command.h"
+
+#ifndef CONTROLLER_PORT
+#define CONTROLLER_PORT 7461
+#endif
+#define TUPLES 3
+#define NUM_BATCHES 4
+#define WAIT_MS 5000
+
+typedef struct {
+    jamcommand_t cmd;
+    uint64_t task_id;
+    int nargs;
+    int values[TUPLES];
+} reply_t;
+
+static reply_t replies[2 * NUM_BATCHES];
+static volatile uint32_t num_replies;
+
+static void reply_handler(z_loaned_sample_t* sample, void* arg) {
+    z_owned_string_t value;
+    z_bytes_to_string(z_sample_payload(sample), &value);
+    command_t* cmd = command_from_data(NULL, z_string_data(z_string_loan(&value)), (int) z_string_len(z_string_loan(&value)));
+    z_string_drop(z_string_move(&value));
+    if (cmd == NULL) return;
+    if (num_replies < 2 * NUM_BATCHES) {
+        reply_t* reply = &replies[num_replies];
+        reply->cmd = cmd->cmd;
+        reply->task_id = cmd->task_id;
+        reply->nargs = cmd->args != NULL ? cmd->args[0].nargs : 0;
+        for (int i = 0; i < reply->nargs && i < TUPLES; i++) reply->values[i] = cmd->args[i].val.ival;
+        num_replies++;
+    }
+    command_free(cmd);
+}
+
+/* The controller side: listens on the loopback and subscribes to the ACKs, errors and results of the node */
+static zenoh_t* controller_open(void) {
+    zenoh_config_t config;
+    zenoh_config_default(&config);
+    snprintf(config.listen, sizeof(config.listen), "tcp/127.0.0.1:%d", CONTROLLER_PORT);
+    config.connect[0] = '\0';
+    zenoh_t* zn = zenoh_init_with_config(&config);
+    assert(zn != NULL);
+    zenoh_start_read_task(zn);
+    zenoh_start_lease_task(zn);
+    assert(zenoh_subscribe(zn, "app/*/up", reply_handler, NULL) >= 0);
+    return zn;
+}
+
+/**
+ * Stub: doubles its argument.
+*/
+void entry_point_double(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = 2 * ctx->query_args[0].val.ival;
+}
+
+/* Sends a batch of TUPLES arguments through the encoder and the decoder, as the controller would. With doubles the
+   arguments do not match the signature of the task. */
+static void send_batch(cnode_t* cn, const char* fn_name, uint64_t task_id, bool doubles) {
+    arg_t* args = calloc(TUPLES, sizeof(arg_t));
+    for (int k = 0; k < TUPLES; k++) {
+        args[k].nargs = TUPLES;
+        args[k].type = doubles ? DOUBLE_TYPE : INT_TYPE;
+        if (doubles) args[k].val.dval = k; else args[k].val.ival = k;
+    }
+    command_t* encoded = command_new_batch_using_arg(CMD_REXEC_BATCH, 0, fn_name, task_id, cn->node_id,
+                                                     doubles ? "d" : "i", args, TUPLES);
+    assert(encoded != NULL);
+    command_args_free(args);
+    command_t* cmd = command_from_data(NULL, encoded->buffer, encoded->length);
+    command_free(encoded);
+    assert(cmd != NULL && cmd->batch_size == TUPLES);
+    assert(xQueueSendToBack(cn->commandQueue, &cmd, (TickType_t) 10) == pdPASS);
+}
+
+static void wait_for_replies(uint32_t count) {
+    for (int waited_ms = 0; num_replies < count; waited_ms += 10) {
+        assert(waited_ms < WAIT_MS);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static reply_t* find_reply(uint64_t task_id, jamcommand_t type) {
+    reply_t* found = NULL;
+    for (uint32_t i = 0; i < num_replies; i++) {
+        if (replies[i].task_id != task_id || replies[i].cmd != type) continue;
+        assert(found == NULL); // one reply of each type per batch
+        found = &replies[i];
+    }
+    return found;
+}
+
+void app_main(void)
+{
+    zenoh_t* controller = controller_open();
+
+    cnode_t* cn = cnode_init(0, NULL);
+    assert(cn != NULL);
+    cnode_args_t args = {.transport = "tcp", .host = "127.0.0.1", .port = CONTROLLER_PORT};
+    assert(cnode_apply_args(cn, &args, false));
+    assert(cnode_start(cn));
+    tboard_register_task(cn->tboard, task_create("double", INT_TYPE, "i", entry_point_double));
+
+    /* Batches 2 (arguments of the wrong type) and 3 (unknown task) fail, 1 and 4 start */
+    send_batch(cn, "double", 1, false);
+    send_batch(cn, "double", 2, true);
+    send_batch(cn, "missing", 3, false);
+    send_batch(cn, "double", 4, false);
+    wait_for_replies(NUM_BATCHES);
+    assert(find_reply(1, CMD_REXEC_ACK) != NULL && find_reply(1, CMD_REXEC_ERR) == NULL);
+    assert(find_reply(2, CMD_REXEC_ERR) != NULL && find_reply(2, CMD_REXEC_ACK) == NULL);
+    assert(find_reply(3, CMD_REXEC_ERR) != NULL && find_reply(3, CMD_REXEC_ACK) == NULL);
+    assert(find_reply(4, CMD_REXEC_ACK) != NULL && find_reply(4, CMD_REXEC_ERR) == NULL);
+    printf("Per batch ACK test passed \r\n");
+
+    command_t* query = command_new(CMD_GET_REXEC_RES, 0, "double", 1, cn->node_id, "");
+    assert(query != NULL);
+    assert(xQueueSendToBack(cn->commandQueue, &query, (TickType_t) 10) == pdPASS);
+    wait_for_replies(NUM_BATCHES + 1);
+    reply_t* result = find_reply(1, CMD_REXEC_RES);
+    assert(result != NULL && result->nargs == TUPLES);
+    for (int k = 0; k < TUPLES; k++) assert(result->values[k] == 2 * k);
+    printf("Batch result test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
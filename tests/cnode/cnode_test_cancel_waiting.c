@@ -0,0 +1,88 @@
+/***********************
+* Cancellation of a REXEC waiting for an instance slot.
+* NOTE: Prerequisite test(s): cnode_test_single_task.c, tboard_cancel_test.c
+* Waiting REXEC cancelled test (dropped from the wait queue, the REXECs behind it keep their order)
+* Running instance cancelled test (the waiting REXEC starts once the cancelled one finishes, before its result is taken)
+* Result of a finished instance moved out of its slot test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+2. A controller subscribed to app/replies/up sees a REXEC_ERR with REXEC_ERR_CANCELLED for task id 6.
+***********************/
+
+#include "utils.h"
+#include "cnode.h"
+#include "command.h"
+
+#define SPIN_TASK "spin"
+
+/**
+ * Stub: runs until it is cancelled.
+*/
+void entry_point_spin(execution_context_t* ctx) {
+    while (true) {
+        TASK_CHECKPOINT(ctx);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void send_command(cnode_t* cn, jamcommand_t type, uint64_t task_id) {
+    command_t* cmd = command_new(type, 0, SPIN_TASK, task_id, cn->node_id, "");
+    assert(cmd != NULL);
+    assert(xQueueSendToBack(cn->commandQueue, &cmd, (TickType_t) 10) == pdPASS);
+}
+
+static void wait_for_waiting(cnode_t* cn, uint32_t count) {
+    for (int waited_ms = 0; cn->num_waiting != count; waited_ms += 10) {
+        assert(waited_ms < 1000);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void app_main(void)
+{
+    cnode_t* cn = cnode_init(0, NULL);
+    cn->node_id = "node_123";
+    assert(cnode_start(cn));
+    task_t* task = task_create(SPIN_TASK, VOID_TYPE, "", entry_point_spin);
+    task_set_wait_queue(task, 2, 0);
+    tboard_register_task(cn->tboard, task);
+
+    /* Every instance slot taken, task ids MAX_INSTANCES + 1 and + 2 wait */
+    for (uint64_t id = 1; id <= MAX_INSTANCES + 2; id++) {
+        send_command(cn, CMD_REXEC, id);
+    }
+    wait_for_waiting(cn, 2);
+
+    send_command(cn, CMD_REXEC_CANCEL, MAX_INSTANCES + 1);
+    wait_for_waiting(cn, 1);
+    assert(cn->waiting[0].cmd->task_id == MAX_INSTANCES + 2);
+    assert(task->cancellations == 1);
+    assert(task->num_instances == MAX_INSTANCES);
+    printf("Waiting REXEC cancelled test passed \r\n");
+
+    /* The slot of the cancelled instance is free once it finishes, nobody fetched its result */
+    send_command(cn, CMD_REXEC_CANCEL, 1);
+    wait_for_waiting(cn, 0);
+    assert(task->cancellations == 2);
+    assert(task_get_instance_index(task, MAX_INSTANCES + 2) != -1);
+    assert(task_get_instance_index(task, 1) == -1);
+    assert(cn->finished[0] != NULL && cn->finished[0]->serial_id == 1);
+    assert(cn->finished[0]->error == REXEC_ERR_CANCELLED);
+    printf("Running instance cancelled test passed \r\n");
+
+    /* Its result (REXEC_ERR_CANCELLED) is still answered, then the instance is freed */
+    send_command(cn, CMD_GET_REXEC_RES, 1);
+    for (int waited_ms = 0; cn->finished[0] != NULL; waited_ms += 10) {
+        assert(waited_ms < 1000);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    assert(task->num_instances == MAX_INSTANCES);
+    printf("Finished instance result test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,179 @@
+/***********************
+* cnode session loss tests, on the host (linux target) build.
+* NOTE: Prerequisite test(s): cnode_test_single_task.c, the controller runs in this process over the loopback interface
+* Replies reach the controller test
+* Session loss test (the controller goes away, the ACKs of the REXECs received meanwhile wait in the outbox, the result
+* query it left parked is dropped)
+* Outbox flush test (the supervisor reconnects, the outbox is published in order)
+* Stop with a lost session test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. idf.py --preview set-target linux, run the following code as the main function and check if any asserts are not met.
+2. Build with -DCONTROLLER_PORT=<port> if the default port is taken.
+***********************/
+
+#include "utils.h"
+#include "cnode.h"
+#include "command.h"
+
+#ifndef CONTROLLER_PORT
+#define CONTROLLER_PORT 7460
+#endif
+#define REPLY_KEYEXPR "app/replies/up"
+#define LOST_REXECS 3
+#define WAIT_MS (2 * ZENOH_RECONNECT_MAX_MS + ZENOH_SUPERVISOR_PERIOD_MS) // the loss is seen, then at most one attempt at the longest backoff
+
+static volatile bool released = false;
+
+static uint64_t acked[2 + LOST_REXECS];
+static volatile uint32_t num_acked;
+
+static void reply_handler(z_loaned_sample_t* sample, void* arg) {
+    z_owned_string_t value;
+    z_bytes_to_string(z_sample_payload(sample), &value);
+    command_t* cmd = command_from_data(NULL, z_string_data(z_string_loan(&value)), (int) z_string_len(z_string_loan(&value)));
+    z_string_drop(z_string_move(&value));
+    if (cmd == NULL) return;
+    if (cmd->cmd == CMD_REXEC_ACK && num_acked < 2 + LOST_REXECS) {
+        acked[num_acked++] = cmd->task_id;
+    }
+    command_free(cmd);
+}
+
+/* The controller side: listens on the loopback and subscribes to the replies of the node */
+static zenoh_t* controller_open(void) {
+    zenoh_config_t config;
+    zenoh_config_default(&config);
+    snprintf(config.listen, sizeof(config.listen), "tcp/127.0.0.1:%d", CONTROLLER_PORT);
+    config.connect[0] = '\0';
+    zenoh_t* zn = zenoh_init_with_config(&config);
+    assert(zn != NULL);
+    zenoh_start_read_task(zn);
+    zenoh_start_lease_task(zn);
+    assert(zenoh_subscribe(zn, REPLY_KEYEXPR, reply_handler, NULL) >= 0);
+    return zn;
+}
+
+/**
+ * Stub: adds its two arguments.
+*/
+void entry_point_add(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = ctx->query_args[0].val.ival + ctx->query_args[1].val.ival;
+}
+
+/**
+ * Stub: runs until the test releases it.
+*/
+void entry_point_hold(execution_context_t* ctx) {
+    while (!released) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void ignore_reply(z_loaned_reply_t* reply, void* arg) {}
+
+/* Asks for the result of an instance with a query on the result key of the node, as a controller would */
+static void query_result(zenoh_t* controller, cnode_t* cn, const char* fn_name, uint64_t task_id) {
+    command_t* query = command_new(CMD_GET_REXEC_RES, 0, fn_name, task_id, cn->node_id, "");
+    assert(query != NULL);
+    z_view_keyexpr_t ke;
+    assert(z_view_keyexpr_from_str(&ke, cn->result_keyexpr) == Z_OK);
+    z_get_options_t options;
+    z_get_options_default(&options);
+    z_owned_bytes_t payload;
+    z_bytes_copy_from_buf(&payload, query->buffer, query->length);
+    options.payload = z_move(payload);
+    z_owned_closure_reply_t callback;
+    z_closure(&callback, ignore_reply, NULL, NULL);
+    assert(z_get(z_loan(controller->z_session), z_loan(ke), "", z_move(callback), &options) == Z_OK);
+    command_free(query);
+}
+
+static void send_rexec(cnode_t* cn, uint64_t task_id) {
+    command_t* cmd = command_new(CMD_REXEC, 0, "add", task_id, cn->node_id, "ii", 1, 2);
+    assert(cmd != NULL);
+    assert(xQueueSendToBack(cn->commandQueue, &cmd, (TickType_t) 10) == pdPASS);
+}
+
+static bool wait_until(bool (*check)(cnode_t*), cnode_t* cn) {
+    for (int waited_ms = 0; waited_ms < WAIT_MS; waited_ms += 10) {
+        if (check(cn)) return true;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+static bool first_acked(cnode_t* cn) { return num_acked == 1; }
+static bool hold_acked(cnode_t* cn) { return num_acked == 2; }
+static bool session_lost(cnode_t* cn) { return !zenoh_is_connected(cn->zenoh); }
+static bool outbox_full(cnode_t* cn) { return cn->outbox_len == LOST_REXECS; }
+static bool all_acked(cnode_t* cn) { return cn->outbox_len == 0 && num_acked == 2 + LOST_REXECS; }
+static bool session_closed(cnode_t* cn) { return !cn->zenoh->session_open; }
+static bool query_parked(cnode_t* cn) {
+    for (int i = 0; i < CNODE_MAX_PENDING_RESULTS; i++) {
+        if (cn->pending_results[i] != NULL && cn->pending_results[i]->reply_query != NULL) return true;
+    }
+    return false;
+}
+static bool no_query_parked(cnode_t* cn) { return !query_parked(cn); }
+
+void app_main(void)
+{
+    zenoh_t* controller = controller_open();
+
+    cnode_t* cn = cnode_init(0, NULL);
+    assert(cn != NULL);
+    cnode_args_t args = {.transport = "tcp", .host = "127.0.0.1", .port = CONTROLLER_PORT};
+    assert(cnode_apply_args(cn, &args, false));
+    assert(cnode_start(cn));
+    tboard_register_task(cn->tboard, task_create("add", INT_TYPE, "ii", entry_point_add));
+    tboard_register_task(cn->tboard, task_create("hold", VOID_TYPE, "", entry_point_hold));
+
+    send_rexec(cn, 1);
+    assert(wait_until(first_acked, cn));
+    assert(acked[0] == 1);
+    printf("Replies test passed \r\n");
+
+    /* A result query waits for an instance that is still running */
+    command_t* hold = command_new(CMD_REXEC, 0, "hold", 100, cn->node_id, "");
+    assert(hold != NULL);
+    assert(xQueueSendToBack(cn->commandQueue, &hold, (TickType_t) 10) == pdPASS);
+    assert(wait_until(hold_acked, cn));
+    query_result(controller, cn, "hold", 100);
+    assert(wait_until(query_parked, cn));
+
+    /* The controller goes away: the supervisor detects the loss, the ACKs of the REXECs received meanwhile are kept
+       and the parked query, which nobody can receive the reply of anymore, is dropped */
+    zenoh_destroy(controller);
+    assert(wait_until(session_lost, cn));
+    assert(wait_until(no_query_parked, cn));
+    released = true;
+    for (uint64_t id = 2; id < 2 + LOST_REXECS; id++) {
+        send_rexec(cn, id);
+    }
+    assert(wait_until(outbox_full, cn));
+    assert(num_acked == 2 && cn->outbox_drops == 0);
+    printf("Session loss test passed \r\n");
+
+    /* The controller is back: the supervisor reconnects and the processing task flushes the outbox, in order */
+    uint32_t reconnects = cn->zenoh->reconnects;
+    controller = controller_open();
+    assert(wait_until(all_acked, cn));
+    assert(cn->zenoh->reconnects > reconnects);
+    for (uint32_t i = 0; i < LOST_REXECS; i++) {
+        assert(acked[2 + i] == 2 + i);
+    }
+    printf("Outbox flush test passed \r\n");
+
+    /* Lost again and not reopened: its read and lease tasks are gone with the session */
+    zenoh_destroy(controller);
+    assert(wait_until(session_closed, cn));
+    assert(cnode_stop(cn));
+    printf("Stop with a lost session test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
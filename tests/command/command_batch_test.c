@@ -0,0 +1,113 @@
+/***********************
+* Batch command (CMD_REXEC_BATCH) encoding tests.
+* NOTE: Prerequisite test(s): cnode_test_encoder_decoder.c
+* Batch round trip test (batch field, tuples flattened in order)
+* Batch field after the args test (decoding does not depend on the key order)
+* Argument tuples without a batch field rejected test
+* Batch field not matching the number of tuples rejected test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "command.h"
+
+#define TUPLES 3
+#define ARITY 2
+
+/* Encodes a CMD_REXEC_BATCH by hand: TUPLES (int, double) tuples, then a "batch" field holding batch, none if
+   batch is 0 */
+static int encode_by_hand(uint8_t* buffer, int batch) {
+    CborEncoder encoder, mapEncoder, arrayEncoder, tupleEncoder;
+    cbor_encoder_init(&encoder, buffer, HUGE_CMD_STR_LEN, 0);
+    cbor_encoder_create_map(&encoder, &mapEncoder, batch != 0 ? 4 : 3);
+    cbor_encode_text_stringz(&mapEncoder, "cmd");
+    cbor_encode_int(&mapEncoder, CMD_REXEC_BATCH);
+    cbor_encode_text_stringz(&mapEncoder, "fn_name");
+    cbor_encode_text_stringz(&mapEncoder, "scale");
+    cbor_encode_text_stringz(&mapEncoder, "args");
+    cbor_encoder_create_array(&mapEncoder, &arrayEncoder, TUPLES);
+    for (int k = 0; k < TUPLES; k++) {
+        cbor_encoder_create_array(&arrayEncoder, &tupleEncoder, ARITY);
+        cbor_encode_int(&tupleEncoder, k);
+        cbor_encode_double(&tupleEncoder, k + 0.5);
+        cbor_encoder_close_container(&arrayEncoder, &tupleEncoder);
+    }
+    cbor_encoder_close_container(&mapEncoder, &arrayEncoder);
+    if (batch != 0) {
+        cbor_encode_text_stringz(&mapEncoder, "batch");
+        cbor_encode_int(&mapEncoder, batch);
+    }
+    cbor_encoder_close_container(&encoder, &mapEncoder);
+    return (int) cbor_encoder_get_buffer_size(&encoder, buffer);
+}
+
+static void check_tuples(command_t* cmd) {
+    assert(cmd->batch_size == TUPLES);
+    assert(cmd->args != NULL && cmd->args[0].nargs == TUPLES * ARITY);
+    for (int k = 0; k < TUPLES; k++) {
+        assert(cmd->args[k * ARITY].type == INT_TYPE && cmd->args[k * ARITY].val.ival == k);
+        assert(cmd->args[k * ARITY + 1].type == DOUBLE_TYPE && cmd->args[k * ARITY + 1].val.dval == k + 0.5);
+    }
+}
+
+void app_main(void)
+{
+    /* Built with command_new_batch_using_arg() and decoded back */
+    arg_t* args = calloc(TUPLES * ARITY, sizeof(arg_t));
+    for (int k = 0; k < TUPLES; k++) {
+        args[k * ARITY].type = INT_TYPE;
+        args[k * ARITY].val.ival = k;
+        args[k * ARITY + 1].type = DOUBLE_TYPE;
+        args[k * ARITY + 1].val.dval = k + 0.5;
+    }
+    for (int i = 0; i < TUPLES * ARITY; i++) args[i].nargs = TUPLES * ARITY;
+    command_t* encoded = command_new_batch_using_arg(CMD_REXEC_BATCH, 0, "scale", 7, "node_123", "id", args, TUPLES);
+    assert(encoded != NULL);
+    command_args_free(args);
+    check_tuples(encoded);
+    command_t* decoded = command_from_data(NULL, encoded->buffer, encoded->length);
+    assert(decoded != NULL);
+    assert(decoded->cmd == CMD_REXEC_BATCH && decoded->task_id == 7);
+    assert(strcmp(decoded->fn_name, "scale") == 0 && strcmp(decoded->fn_argsig, "id") == 0);
+    check_tuples(decoded);
+    command_free(decoded);
+    command_free(encoded);
+    printf("Batch round trip test passed \r\n");
+
+    /* A controller may send the batch field after the args */
+    uint8_t buffer[HUGE_CMD_STR_LEN];
+    int len = encode_by_hand(buffer, TUPLES);
+    decoded = command_from_data(NULL, buffer, len);
+    assert(decoded != NULL);
+    check_tuples(decoded);
+    command_free(decoded);
+    printf("Batch field after the args test passed \r\n");
+
+    /* Nested arrays are only argument tuples when the batch field says so */
+    len = encode_by_hand(buffer, 0);
+    decoded = command_from_data(NULL, buffer, len);
+    assert(decoded != NULL);
+    assert(decoded->batch_size == 0 && decoded->args == NULL);
+    command_free(decoded);
+    printf("Argument tuples without a batch field rejected test passed \r\n");
+
+    len = encode_by_hand(buffer, TUPLES + 1);
+    decoded = command_from_data(NULL, buffer, len);
+    assert(decoded != NULL);
+    assert(decoded->batch_size == 0 && decoded->args == NULL);
+    command_free(decoded);
+    printf("Batch field not matching the tuples rejected test passed \r\n");
+
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,86 @@
+/***********************
+* Result ownership transfer tests.
+* NOTE: Prerequisite test(s): task_unit.c
+* String result released with the instance test
+* Result moved out of the instance without a copy test
+* Result set from the caller's value copied test
+* Response command takes the result over and releases it once test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "command.h"
+
+/**
+ * Stub: returns a heap allocated string, owned by the instance.
+*/
+void entry_point_greet(execution_context_t* ctx) {
+    char* greeting = calloc(6, sizeof(char));
+    strcpy(greeting, "hello");
+    ctx->return_arg->val.sval = greeting;
+}
+
+static void run(task_instance_t* instance) {
+    execution_context_t ctx = {.query_args = NULL, .return_arg = instance->return_arg};
+    instance->parent_task->entry_point(&ctx);
+}
+
+void app_main(void)
+{
+    task_t* task = task_create("greet", STRING_TYPE, "", entry_point_greet);
+    assert(task != NULL);
+
+    /* Destroying an instance releases its string result */
+    task_instance_t* instance = task_instance_create(task, 0);
+    run(instance);
+    task_instance_destroy(instance);
+    assert(task->num_instances == 0);
+    printf("String result released with the instance test passed \r\n");
+
+    /* Taking the result leaves the instance without one, the pointer is the stub's own buffer */
+    instance = task_instance_create(task, 1);
+    run(instance);
+    arg_t* result_buffer = instance->return_arg;
+    char* greeting = instance->return_arg->val.sval;
+    arg_t* result = task_instance_take_return_arg(instance);
+    assert(result == result_buffer && result->val.sval == greeting);
+    assert(instance->return_arg == NULL);
+    assert(task_instance_take_return_arg(instance) == NULL);
+    task_instance_destroy(instance);
+    printf("Result moved test passed \r\n");
+
+    /* The response encodes the result in place and frees it once */
+    command_t* response = command_new_taking_arg(CMD_REXEC_RES, 0, "greet", 1, "node", "", result);
+    assert(response != NULL && response->args == result && response->length > 0);
+    assert(memmem(response->buffer, response->length, "hello", 5) != NULL);
+    command_free(response);
+    printf("Response takes the result test passed \r\n");
+
+    /* task_instance_set_return_arg() copies the string, the caller's buffer can go away; setting it again releases
+       the previous copy */
+    instance = task_instance_create(task, 2);
+    char value[] = "again";
+    arg_t set = {.type = STRING_TYPE, .nargs = 1, .val.sval = value};
+    task_instance_set_return_arg(instance, &set);
+    assert(instance->return_arg->val.sval != value && strcmp(instance->return_arg->val.sval, "again") == 0);
+    task_instance_set_return_arg(instance, &set);
+    value[0] = 'A';
+    assert(strcmp(instance->return_arg->val.sval, "again") == 0);
+    task_instance_destroy(instance);
+    printf("Result set copied test passed \r\n");
+
+    task_destroy(task);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,111 @@
+/***********************
+* Generated typed stub tests.
+* NOTE: Prerequisite test(s): task_unit.c
+* Argsig and return type generated from the native prototype test
+* Stub reads native arguments and stores a copy of the native return value test
+* Void function stub test
+* Registry descriptor of a generated stub test
+* Invalid argsig rejected at registration test
+* Argument count test (MAX_ARGS arguments accepted, NULL arguments rejected)
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "task_stub.h"
+
+static int calls = 0;
+
+int add(int a, double b) {
+    return a + (int) b;
+}
+TASK_STUB_2(add, INT, INT, DOUBLE)
+
+char* pick(char* first, char* second, int which) {
+    return which == 0 ? first : second;
+}
+TASK_STUB_3(pick, STRING, STRING, STRING, INT)
+
+void bump(void) {
+    calls++;
+}
+TASK_STUB_0(bump, VOID)
+
+TASK_REGISTRY(stub_tasks,
+    TASK_STUB_DESC("add", add),
+    TASK_STUB_DESC("bump", bump),
+);
+
+void app_main(void)
+{
+    assert(strcmp(add_argsig, "if") == 0 && (argtype_t) add_return_type == INT_TYPE);
+    assert(strcmp(pick_argsig, "ssi") == 0 && (argtype_t) pick_return_type == STRING_TYPE);
+    assert(strcmp(bump_argsig, "") == 0 && (argtype_t) bump_return_type == VOID_TYPE);
+    printf("Generated argsig test passed \r\n");
+
+    task_t* add_task = TASK_STUB_CREATE("add", add);
+    assert(add_task != NULL && add_task->entry_point == add_stub);
+    arg_t add_args[2] = {{.nargs = 2, .type = INT_TYPE, .val.ival = 40}, {.nargs = 2, .type = DOUBLE_TYPE, .val.dval = 2.5}};
+    arg_t result = {.nargs = 1, .type = INT_TYPE};
+    execution_context_t ctx = {.query_args = add_args, .return_arg = &result};
+    add_task->entry_point(&ctx);
+    assert(result.val.ival == 42);
+
+    arg_t pick_args[3] = {{.nargs = 3, .type = STRING_TYPE, .val.sval = "left"},
+                          {.nargs = 3, .type = STRING_TYPE, .val.sval = "right"},
+                          {.nargs = 3, .type = INT_TYPE, .val.ival = 1}};
+    ctx.query_args = pick_args;
+    pick_stub(&ctx);
+    assert(strcmp(result.val.sval, "right") == 0);
+    assert(result.val.sval != pick_args[1].val.sval);   // the stub stores a copy the instance owns
+    free(result.val.sval);
+    printf("Typed stub test passed \r\n");
+
+    ctx.query_args = NULL;
+    bump_stub(&ctx);
+    assert(calls == 1);
+    printf("Void stub test passed \r\n");
+
+    assert(TASK_REGISTRY_SIZE(stub_tasks) == 2);
+    assert(stub_tasks[0].entry_point == add_stub && strcmp(stub_tasks[0].fn_argsig, "if") == 0);
+    assert(stub_tasks[1].return_type == VOID_TYPE);
+    printf("Registry descriptor test passed \r\n");
+
+    assert(task_create("bad", INT_TYPE, "ix", add_stub) == NULL);
+    assert(task_create("bad", INT_TYPE, NULL, add_stub) == NULL);
+    printf("Invalid argsig test passed \r\n");
+
+    /* A task registered with MAX_ARGS arguments can be invoked */
+    char wide_argsig[MAX_ARGS + 1];
+    memset(wide_argsig, 'i', MAX_ARGS);
+    wide_argsig[MAX_ARGS] = '\0';
+    task_t* wide_task = task_create("wide", INT_TYPE, wide_argsig, add_stub);
+    assert(wide_task != NULL);
+    arg_t wide_args[MAX_ARGS];
+    for (int i = 0; i < MAX_ARGS; i++) {
+        wide_args[i] = (arg_t) {.nargs = MAX_ARGS, .type = INT_TYPE, .val.ival = i};
+    }
+    task_instance_t* wide_instance = task_instance_create(wide_task, 1);
+    assert(wide_instance != NULL);
+    assert(task_instance_set_args(wide_instance, wide_args));
+    task_instance_destroy(wide_instance);
+    wide_instance = task_instance_create(wide_task, 2);
+    assert(!task_instance_set_args(wide_instance, NULL));
+    task_instance_destroy(wide_instance);
+    task_destroy(wide_task);
+    printf("Argument count test passed \r\n");
+
+    task_destroy(add_task);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
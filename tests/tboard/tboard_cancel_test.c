@@ -0,0 +1,91 @@
+/***********************
+* tboard cancellation and timeout tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Cooperative cancellation test (TASK_CHECKPOINT)
+* Execution timeout test (forced deletion of a stub without checkpoints)
+* Shutdown test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+/**
+ * Stub: runs until cancelled, checking for cancellation every 10 ms.
+*/
+void entry_point_spin(execution_context_t* ctx) {
+    while (true) {
+        TASK_CHECKPOINT(ctx);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * Stub: hangs without any cancellation point.
+*/
+void entry_point_hang(execution_context_t* ctx) {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void app_main(void)
+{
+    task_t* spin_task = task_create("spin", VOID_TYPE, "", entry_point_spin);
+    task_t* hang_task = task_create("hang", VOID_TYPE, "", entry_point_hang);
+    task_set_timeout(hang_task, 200);
+    tboard_t* tboard = tboard_create();
+    tboard_register_task(tboard, spin_task);
+    tboard_register_task(tboard, hang_task);
+
+    task_instance_t* spin = tboard_start_task(tboard, "spin", 0, NULL);
+    assert(spin != NULL);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    assert(spin->is_running);
+    assert(tboard_cancel_task(tboard, "spin", 0));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    assert(spin->has_finished);
+    assert(spin->error == REXEC_ERR_CANCELLED);
+    assert(spin_task->cancellations == 1);
+    assert(!tboard_cancel_task(tboard, "spin", 0)); // already finished
+    task_instance_destroy(spin);
+    printf("Cooperative cancellation test passed \r\n");
+
+    task_instance_t* hang = tboard_start_task(tboard, "hang", 0, NULL);
+    assert(hang != NULL);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    assert(!hang->has_finished); // timed out, but still in its grace period
+    assert(hang->cancel_requested);
+    vTaskDelay(pdMS_TO_TICKS(TBOARD_CANCEL_GRACE_MS));
+    assert(hang->has_finished);
+    assert(hang->error == REXEC_ERR_TIMEOUT);
+    assert(hang_task->timeouts == 1);
+    assert(tboard->dispatcher.num_running == 0);
+    task_instance_destroy(hang);
+    printf("Execution timeout test passed \r\n");
+
+    spin = tboard_start_task(tboard, "spin", 1, NULL);
+    assert(spin != NULL);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    tboard_shutdown(tboard);
+    assert(spin->has_finished);
+    assert(spin->error == REXEC_ERR_CANCELLED);
+    assert(tboard->dispatcher.num_running == 0);
+    printf("Shutdown test passed \r\n");
+
+    tboard_print_tasks(tboard);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
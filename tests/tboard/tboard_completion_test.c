@@ -0,0 +1,107 @@
+/***********************
+* tboard completion ring tests.
+* NOTE: Prerequisite test(s): tboard_unit.c, tboard_cancel_test.c
+* One completion event per finished instance test (serial id, task, error)
+* Dropped and cancelled instances reported with their error code test
+* Ring overflow counted once the consumer falls behind test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+#define NUM_INSTANCES 4
+
+/**
+ * Stub: returns its argument.
+*/
+void entry_point_echo(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = ctx->query_args[0].val.ival;
+}
+
+/**
+ * Stub: runs until it is cancelled.
+*/
+void entry_point_spin(execution_context_t* ctx) {
+    while (true) {
+        TASK_CHECKPOINT(ctx);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void app_main(void)
+{
+    task_t* echo_task = task_create("echo", INT_TYPE, "i", entry_point_echo);
+    task_t* spin_task = task_create("spin", VOID_TYPE, "", entry_point_spin);
+    tboard_t* tboard = tboard_create();
+    tboard_register_task(tboard, echo_task);
+    tboard_register_task(tboard, spin_task);
+
+    /* Every instance that returns is reported once */
+    arg_t args[NUM_INSTANCES];
+    task_instance_t* instances[NUM_INSTANCES];
+    for (int i = 0; i < NUM_INSTANCES; i++) {
+        args[i] = (arg_t) {.nargs = 1, .type = INT_TYPE, .val.ival = i};
+        instances[i] = tboard_start_task(tboard, "echo", i, &args[i]);
+        assert(instances[i] != NULL);
+    }
+    for (int i = 0; i < NUM_INSTANCES; i++) {
+        while (!instances[i]->has_finished) vTaskDelay(1);
+    }
+    completion_event_t event;
+    bool seen[NUM_INSTANCES] = {false};
+    for (int i = 0; i < NUM_INSTANCES; i++) {
+        assert(tboard_poll_completion(tboard, &event));
+        assert(event.task == echo_task && event.serial_id < NUM_INSTANCES && !seen[event.serial_id]);
+        assert(event.error == REXEC_ERR_NONE);
+        seen[event.serial_id] = true;
+    }
+    assert(!tboard_poll_completion(tboard, &event));
+    assert(tboard->num_dead_tasks == NUM_INSTANCES);
+    for (int i = 0; i < NUM_INSTANCES; i++) {
+        assert(instances[i]->return_arg->val.ival == i);
+        task_instance_destroy(instances[i]);
+    }
+    printf("Completion events test passed \r\n");
+
+    /* Cancelled instances carry their error code */
+    task_instance_t* spin = tboard_start_task(tboard, "spin", 0, NULL);
+    assert(spin != NULL);
+    sleep(1);
+    assert(tboard_cancel_task(tboard, "spin", 0));
+    while (!spin->has_finished) vTaskDelay(1);
+    assert(tboard_poll_completion(tboard, &event));
+    assert(event.task == spin_task && event.serial_id == 0 && event.error == REXEC_ERR_CANCELLED);
+    task_instance_destroy(spin);
+    printf("Cancelled completion event test passed \r\n");
+
+    /* Nobody drains the ring: it fills up and the lost events are counted */
+    uint32_t serial = 0;
+    for (int n = 0; n < COMPLETION_RING_SIZE + 2; n++) {
+        task_instance_t* instance = tboard_start_task(tboard, "echo", serial++, &args[0]);
+        assert(instance != NULL);
+        while (!instance->has_finished) vTaskDelay(1);
+        task_instance_destroy(instance);
+    }
+    assert(tboard->completions.overflows == 2);
+    for (int n = 0; n < COMPLETION_RING_SIZE; n++) {
+        assert(tboard_poll_completion(tboard, &event));
+    }
+    assert(!tboard_poll_completion(tboard, &event));
+    printf("Completion ring overflow test passed \r\n");
+
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
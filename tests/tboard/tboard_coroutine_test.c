@@ -0,0 +1,91 @@
+/***********************
+* tboard coroutine execution mode tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Switch task to coroutine mode test
+* Start many coroutine instances test (more than MAX_INSTANCES)
+* Coroutine sleep/yield/await test (return values)
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+#define NUM_CO_INSTANCES 40
+
+/**
+ * Locals of the coroutine that must survive a yield
+*/
+typedef struct _count_state_t {
+    int i;
+    int total;
+} count_state_t;
+
+static volatile int released = 0;
+
+/**
+ * Coroutine stub: counts to n, sleeping between steps, then waits until the test releases it.
+*/
+void entry_point_count(execution_context_t* ctx) {
+    count_state_t* st = TASK_CO_LOCALS(ctx, count_state_t);
+    TASK_CO_BEGIN(ctx);
+    st->total = 0;
+    for (st->i = 0; st->i < ctx->query_args[0].val.ival; st->i++) {
+        st->total += st->i;
+        TASK_CO_SLEEP_MS(ctx, 10);
+        TASK_CO_YIELD(ctx);
+    }
+    TASK_CO_AWAIT(ctx, released);
+    ctx->return_arg->val.ival = st->total;
+    TASK_CO_END(ctx);
+}
+
+void app_main(void)
+{
+    task_t* task = task_create("count", INT_TYPE, "i", entry_point_count);
+    assert(task != NULL);
+    assert(task->max_instances == MAX_INSTANCES);
+    assert(task_set_coroutine_mode(task, sizeof(count_state_t)));
+    assert(task->exec_mode == TASK_EXEC_COROUTINE);
+    assert(task->max_instances == MAX_CO_INSTANCES);
+    printf("Switch task to coroutine mode test passed \r\n");
+
+    tboard_t* tboard = tboard_create();
+    tboard_register_task(tboard, task);
+
+    arg_t args[NUM_CO_INSTANCES];
+    task_instance_t* instances[NUM_CO_INSTANCES];
+    for (int i = 0; i < NUM_CO_INSTANCES; i++) {
+        args[i] = (arg_t) {.nargs = 1, .type = INT_TYPE, .val.ival = i};
+        instances[i] = tboard_start_task(tboard, "count", i, &args[i]);
+        assert(instances[i] != NULL);
+    }
+    assert(task->num_instances == NUM_CO_INSTANCES);
+    printf("Start many coroutine instances test passed \r\n");
+
+    /* Everything blocks on the await until released */
+    sleep(2);
+    for (int i = 0; i < NUM_CO_INSTANCES; i++) assert(!instances[i]->has_finished);
+    released = 1;
+    for (int i = 0; i < NUM_CO_INSTANCES; i++) {
+        while (!instances[i]->has_finished) vTaskDelay(1);
+        assert(instances[i]->return_arg->val.ival == i * (i - 1) / 2);
+    }
+    assert(tboard->num_dead_tasks == NUM_CO_INSTANCES);
+    printf("Coroutine sleep/yield/await test passed \r\n");
+
+    tboard_print_tasks(tboard);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
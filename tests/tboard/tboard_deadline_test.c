@@ -0,0 +1,108 @@
+/***********************
+* tboard deadline (EDF) scheduling tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Running instances with a deadline capped at TBOARD_MAX_RUNNING test
+* Instance without a deadline not capped test
+* Earliest deadline first dispatch order test
+* Expired instance dropped test (error code, deadline_drops counter)
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+static volatile int released = 0;
+static volatile int order = 0;
+
+/**
+ * Stub: keeps its execution slot until the test releases it.
+*/
+void entry_point_hold(execution_context_t* ctx) {
+    while (!released) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * Stub: returns the order in which it was started.
+*/
+void entry_point_order(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = order++;
+}
+
+void app_main(void)
+{
+    task_t* hold_task = task_create("hold", VOID_TYPE, "", entry_point_hold);
+    task_t* order_task = task_create("order", INT_TYPE, "", entry_point_order);
+    tboard_t* tboard = tboard_create();
+    tboard_register_task(tboard, hold_task);
+    tboard_register_task(tboard, order_task);
+
+    /* Occupy every execution slot of the instances with a deadline */
+    int64_t now = jam_time_us();
+    tboard_start_options_t opts;
+    tboard_start_options_default(&opts);
+    opts.deadline_us = now + 60000000;
+    task_instance_t* holds[TBOARD_MAX_RUNNING];
+    for (int i = 0; i < TBOARD_MAX_RUNNING; i++) {
+        holds[i] = tboard_start_task_opts(tboard, "hold", i, NULL, &opts);
+        assert(holds[i] != NULL);
+    }
+
+    /* Queued behind the holds, deadlines given out of order */
+    int64_t deadlines[4] = {now + 5000000, now + 3000000, now + 100000, now + 4000000};
+    task_instance_t* instances[4];
+    for (int i = 0; i < 4; i++) {
+        opts.deadline_us = deadlines[i];
+        instances[i] = tboard_start_task_opts(tboard, "order", i, NULL, &opts);
+        assert(instances[i] != NULL);
+    }
+    sleep(1);
+    assert(tboard->dispatcher.num_running == TBOARD_MAX_RUNNING);
+    assert(tboard->dispatcher.num_deadline_running == TBOARD_MAX_RUNNING);
+    assert(tboard->dispatcher.deadline_queue.size == 4);
+    for (int i = 0; i < 4; i++) assert(!instances[i]->is_running && !instances[i]->has_finished);
+    printf("Running instances capped test passed \r\n");
+
+    /* No deadline: runs at once next to the holds */
+    task_instance_t* free_run = tboard_start_task(tboard, "order", 4, NULL);
+    assert(free_run != NULL);
+    while (!free_run->has_finished) vTaskDelay(1);
+    assert(free_run->error == REXEC_ERR_NONE && free_run->return_arg->val.ival == 0);
+    assert(tboard->dispatcher.deadline_queue.size == 4 && tboard->dispatcher.fifo_queue.size == 0);
+    printf("Instance without a deadline not capped test passed \r\n");
+
+    /* Free the slots, the 100 ms deadline has passed by now */
+    released = 1;
+    for (int i = 0; i < 4; i++) {
+        while (!instances[i]->has_finished) vTaskDelay(1);
+    }
+    assert(instances[1]->error == REXEC_ERR_NONE && instances[1]->return_arg->val.ival == 1);
+    assert(instances[3]->error == REXEC_ERR_NONE && instances[3]->return_arg->val.ival == 2);
+    assert(instances[0]->error == REXEC_ERR_NONE && instances[0]->return_arg->val.ival == 3);
+    printf("Earliest deadline first order test passed \r\n");
+
+    assert(instances[2]->error == REXEC_ERR_DEADLINE_EXPIRED);
+    assert(order_task->deadline_drops == 1);
+    assert(order_task->deadline_misses == 0);
+    printf("Expired instance dropped test passed \r\n");
+
+    for (int i = 0; i < TBOARD_MAX_RUNNING; i++) {
+        while (!holds[i]->has_finished) vTaskDelay(1);
+    }
+    tboard_print_tasks(tboard);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,111 @@
+/***********************
+* tboard in-process invocation tests.
+* NOTE: Prerequisite test(s): tboard_unit.c, tboard_cancel_test.c
+* Future based invocation test (wait, then take the result)
+* Reserved serial id rejected test
+* Polled future test
+* Synchronous invocation test
+* Synchronous invocation timing out test (instance cancelled)
+* Unknown task test
+* Synchronous invocation from a task instance rejected test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+/**
+ * Stub: adds its two arguments.
+*/
+void entry_point_add(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = ctx->query_args[0].val.ival + ctx->query_args[1].val.ival;
+}
+
+/**
+ * Stub: runs until it is cancelled.
+*/
+void entry_point_spin(execution_context_t* ctx) {
+    while (true) {
+        TASK_CHECKPOINT(ctx);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static tboard_t* tboard;
+
+/**
+ * Stub: invokes add synchronously from its own instance, returns the outcome.
+*/
+void entry_point_nested(execution_context_t* ctx) {
+    arg_t* result = NULL;
+    ctx->return_arg->val.ival = tboard_invoke_sync(tboard, "add", ctx->query_args, &result, 100);
+    if (result != NULL) command_args_free(result);
+}
+
+void app_main(void)
+{
+    tboard = tboard_create();
+    tboard_register_task(tboard, task_create("add", INT_TYPE, "ii", entry_point_add));
+    tboard_register_task(tboard, task_create("spin", VOID_TYPE, "", entry_point_spin));
+    tboard_register_task(tboard, task_create("nested", INT_TYPE, "ii", entry_point_nested));
+    arg_t args[2] = {{.nargs = 2, .type = INT_TYPE, .val.ival = 40}, {.nargs = 2, .type = INT_TYPE, .val.ival = 2}};
+
+    tboard_future_t future;
+    assert(tboard_invoke(tboard, "add", args, &future));
+    assert(future.instance != NULL && (future.instance->serial_id & TBOARD_INTERNAL_SERIAL_BASE) != 0);
+    assert(tboard_future_wait(&future, 1000));
+    assert(tboard_future_ready(&future));
+    arg_t* result = NULL;
+    assert(tboard_future_get(&future, &result) == REXEC_ERR_NONE);
+    assert(result != NULL && result->val.ival == 42);
+    assert(future.instance == NULL);
+    command_args_free(result);
+    printf("Future invocation test passed \r\n");
+
+    /* The serial ids of the invoked instances are not available to tboard_start_task() callers (REXECs) */
+    assert(tboard_start_task(tboard, "add", (int) TBOARD_INTERNAL_SERIAL_BASE, args) == NULL);
+    assert(tboard_start_task(tboard, "add", (int) (TBOARD_INTERNAL_SERIAL_BASE | 1), args) == NULL);
+    printf("Reserved serial id rejected test passed \r\n");
+
+    assert(tboard_invoke(tboard, "add", args, &future));
+    while (!tboard_future_ready(&future)) vTaskDelay(1);
+    assert(tboard_future_wait(&future, 1)); // already over
+    assert(tboard_future_get(&future, NULL) == REXEC_ERR_NONE);
+    printf("Polled future test passed \r\n");
+
+    args[1].val.ival = 60;
+    assert(tboard_invoke_sync(tboard, "add", args, &result, 0) == REXEC_ERR_NONE);
+    assert(result->val.ival == 100);
+    command_args_free(result);
+    printf("Synchronous invocation test passed \r\n");
+
+    assert(tboard_invoke_sync(tboard, "spin", NULL, &result, 50) == REXEC_ERR_TIMEOUT);
+    assert(result == NULL);
+    assert(tboard_find_task_name(tboard, "spin")->cancellations == 1);
+    assert(tboard_find_task_name(tboard, "spin")->num_instances == 0);
+    printf("Synchronous timeout test passed \r\n");
+
+    assert(!tboard_invoke(tboard, "sub", args, &future));
+    assert(tboard_invoke_sync(tboard, "sub", args, &result, 0) == REXEC_ERR_FAILED);
+    printf("Unknown task test passed \r\n");
+
+    assert(tboard_invoke_sync(tboard, "nested", args, &result, 1000) == REXEC_ERR_NONE);
+    assert(result->val.ival == REXEC_ERR_FAILED);
+    command_args_free(result);
+    printf("Nested synchronous invocation test passed \r\n");
+
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,91 @@
+/***********************
+* tboard periodic task tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Register/find periodic task test
+* Periodic releases test (number of releases, arguments, jitter statistics)
+* Overrun test (release skipped while the previous one still runs)
+* Unregister test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+static volatile int ticks = 0;
+static volatile int slow_runs = 0;
+
+/**
+ * Stub: adds its argument to the tick counter.
+*/
+void entry_point_tick(execution_context_t* ctx) {
+    ticks += ctx->query_args[0].val.ival;
+}
+
+/**
+ * Stub: takes longer than its period.
+*/
+void entry_point_slow(execution_context_t* ctx) {
+    slow_runs++;
+    vTaskDelay(pdMS_TO_TICKS(250));
+}
+
+void app_main(void)
+{
+    task_t* tick_task = task_create("tick", VOID_TYPE, "i", entry_point_tick);
+    task_t* slow_task = task_create("slow", VOID_TYPE, "", entry_point_slow);
+    tboard_t* tboard = tboard_create();
+    tboard_register_task(tboard, tick_task);
+    tboard_register_task(tboard, slow_task);
+
+    arg_t tick_args[1] = {{.nargs = 1, .type = INT_TYPE, .val.ival = 2}};
+    assert(!tboard_register_periodic(tboard, "tick", NULL, 100, 0, 10)); // argument mismatch
+    assert(tboard_register_periodic(tboard, "tick", tick_args, 100, 50, 10));
+    assert(!tboard_register_periodic(tboard, "tick", tick_args, 100, 0, 10)); // already periodic
+    assert(tboard_register_periodic(tboard, "slow", NULL, 100, 0, 10));
+    tboard_periodic_t* tick = tboard_find_periodic(tboard, "tick");
+    tboard_periodic_t* slow = tboard_find_periodic(tboard, "slow");
+    assert(tick != NULL && tick->task == tick_task);
+    assert(slow != NULL && slow->task == slow_task);
+    printf("Register/find periodic task test passed \r\n");
+
+    /* Releases at 50, 150, ..., 950 ms */
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    assert(tick->releases >= 9 && tick->releases <= 11);
+    assert(ticks >= 2 * (tick->releases - 1));
+    assert(tick->overruns == 0);
+    assert(tick->max_jitter_us >= 0);
+    printf("Periodic releases test passed \r\n");
+
+    /* slow needs 250 ms per release, so about two out of three releases are skipped */
+    assert(slow->overruns >= slow->releases);
+    assert(slow_runs == slow->releases || slow_runs == slow->releases - 1);
+    printf("Overrun test passed \r\n");
+
+    assert(tboard_unregister_periodic(tboard, "tick"));
+    assert(tboard_unregister_periodic(tboard, "slow"));
+    assert(tboard_find_periodic(tboard, "tick") == NULL);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    int ticks_after = ticks;
+    vTaskDelay(pdMS_TO_TICKS(300));
+    assert(ticks == ticks_after);
+    /* The last releases have been reaped */
+    assert(tick_task->num_instances == 0);
+    assert(slow_task->num_instances == 0);
+    printf("Unregister test passed \r\n");
+
+    tboard_print_tasks(tboard);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
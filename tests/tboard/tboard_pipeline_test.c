@@ -0,0 +1,96 @@
+/***********************
+* tboard local pipeline tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Register pipeline test (signature of the pipeline task, rejected chains)
+* Run pipeline test (result of each stage passed to the next one)
+* Rejected chains test (unregistered chain name, pipeline used as a stage)
+* String intermediate result test (freed once the next stage returned)
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+void entry_point_square(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = ctx->query_args[0].val.ival * ctx->query_args[0].val.ival;
+}
+
+void entry_point_inc(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = ctx->query_args[0].val.ival + 1;
+}
+
+void entry_point_halve(execution_context_t* ctx) {
+    ctx->return_arg->val.dval = ctx->query_args[0].val.ival / 2.0;
+}
+
+void entry_point_label(execution_context_t* ctx) {
+    char label[16];
+    snprintf(label, sizeof(label), "n=%d", ctx->query_args[0].val.ival);
+    ctx->return_arg->val.sval = task_return_string(label); // strlen + 1 bytes, as free() accounts for
+}
+
+void entry_point_length(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = strlen(ctx->query_args[0].val.sval);
+}
+
+void app_main(void)
+{
+    tboard_t* tboard = tboard_create();
+    tboard_register_task(tboard, task_create("square", INT_TYPE, "i", entry_point_square));
+    tboard_register_task(tboard, task_create("inc", INT_TYPE, "i", entry_point_inc));
+    tboard_register_task(tboard, task_create("halve", DOUBLE_TYPE, "i", entry_point_halve));
+    tboard_register_task(tboard, task_create("label", STRING_TYPE, "i", entry_point_label));
+    tboard_register_task(tboard, task_create("length", INT_TYPE, "s", entry_point_length));
+
+    task_t* pipeline = tboard_register_pipeline(tboard, "preprocess", "square|inc|halve");
+    assert(pipeline != NULL);
+    assert(tboard_find_task_name(tboard, "preprocess") == pipeline);
+    assert(strcmp(pipeline->fn_argsig, "i") == 0);
+    assert(pipeline->return_type == DOUBLE_TYPE);
+    assert(tboard_register_pipeline(tboard, "bad_types", "halve|inc") == NULL);
+    assert(tboard_register_pipeline(tboard, "bad_stage", "square|missing") == NULL);
+    assert(tboard_register_pipeline(tboard, "preprocess", "inc") == NULL);
+    printf("Register pipeline test passed \r\n");
+
+    arg_t args[1] = {{.nargs = 1, .type = INT_TYPE, .val.ival = 3}};
+    task_instance_t* instance = tboard_start_task(tboard, "preprocess", 0, args);
+    assert(instance != NULL);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->return_arg->type == DOUBLE_TYPE);
+    assert(instance->return_arg->val.dval == 5.0);
+    task_instance_destroy(instance);
+    printf("Run pipeline test passed \r\n");
+
+    /* A REXEC naming a chain does not register it */
+    arg_t chain_args[1] = {{.nargs = 1, .type = INT_TYPE, .val.ival = 40}};
+    assert(tboard_start_task(tboard, "inc|inc", 1, chain_args) == NULL);
+    assert(tboard_find_task_name(tboard, "inc|inc") == NULL);
+    assert(tboard_register_pipeline(tboard, "nested", "preprocess|inc") == NULL);
+    printf("Rejected chains test passed \r\n");
+
+    assert(tboard_register_pipeline(tboard, "label_length", "inc|label|length") != NULL);
+    int32_t mem_before = total_mem_usage;
+    instance = tboard_start_task(tboard, "label_length", 2, chain_args);
+    assert(instance != NULL);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->return_arg->val.ival == 4); // "n=41"
+    task_instance_destroy(instance);
+    assert(total_mem_usage == mem_before);
+    printf("String intermediate result test passed \r\n");
+
+    tboard_print_tasks(tboard);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,97 @@
+/***********************
+* tboard compile-time task registry tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Compile-time name hash test (matches jam_name_hash())
+* Nothing allocated when the registry is set test
+* task_t created on first use with the descriptor attributes test
+* Unknown name test
+* Unsorted registry rejected test (DEBUG builds only)
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+/**
+ * Stub: adds its two arguments.
+*/
+void entry_point_add(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = ctx->query_args[0].val.ival + ctx->query_args[1].val.ival;
+}
+
+/**
+ * Stub: returns a constant.
+*/
+void entry_point_answer(execution_context_t* ctx) {
+    ctx->return_arg->val.ival = 42;
+}
+
+TASK_REGISTRY(app_tasks,
+    TASK_DESC("add", INT_TYPE, "ii", entry_point_add),
+    TASK_DESC_COROUTINE("answer", INT_TYPE, "", entry_point_answer, 16),
+    TASK_DESC_FULL("slow_answer", INT_TYPE, "", entry_point_answer, TASK_EXEC_THREAD, 0, 250),
+);
+
+#ifdef DEBUG
+TASK_REGISTRY(unsorted_tasks,
+    TASK_DESC("b", INT_TYPE, "", entry_point_answer),
+    TASK_DESC("a", INT_TYPE, "", entry_point_answer),
+);
+#endif
+
+void app_main(void)
+{
+    for (int i = 0; i < TASK_REGISTRY_SIZE(app_tasks); i++) {
+        assert(app_tasks[i].name_hash == jam_name_hash(app_tasks[i].name));
+    }
+    printf("Compile-time name hash test passed \r\n");
+
+#ifdef DEBUG
+    tboard_t* other = tboard_create();
+    assert(!tboard_set_registry(other, unsorted_tasks, TASK_REGISTRY_SIZE(unsorted_tasks)));
+    tboard_destroy(other);
+    printf("Unsorted registry test passed \r\n");
+#endif
+
+    tboard_t* tboard = tboard_create();
+    int32_t mem_before = total_mem_usage;
+    assert(tboard_set_registry(tboard, app_tasks, TASK_REGISTRY_SIZE(app_tasks)));
+    assert(tboard->num_tasks == 0);
+    assert(total_mem_usage == mem_before);
+    printf("Registry set without allocation test passed \r\n");
+
+    arg_t args[2] = {{.nargs = 2, .type = INT_TYPE, .val.ival = 40}, {.nargs = 2, .type = INT_TYPE, .val.ival = 2}};
+    task_instance_t* instance = tboard_start_task(tboard, "add", 0, args);
+    assert(instance != NULL);
+    assert(tboard->num_tasks == 1);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->return_arg->val.ival == 42);
+    task_instance_destroy(instance);
+
+    task_t* answer = tboard_find_task_name(tboard, "answer");
+    assert(answer != NULL && answer->exec_mode == TASK_EXEC_COROUTINE && answer->co_locals_size == 16);
+    assert(tboard_find_task_name(tboard, "answer") == answer);
+    task_t* slow_answer = tboard_find_task_name(tboard, "slow_answer");
+    assert(slow_answer != NULL && slow_answer->timeout_ms == 250);
+    assert(tboard->num_tasks == 3);
+    printf("Task created on first use test passed \r\n");
+
+    assert(tboard_find_task_name(tboard, "sub") == NULL);
+    assert(tboard_start_task(tboard, "sub", 0, NULL) == NULL);
+    printf("Unknown name test passed \r\n");
+
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,368 @@
+/***********************
+* Host-only simulation of the tboard dispatching, on a virtual clock.
+* NOTE: Prerequisite test(s): none, runs on the host without FreeRTOS
+* A scripted or generated trace of REXEC arrivals (task, synthetic duration, relative deadline) is played against the
+* dispatcher of the tboard: the instances go through the same sched_dispatcher_t calls as in _tboard_queue_instance_locked(),
+* _tboard_dispatch() and _tboard_check_running(), with the virtual time as now. Around it the simulation keeps the
+* per-task instance limit and, as the cnode does, moves a finished instance out of its slot (up to CNODE_MAX_FINISHED of
+* them) when a REXEC needs the slot before the controller fetched the result. A running instance gets the stack
+* tboard_get_task_stack_size() would give it from the stack profile of its task. Time only advances from one event to the
+* next, so hours of traffic are simulated in milliseconds and every run of a trace gives the same report.
+* Scripted trace: EDF saves the urgent REXEC that FIFO drops test
+* Instance limit and ready queue capacity rejections test
+* Instances without a deadline not capped by the deadline slots test
+* Finished instance moved out of its slot, or held until its result is fetched test
+* Adaptive stack test (stack of the running instances from the stack profile)
+* Deterministic report test (same trace, same report)
+* Policy / execution slot comparison on a generated trace (printed report)
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. gcc -std=gnu11 -O2 -Iinc tests/tboard/tboard_sim_test.c src/sched.c -o tboard_sim && ./tboard_sim
+2. Check that no assert fails, then compare the reports of the policies and slot counts.
+***********************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "sched.h"
+
+#define SIM_MAX_ARRIVALS 20000
+#define SIM_MAX_TASKS 8
+#define SIM_MAX_THREADS 32          // TBOARD_MAX_THREADS
+#define SIM_DEFAULT_SLOTS 4         // TBOARD_MAX_RUNNING
+#define SIM_DEFAULT_INSTANCES 5     // MAX_INSTANCES
+#define SIM_FINISHED_CAPACITY 16    // CNODE_MAX_FINISHED
+#define SIM_STACK_SIZE 2048         // TASK_STACK_SIZE
+#define SIM_STACK_MIN_SIZE 1024     // TASK_STACK_MIN_SIZE
+#define SIM_STACK_MARGIN 512        // TASK_STACK_MARGIN
+#define SIM_NO_DEADLINE 0
+
+/* One REXEC of the trace */
+typedef struct {
+    uint64_t at_us;             // arrival time
+    uint32_t task;              // index of the task
+    uint64_t duration_us;       // synthetic execution time
+    uint64_t deadline_us;       // relative deadline, SIM_NO_DEADLINE if none
+} sim_arrival_t;
+
+/* Simulated instance, queued, running or waiting for its result to be fetched */
+typedef struct {
+    const sim_arrival_t* arrival;
+    uint64_t deadline;          // absolute deadline, SCHED_NO_DEADLINE if none
+    uint64_t start_us;
+    uint64_t end_us;
+    uint64_t release_us;        // result fetched, the instance is destroyed
+    uint32_t stack_bytes;       // stack given to the running instance
+    bool detached;              // moved out of the instance table of its task, see task_instance_detach()
+} sim_instance_t;
+
+typedef struct {
+    sched_policy_t policy;      // order of the instances with a deadline
+    uint32_t slots;             // execution slots of the instances with a deadline
+    uint32_t max_instances;     // live instances per task
+    uint32_t finished_capacity; // finished instances the cnode can move out of their slot
+    uint64_t fetch_delay_us;    // from the end of an instance to the GET_REXEC_RES that releases it
+    bool adaptive_stack;        // see tboard_set_adaptive_stack()
+    uint32_t stack_used[SIM_MAX_TASKS]; // stack profile: high-water mark of each task, 0 if not measured yet
+} sim_config_t;
+
+typedef struct {
+    uint32_t arrivals;
+    uint32_t completed;
+    uint32_t dropped;           // deadline passed while queued
+    uint32_t rejected;          // instance table of the task or ready queue full
+    uint32_t late;              // completed after the deadline
+    uint64_t makespan_us;       // virtual time of the last completion
+    uint64_t wait_p50_us, wait_p90_us, wait_p99_us, wait_max_us;
+    uint32_t peak_live;         // queued + running + unfetched instances
+    uint32_t peak_queued;
+    uint32_t peak_stack_bytes;  // stacks of the running instances
+} sim_report_t;
+
+static sim_instance_t instances[SIM_MAX_ARRIVALS];
+static sim_instance_t* unfetched[SIM_MAX_ARRIVALS];
+static uint64_t waits[SIM_MAX_ARRIVALS];
+
+/* Same rule as tboard_get_task_stack_size() */
+static uint32_t sim_stack_size(const sim_config_t* config, uint32_t task) {
+    if (!config->adaptive_stack || config->stack_used[task] == 0) return SIM_STACK_SIZE;
+    uint32_t stack_size = config->stack_used[task] + SIM_STACK_MARGIN;
+    return stack_size < SIM_STACK_MIN_SIZE ? SIM_STACK_MIN_SIZE : stack_size;
+}
+
+/* An instance is over (completed or dropped): it is kept until its result is fetched */
+static void sim_finish(const sim_config_t* config, sim_instance_t* instance, uint64_t now, uint32_t* num_unfetched) {
+    instance->release_us = now + config->fetch_delay_us;
+    unfetched[(*num_unfetched)++] = instance;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t* sorted, uint32_t n, uint32_t pct) {
+    if (n == 0) return 0;
+    return sorted[(uint64_t) (n - 1) * pct / 100];
+}
+
+/* Plays the trace (sorted by arrival time) and fills the report */
+static void sim_run(const sim_config_t* config, const sim_arrival_t* trace, uint32_t n, sim_report_t* report) {
+    sched_dispatcher_t dispatcher;
+    sched_dispatcher_init(&dispatcher, config->policy, SIM_MAX_THREADS, config->slots);
+    sim_instance_t* running[SIM_MAX_THREADS] = {0};
+    uint32_t num_unfetched = 0;
+    uint32_t num_detached = 0;
+    uint32_t stack_bytes = 0;
+    uint32_t live_per_task[SIM_MAX_TASKS] = {0};
+    uint32_t num_waits = 0;
+    uint32_t next = 0;
+    uint64_t now = 0;
+    memset(report, 0, sizeof(*report));
+    report->arrivals = n;
+
+    while (next < n || dispatcher.num_running > 0 || sched_dispatcher_queued(&dispatcher) > 0 || num_unfetched > 0) {
+        /* Jump to the next arrival, completion or result fetch */
+        uint64_t event = next < n ? trace[next].at_us : UINT64_MAX;
+        for (uint32_t i = 0; i < SIM_MAX_THREADS; i++) {
+            if (running[i] != NULL && running[i]->end_us < event) event = running[i]->end_us;
+        }
+        for (uint32_t i = 0; i < num_unfetched; i++) {
+            if (unfetched[i]->release_us < event) event = unfetched[i]->release_us;
+        }
+        now = event;
+
+        /* Completions give their slot back (_tboard_check_running()), their instance waits for the result query */
+        for (uint32_t i = 0; i < SIM_MAX_THREADS; i++) {
+            sim_instance_t* instance = running[i];
+            if (instance == NULL || instance->end_us > now) continue;
+            running[i] = NULL;
+            sched_dispatcher_done(&dispatcher, instance->deadline);
+            stack_bytes -= instance->stack_bytes;
+            sim_finish(config, instance, now, &num_unfetched);
+            report->completed++;
+            if (instance->deadline != SCHED_NO_DEADLINE && instance->end_us > instance->deadline) report->late++;
+            report->makespan_us = now;
+        }
+
+        /* Fetched results destroy their instance (task_instance_destroy()) */
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < num_unfetched; i++) {
+            sim_instance_t* instance = unfetched[i];
+            if (instance->release_us > now) {
+                unfetched[kept++] = instance;
+            } else if (instance->detached) {
+                num_detached--;
+            } else {
+                live_per_task[instance->arrival->task]--;
+            }
+        }
+        num_unfetched = kept;
+
+        /* Arrivals: same checks as _cnode_release_finished(), task_instance_create() and sched_dispatcher_push() */
+        while (next < n && trace[next].at_us == now) {
+            const sim_arrival_t* arrival = &trace[next];
+            sim_instance_t* instance = &instances[next++];
+            instance->arrival = arrival;
+            instance->detached = false;
+            instance->deadline = arrival->deadline_us != SIM_NO_DEADLINE ? now + arrival->deadline_us : SCHED_NO_DEADLINE;
+            for (uint32_t i = 0; i < num_unfetched && live_per_task[arrival->task] >= config->max_instances &&
+                                 num_detached < config->finished_capacity; i++) {
+                if (unfetched[i]->arrival->task != arrival->task || unfetched[i]->detached) continue;
+                unfetched[i]->detached = true;
+                num_detached++;
+                live_per_task[arrival->task]--;
+            }
+            if (live_per_task[arrival->task] >= config->max_instances ||
+                !sched_dispatcher_push(&dispatcher, instance, instance->deadline)) {
+                report->rejected++;
+                continue;
+            }
+            live_per_task[arrival->task]++;
+        }
+
+        /* Dispatch: same decisions as _tboard_dispatch() */
+        sched_entry_t entry;
+        sched_dispatch_t decision;
+        while ((decision = sched_dispatcher_next(&dispatcher, now, &entry)) != SCHED_DISPATCH_NONE) {
+            sim_instance_t* instance = (sim_instance_t*) entry.item;
+            if (decision == SCHED_DISPATCH_EXPIRED) {
+                sim_finish(config, instance, now, &num_unfetched);
+                report->dropped++;
+                continue;
+            }
+            instance->start_us = now;
+            instance->end_us = now + instance->arrival->duration_us;
+            instance->stack_bytes = sim_stack_size(config, instance->arrival->task);
+            stack_bytes += instance->stack_bytes;
+            waits[num_waits++] = now - instance->arrival->at_us;
+            for (uint32_t i = 0; i < SIM_MAX_THREADS; i++) {
+                if (running[i] == NULL) {
+                    running[i] = instance;
+                    break;
+                }
+            }
+        }
+
+        uint32_t queued = sched_dispatcher_queued(&dispatcher);
+        uint32_t live = dispatcher.num_running + queued + num_unfetched - num_detached;
+        if (live > report->peak_live) report->peak_live = live;
+        if (queued > report->peak_queued) report->peak_queued = queued;
+        if (stack_bytes > report->peak_stack_bytes) report->peak_stack_bytes = stack_bytes;
+    }
+
+    qsort(waits, num_waits, sizeof(waits[0]), compare_u64);
+    report->wait_p50_us = percentile(waits, num_waits, 50);
+    report->wait_p90_us = percentile(waits, num_waits, 90);
+    report->wait_p99_us = percentile(waits, num_waits, 99);
+    report->wait_max_us = num_waits > 0 ? waits[num_waits - 1] : 0;
+}
+
+static void sim_print(const char* name, const sim_config_t* config, const sim_report_t* report) {
+    double seconds = report->makespan_us / 1e6;
+    printf("%-8s %s %2lu slots: %5lu done %4lu dropped %4lu rejected %4lu late | %8.1f /s | wait p50 %6llu p90 %6llu "
+           "p99 %6llu max %6llu us | peak %3lu live %3lu queued %6lu stack bytes\n",
+           name, config->policy == SCHED_POLICY_EDF ? "EDF " : "FIFO", (unsigned long) config->slots,
+           (unsigned long) report->completed, (unsigned long) report->dropped, (unsigned long) report->rejected,
+           (unsigned long) report->late, seconds > 0 ? report->completed / seconds : 0.0,
+           (unsigned long long) report->wait_p50_us, (unsigned long long) report->wait_p90_us,
+           (unsigned long long) report->wait_p99_us, (unsigned long long) report->wait_max_us,
+           (unsigned long) report->peak_live, (unsigned long) report->peak_queued,
+           (unsigned long) report->peak_stack_bytes);
+}
+
+/* xorshift32: the generated trace only depends on the seed */
+static uint32_t sim_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/* Bursty trace: mean inter-arrival of mean_gap_us, one burst of 20 REXECs every 500 arrivals, four tasks with their
+   own duration range and deadline */
+static uint32_t sim_generate(sim_arrival_t* trace, uint32_t n, uint32_t seed, uint64_t mean_gap_us) {
+    static const uint64_t min_duration[4] = {200, 1000, 5000, 20000};
+    static const uint64_t deadline[4] = {2000, 20000, SIM_NO_DEADLINE, 100000};
+    uint32_t state = seed;
+    uint64_t at = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        bool burst = (i % 500) < 20;
+        at += burst ? 0 : sim_random(&state) % (2 * mean_gap_us + 1);
+        uint32_t task = sim_random(&state) % 4;
+        trace[i].at_us = at;
+        trace[i].task = task;
+        trace[i].duration_us = min_duration[task] + sim_random(&state) % min_duration[task];
+        trace[i].deadline_us = deadline[task];
+    }
+    return n;
+}
+
+static sim_arrival_t trace[SIM_MAX_ARRIVALS];
+
+int main(void)
+{
+    sim_report_t fifo_report, edf_report;
+
+    /* One slot busy until t=100; six relaxed REXECs then one urgent REXEC (deadline t=151) arrive at t=1. FIFO only
+       reaches it at t=160, EDF starts it at t=100. */
+    static const sim_arrival_t scripted[] = {
+        {0, 0, 100, 10000},
+        {1, 1, 10, 1000}, {1, 1, 10, 1000}, {1, 1, 10, 1000}, {1, 2, 10, 1000}, {1, 2, 10, 1000}, {1, 2, 10, 1000},
+        {1, 3, 10, 150},
+    };
+    uint32_t n = sizeof(scripted) / sizeof(scripted[0]);
+    sim_config_t fifo = {.policy = SCHED_POLICY_FIFO, .slots = 1, .max_instances = SIM_DEFAULT_INSTANCES};
+    sim_config_t edf = {.policy = SCHED_POLICY_EDF, .slots = 1, .max_instances = SIM_DEFAULT_INSTANCES};
+    sim_run(&fifo, scripted, n, &fifo_report);
+    sim_run(&edf, scripted, n, &edf_report);
+    assert(fifo_report.completed == 7 && fifo_report.dropped == 1);
+    assert(edf_report.completed == 8 && edf_report.dropped == 0);
+    assert(edf_report.makespan_us == 170 && edf_report.wait_max_us == 159);
+    printf("Scripted EDF vs FIFO test passed \r\n");
+
+    /* Ten REXECs of one task at once: five fit its instance table, the other five are rejected */
+    sim_arrival_t flood[10];
+    for (uint32_t i = 0; i < 10; i++) {
+        flood[i] = (sim_arrival_t) {0, 0, 100, 1000000};
+    }
+    sim_config_t one_slot = {.policy = SCHED_POLICY_FIFO, .slots = 1, .max_instances = SIM_DEFAULT_INSTANCES};
+    sim_run(&one_slot, flood, 10, &fifo_report);
+    assert(fifo_report.completed == 5 && fifo_report.rejected == 5);
+    assert(fifo_report.peak_live == 5 && fifo_report.peak_queued == 4 && fifo_report.peak_stack_bytes == SIM_STACK_SIZE);
+    /* Without instance limit, the ready queue capacity is the limit */
+    static sim_arrival_t big_flood[SCHED_QUEUE_CAPACITY + 10];
+    for (uint32_t i = 0; i < SCHED_QUEUE_CAPACITY + 10; i++) {
+        big_flood[i] = (sim_arrival_t) {0, 0, 100, 1000000};
+    }
+    one_slot.max_instances = UINT32_MAX;
+    sim_run(&one_slot, big_flood, SCHED_QUEUE_CAPACITY + 10, &fifo_report);
+    assert(fifo_report.rejected == 10 && fifo_report.completed == SCHED_QUEUE_CAPACITY);
+    printf("Capacity limits test passed \r\n");
+
+    /* Three REXECs with a deadline and three without at once, one slot: only the ones with a deadline wait for it */
+    sim_arrival_t mixed[6];
+    for (uint32_t i = 0; i < 6; i++) {
+        mixed[i] = (sim_arrival_t) {0, i % 2, 100, i % 2 == 0 ? 1000000 : SIM_NO_DEADLINE};
+    }
+    one_slot.max_instances = SIM_DEFAULT_INSTANCES;
+    sim_run(&one_slot, mixed, 6, &fifo_report);
+    assert(fifo_report.completed == 6 && fifo_report.peak_queued == 2);
+    assert(fifo_report.peak_stack_bytes == 4 * SIM_STACK_SIZE && fifo_report.makespan_us == 300);
+    printf("Instances without a deadline not capped test passed \r\n");
+
+    /* One REXEC done at t=10, five more arrive at t=50, its result is fetched at t=1010: the cnode moves it out of its
+       slot and all five fit; with no room for finished instances it still holds one of the five slots of the task */
+    sim_arrival_t held[6] = {{0, 0, 10, SIM_NO_DEADLINE}};
+    for (uint32_t i = 1; i < 6; i++) {
+        held[i] = (sim_arrival_t) {50, 0, 10, SIM_NO_DEADLINE};
+    }
+    one_slot.fetch_delay_us = 1000;
+    one_slot.finished_capacity = SIM_FINISHED_CAPACITY;
+    sim_run(&one_slot, held, 6, &fifo_report);
+    assert(fifo_report.completed == 6 && fifo_report.rejected == 0 && fifo_report.peak_live == 5);
+    one_slot.finished_capacity = 0;
+    sim_run(&one_slot, held, 6, &fifo_report);
+    assert(fifo_report.completed == 5 && fifo_report.rejected == 1 && fifo_report.peak_live == 5);
+    printf("Result fetch test passed \r\n");
+
+    /* Task 0 peaked at 300 bytes: TASK_STACK_MIN_SIZE, task 1 at 1800 bytes: 1800 + TASK_STACK_MARGIN */
+    sim_arrival_t profiled[2] = {{0, 0, 100, SIM_NO_DEADLINE}, {0, 1, 100, SIM_NO_DEADLINE}};
+    sim_config_t two_slots = {.policy = SCHED_POLICY_FIFO, .slots = 2, .max_instances = SIM_DEFAULT_INSTANCES,
+                              .stack_used = {300, 1800}};
+    sim_run(&two_slots, profiled, 2, &fifo_report);
+    assert(fifo_report.peak_stack_bytes == 2 * SIM_STACK_SIZE);
+    two_slots.adaptive_stack = true;
+    sim_run(&two_slots, profiled, 2, &fifo_report);
+    assert(fifo_report.peak_stack_bytes == SIM_STACK_MIN_SIZE + 1800 + SIM_STACK_MARGIN);
+    printf("Adaptive stack test passed \r\n");
+
+    n = sim_generate(trace, SIM_MAX_ARRIVALS, 42, 1500);
+    /* The controller fetches a result 2 ms after the end of its instance, stacks sized from a measured profile */
+    sim_config_t config = {.policy = SCHED_POLICY_EDF, .slots = SIM_DEFAULT_SLOTS, .max_instances = 16,
+                           .finished_capacity = SIM_FINISHED_CAPACITY, .fetch_delay_us = 2000, .adaptive_stack = true, .stack_used = {400, 900, 1600, 2400}};
+    sim_run(&config, trace, n, &edf_report);
+    sim_run(&config, trace, n, &fifo_report);
+    assert(memcmp(&edf_report, &fifo_report, sizeof(sim_report_t)) == 0);
+    assert(edf_report.completed + edf_report.dropped + edf_report.rejected == n);
+    printf("Deterministic report test passed \r\n");
+
+    clock_t begin = clock();
+    static const uint32_t slot_counts[] = {2, 4, 8};
+    for (uint32_t s = 0; s < 3; s++) {
+        for (int p = 0; p < 2; p++) {
+            config.policy = p == 0 ? SCHED_POLICY_FIFO : SCHED_POLICY_EDF;
+            config.slots = slot_counts[s];
+            sim_run(&config, trace, n, &edf_report);
+            sim_print("bursty", &config, &edf_report);
+        }
+    }
+    printf("Simulated %.1f s of traffic six times in %.3f s \r\n", edf_report.makespan_us / 1e6,
+           (double) (clock() - begin) / CLOCKS_PER_SEC);
+    return 0;
+}
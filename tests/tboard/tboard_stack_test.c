@@ -0,0 +1,103 @@
+/***********************
+* tboard stack profile tests.
+* NOTE: Prerequisite test(s): tboard_unit.c
+* Stack high-water mark sampled when a thread instance completes test
+* Adaptive stack size from the sampled maximum test
+* Stack profile saved to NVS and loaded back on registration test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+2. The test erases the stored stack profile of the "deep" task before and after it runs.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+#include "core.h"
+
+#define DEEP_BYTES 256
+
+/**
+ * Stub: touches DEEP_BYTES of its stack.
+*/
+void entry_point_deep(execution_context_t* ctx) {
+    volatile uint8_t buffer[DEEP_BYTES];
+    for (int i = 0; i < DEEP_BYTES; i++) buffer[i] = (uint8_t) i;
+    ctx->return_arg->val.ival = buffer[DEEP_BYTES - 1];
+}
+
+/* Same key as the tboard gives the profile of a task */
+static void erase_profile(task_t* task) {
+    char key[16];
+    snprintf(key, sizeof(key), "stk%08lx", (unsigned long) task->name_hash);
+    assert(core_store_erase(TBOARD_NVS_NAMESPACE, key));
+}
+
+static task_instance_t* run_deep(tboard_t* tboard, int serial_id) {
+    task_instance_t* instance = tboard_start_task(tboard, "deep", serial_id, NULL);
+    assert(instance != NULL);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->error == REXEC_ERR_NONE && instance->return_arg->val.ival == DEEP_BYTES - 1);
+    return instance;
+}
+
+void app_main(void)
+{
+    tboard_t* tboard = tboard_create();
+    task_t* deep = task_create("deep", INT_TYPE, "", entry_point_deep);
+    erase_profile(deep);
+    tboard_register_task(tboard, deep);
+    assert(deep->max_stack_used == 0);
+
+    task_instance_t* instance = run_deep(tboard, 0);
+    assert(instance->stack_size == TASK_STACK_SIZE);
+    assert(instance->stack_used >= DEEP_BYTES && instance->stack_used < instance->stack_size);
+    assert(deep->max_stack_used == instance->stack_used && deep->stack_samples == 1);
+    assert(tboard->stack_profile_dirty);
+    uint32_t stack_used = instance->stack_used;
+    task_instance_destroy(instance);
+    printf("Stack high-water mark test passed \r\n");
+
+    /* Off by default: every instance gets TASK_STACK_SIZE */
+    assert(tboard_get_task_stack_size(tboard, deep) == TASK_STACK_SIZE);
+    tboard_set_adaptive_stack(tboard, true);
+    uint32_t expected = stack_used + TASK_STACK_MARGIN < TASK_STACK_MIN_SIZE ? TASK_STACK_MIN_SIZE
+                                                                           : stack_used + TASK_STACK_MARGIN;
+    assert(tboard_get_task_stack_size(tboard, deep) == expected);
+    instance = run_deep(tboard, 1);
+    assert(instance->stack_size == expected);
+    assert(deep->stack_samples == 2 && deep->max_stack_used >= stack_used);
+    stack_used = deep->max_stack_used;
+    task_instance_destroy(instance);
+    printf("Adaptive stack size test passed \r\n");
+
+    assert(tboard_save_stack_profile(tboard));
+    assert(!tboard->stack_profile_dirty);
+    tboard_destroy(tboard);
+
+    /* After a reboot: the task is registered again and starts from the saved maximum */
+    tboard = tboard_create();
+    deep = task_create("deep", INT_TYPE, "", entry_point_deep);
+    tboard_register_task(tboard, deep);
+    assert(deep->max_stack_used == stack_used && deep->stack_samples == 0);
+    tboard_set_adaptive_stack(tboard, true);
+    expected = stack_used + TASK_STACK_MARGIN < TASK_STACK_MIN_SIZE ? TASK_STACK_MIN_SIZE : stack_used + TASK_STACK_MARGIN;
+    assert(tboard_get_task_stack_size(tboard, deep) == expected);
+    instance = run_deep(tboard, 0);
+    assert(instance->stack_size == expected);
+    task_instance_destroy(instance);
+    printf("Stack profile round trip test passed \r\n");
+
+    erase_profile(deep);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,123 @@
+/***********************
+* tboard task accounting tests.
+* NOTE: Prerequisite test(s): tboard_unit.c, tboard_coroutine_test.c
+* Wall time and queue wait of a thread instance test
+* Heap bytes allocated by the instance charged to it test
+* CPU time below the wall time of a sleeping instance test
+* Coroutine instance accounted across its resumes test
+* Statistics encoded as CMD_GET_STATS values test
+* Destructor/memory leak test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* NOTE: Make sure #define MEMORY_DEBUG is uncommented in utils.h
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+***********************/
+
+#include "utils.h"
+#include "task.h"
+#include "tboard.h"
+
+#define SLEEP_MS 50
+
+typedef struct {
+    uint8_t data[64];
+} blob_t;
+
+/**
+ * Stub: allocates a blob, releases it and sleeps.
+*/
+void entry_point_sleepy(execution_context_t* ctx) {
+    blob_t* blob = calloc(1, sizeof(blob_t));
+    assert(blob != NULL);
+    {free(blob);}
+    vTaskDelay(pdMS_TO_TICKS(SLEEP_MS));
+    ctx->return_arg->val.ival = 1;
+}
+
+/**
+ * Coroutine stub: allocates a blob on every resume, over three resumes.
+*/
+void entry_point_co(execution_context_t* ctx) {
+    uint32_t* round = TASK_CO_LOCALS(ctx, uint32_t);
+    TASK_CO_BEGIN(ctx);
+    for (*round = 0; *round < 3; (*round)++) {
+        {
+            blob_t* blob = calloc(1, sizeof(blob_t));
+            {free(blob);}
+        }
+        TASK_CO_YIELD(ctx);
+    }
+    ctx->return_arg->val.ival = 3;
+    TASK_CO_END(ctx);
+}
+
+void app_main(void)
+{
+    tboard_t* tboard = tboard_create();
+    task_t* sleepy = task_create("sleepy", INT_TYPE, "", entry_point_sleepy);
+    tboard_register_task(tboard, sleepy);
+
+    task_instance_t* instance = tboard_start_task(tboard, "sleepy", 0, NULL);
+    assert(instance != NULL);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->queued_us != 0 && instance->start_us >= instance->queued_us);
+    assert(instance->end_us - instance->start_us >= SLEEP_MS * 1000 - 1000 * portTICK_PERIOD_MS);
+    printf("Wall time and queue wait test passed \r\n");
+
+    assert(instance->heap_bytes == sizeof(blob_t));
+    printf("Heap charged to the instance test passed \r\n");
+
+    assert(instance->cpu_us < instance->end_us - instance->start_us);
+    printf("CPU time test passed \r\n");
+
+    task_stats_t stats;
+    task_get_stats(sleepy, &stats);
+    assert(stats.runs == 1);
+    assert(stats.max_wall_us == instance->end_us - instance->start_us && stats.total_wall_us == stats.max_wall_us);
+    assert(stats.total_heap_bytes == sizeof(blob_t) && stats.max_heap_bytes == sizeof(blob_t));
+    task_instance_destroy(instance);
+
+    task_t* co = task_create("co", INT_TYPE, "", entry_point_co);
+    assert(task_set_coroutine_mode(co, sizeof(uint32_t)));
+    tboard_register_task(tboard, co);
+    instance = tboard_start_task(tboard, "co", 1, NULL);
+    assert(instance != NULL);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->return_arg->val.ival == 3);
+    assert(instance->heap_bytes == 3 * sizeof(blob_t));
+    task_get_stats(co, &stats);
+    assert(stats.runs == 1 && stats.total_heap_bytes == 3 * sizeof(blob_t));
+    task_instance_destroy(instance);
+    printf("Coroutine accounting test passed \r\n");
+
+    /* A dropped instance never ran and is not accounted */
+    tboard_start_options_t opts;
+    tboard_start_options_default(&opts);
+    opts.deadline_us = 1;
+    instance = tboard_start_task_opts(tboard, "sleepy", 2, NULL, &opts);
+    assert(instance != NULL);
+    while (!instance->has_finished) vTaskDelay(1);
+    assert(instance->error == REXEC_ERR_DEADLINE_EXPIRED);
+    task_instance_destroy(instance);
+    task_get_stats(sleepy, &stats);
+    assert(stats.runs == 1);
+
+    arg_t values[TASK_STATS_NUM_VALUES];
+    task_stats_to_args(sleepy, values);
+    assert(values[0].nargs == TASK_STATS_NUM_VALUES && values[0].type == INT_TYPE);
+    assert(values[0].val.ival == 1);
+    assert(values[1].val.ival == stats.max_wall_us && values[2].val.ival == stats.max_wall_us);
+    assert(values[6].val.ival == sizeof(blob_t) && values[7].val.ival == sizeof(blob_t));
+    printf("Stats values test passed \r\n");
+
+    tboard_print_tasks(tboard);
+    tboard_destroy(tboard);
+    assert(total_mem_usage == 0);
+    printf("Memory leak test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,85 @@
+/***********************
+* zenoh outbound buffer pool tests.
+* NOTE: Prerequisite test(s): zenoh_multiple_publishers_test_board_1.c
+* Acquire by size class test (small, large fallback, too large)
+* Exhaustion and release test
+* Pooled publish test (buffers come back once sent)
+* Static publish test
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. Run the following code as the main function and check if any asserts are not met.
+2. A second board subscribed to "app/**" (e.g. zenoh_multiple_publishers_test_board_2.c) shows the published messages.
+***********************/
+
+#include "zenoh.h"
+#include "system_manager.h"
+
+static const uint8_t static_message[] = "static message from cnode";
+
+void app_main(void)
+{
+    /* Init wifi */
+    system_manager_t* sm = system_manager_init();
+    if (!system_manager_wifi_init(sm)) {
+        printf("Could not init wifi \r\n");
+        exit(-1);
+    }
+
+    /* Init Zenoh session */
+    zenoh_t* zn = zenoh_init();
+    if (zn == NULL) {
+        printf("Could not init Zenoh session \r\n");
+        exit(-1);
+    }
+
+    zenoh_start_lease_task(zn);
+    zenoh_start_read_task(zn);
+
+    zenoh_pub_t z_pub;
+    assert(zenoh_declare_pub(zn, "app/replies/up", &z_pub));
+
+    uint8_t* small = zenoh_buf_acquire(zn, 16);
+    assert(small == &zn->pool.small[0][0]);
+    uint8_t* large = zenoh_buf_acquire(zn, ZENOH_POOL_SMALL_SIZE + 1);
+    assert(large == &zn->pool.large[0][0]);
+    assert(zenoh_buf_acquire(zn, ZENOH_POOL_LARGE_SIZE + 1) == NULL);
+    assert(zn->pool.misses == 1);
+    zenoh_buf_release(zn, small);
+    zenoh_buf_release(zn, large);
+    printf("Acquire test passed \r\n");
+
+    uint8_t* taken[ZENOH_POOL_SMALL_COUNT + ZENOH_POOL_LARGE_COUNT];
+    for (int i = 0; i < ZENOH_POOL_SMALL_COUNT + ZENOH_POOL_LARGE_COUNT; i++) {
+        taken[i] = zenoh_buf_acquire(zn, 16);
+        assert(taken[i] != NULL);
+    }
+    assert(zenoh_buf_acquire(zn, 16) == NULL);
+    for (int i = 0; i < ZENOH_POOL_SMALL_COUNT + ZENOH_POOL_LARGE_COUNT; i++) {
+        zenoh_buf_release(zn, taken[i]);
+    }
+    assert(zn->pool.small_free == (1u << ZENOH_POOL_SMALL_COUNT) - 1);
+    assert(zn->pool.large_free == (1u << ZENOH_POOL_LARGE_COUNT) - 1);
+    printf("Exhaustion test passed \r\n");
+
+    for (int i = 0; i < 3 * ZENOH_POOL_SMALL_COUNT; i++) {
+        uint8_t* buf = zenoh_buf_acquire(zn, 32);
+        assert(buf != NULL);
+        int len = snprintf((char*) buf, 32, "pooled message %d", i);
+        assert(zenoh_publish_pooled(zn, &z_pub, buf, (size_t) len));
+    }
+    sleep(1);
+    assert(zn->pool.small_free == (1u << ZENOH_POOL_SMALL_COUNT) - 1);
+    printf("Pooled publish test passed \r\n");
+
+    assert(zenoh_publish_static(zn, &z_pub, static_message, sizeof(static_message) - 1));
+    assert(zenoh_publish_encoded(zn, &z_pub, static_message, sizeof(static_message) - 1));
+    sleep(1);
+    assert(zn->pool.small_free == (1u << ZENOH_POOL_SMALL_COUNT) - 1);
+    printf("Static publish test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,145 @@
+/***********************
+* zenoh controller discovery tests.
+* NOTE: Prerequisite test(s): zenoh_multiple_publishers_test_board_1.c
+* Locator cache round trip test
+* Boot by scouting test (empty cache, the locators found are cached)
+* Boot from the cache test (no scouting, reports both boot times)
+* Stale cache test (a dead cached locator falls back to scouting)
+* Background discovery test (a boot from the cache refreshes a stale cache at once, the locator in use first)
+* Supervisor failover test (after a forced session loss, a dead locator in use moves to the next known one)
+* Unknown locator failover test (a locator in use that is not known moves to the first known one)
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. Start a zenoh router (the controller) on the Wi-Fi network, e.g. zenohd -l tcp/0.0.0.0:7447
+2. Run the following code as the main function and check if any asserts are not met.
+3. Compare the printed boot times: the boot from the cache should take the time of a single connect.
+4. Only routers are kept: a zenoh peer on the network must not show up in the cached locators.
+***********************/
+
+#include "zenoh.h"
+#include "system_manager.h"
+
+#define DEAD_LOCATOR "tcp/10.255.255.1:7447"
+#define UNKNOWN_LOCATOR "tcp/10.255.255.2:7447"
+#define FAILOVER_WAIT_MS 30000 // dead locator connect timeouts and the reconnection backoff
+
+static zenoh_locators_t no_locators;
+
+/* Whether a locator is in the cache */
+static bool cached(const char* locator) {
+    zenoh_locators_t loaded;
+    zenoh_locators_load(&loaded);
+    for (uint32_t i = 0; i < loaded.count; i++) {
+        if (strcmp(loaded.locators[i], locator) == 0) return true;
+    }
+    return false;
+}
+
+/* Forces a session loss (see ZENOH_MAX_TX_FAILURES) and waits for the supervisor to reconnect */
+static void force_reconnect(zenoh_t* zn) {
+    uint32_t reconnects = zn->reconnects;
+    zn->tx_failures = ZENOH_MAX_TX_FAILURES;
+    for (int waited_ms = 0; zn->reconnects == reconnects; waited_ms += 100) {
+        assert(waited_ms < FAILOVER_WAIT_MS);
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    assert(zenoh_is_connected(zn));
+}
+
+void app_main(void)
+{
+    /* Init wifi */
+    system_manager_t* sm = system_manager_init();
+    if (!system_manager_wifi_init(sm)) {
+        printf("Could not init wifi \r\n");
+        exit(-1);
+    }
+
+    zenoh_locators_t locators = {0};
+    strcpy(locators.locators[locators.count++], "tcp/10.0.0.1:7447");
+    strcpy(locators.locators[locators.count++], "udp/10.0.0.2:7447");
+    assert(zenoh_locators_save(&locators));
+    zenoh_locators_t loaded;
+    assert(zenoh_locators_load(&loaded));
+    assert(loaded.count == 2 && strcmp(loaded.locators[1], "udp/10.0.0.2:7447") == 0);
+    assert(zenoh_locators_save(&no_locators));
+    assert(!zenoh_locators_load(&loaded) && loaded.count == 0);
+    printf("Locator cache test passed \r\n");
+
+    zenoh_config_t config;
+    zenoh_config_default(&config);
+    config.connect[0] = '\0';
+
+    zenoh_t* zn = zenoh_init_discovered(&config);
+    assert(zn != NULL);
+    assert(zn->discovery && !zn->from_cache);
+    assert(strcmp(zn->config.mode, "client") == 0 && zn->config.listen[0] == '\0');
+    assert(zenoh_locators_load(&loaded) && strcmp(loaded.locators[0], zn->config.connect) == 0);
+    uint32_t scouted_ms = zn->discovery_ms;
+    zenoh_destroy(zn);
+    printf("Scouting boot test passed (%lu ms) \r\n", (unsigned long) scouted_ms);
+
+    zn = zenoh_init_discovered(&config);
+    assert(zn != NULL);
+    assert(zn->from_cache);
+    assert(zn->discovery_ms < scouted_ms);
+    printf("Cached boot test passed (%lu ms, %lu ms by scouting) \r\n", (unsigned long) zn->discovery_ms,
+           (unsigned long) scouted_ms);
+    zenoh_destroy(zn);
+
+    /* The controller moved: the stale locator is tried first, then scouting finds the current one */
+    locators.count = 0;
+    strcpy(locators.locators[locators.count++], DEAD_LOCATOR);
+    assert(zenoh_locators_save(&locators));
+    zn = zenoh_init_discovered(&config);
+    assert(zn != NULL);
+    assert(!zn->from_cache);
+    assert(zenoh_locators_load(&loaded) && strcmp(loaded.locators[0], DEAD_LOCATOR) != 0);
+    char controller[ZENOH_LOCATOR_LEN];
+    strcpy(controller, zn->config.connect);
+    zenoh_destroy(zn);
+    printf("Stale cache test passed \r\n");
+
+    /* The controller and a dead locator cached: the boot uses the cache, the background task scouts at once and caches
+       what answered */
+    locators.count = 0;
+    strcpy(locators.locators[locators.count++], controller);
+    strcpy(locators.locators[locators.count++], DEAD_LOCATOR);
+    assert(zenoh_locators_save(&locators));
+    zn = zenoh_init_discovered(&config);
+    assert(zn != NULL && zn->from_cache);
+    assert(zenoh_start_discovery(zn));
+    for (int waited_ms = 0; cached(DEAD_LOCATOR); waited_ms += 100) {
+        assert(waited_ms < ZENOH_SCOUT_TIMEOUT_MS + 2000);
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    zenoh_stop_discovery(zn);
+    assert(zenoh_locators_load(&loaded) && strcmp(loaded.locators[0], controller) == 0);
+    printf("Background discovery test passed \r\n");
+
+    /* The supervisor reconnects to the dead locator in use, fails, then moves to the controller after it */
+    assert(zenoh_start_supervisor(zn));
+    zn->locators.count = 0;
+    strcpy(zn->locators.locators[zn->locators.count++], DEAD_LOCATOR);
+    strcpy(zn->locators.locators[zn->locators.count++], controller);
+    strcpy(zn->config.connect, DEAD_LOCATOR);
+    force_reconnect(zn);
+    assert(strcmp(zn->config.connect, controller) == 0);
+    printf("Supervisor failover test passed \r\n");
+
+    /* A locator in use that is not among the known ones moves to the first known one */
+    zn->locators.count = 0;
+    strcpy(zn->locators.locators[zn->locators.count++], controller);
+    strcpy(zn->config.connect, UNKNOWN_LOCATOR);
+    force_reconnect(zn);
+    assert(strcmp(zn->config.connect, controller) == 0);
+    zenoh_stop_supervisor(zn);
+    zenoh_destroy(zn);
+    printf("Unknown locator failover test passed \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}
@@ -0,0 +1,189 @@
+/***********************
+* zenoh session configuration tests and transport benchmark, on the host (linux target) build.
+* NOTE: Prerequisite test(s): none, both ends run in this process over the loopback interface
+* Locator / transport parsing test
+* Stored configuration round trip test (CORE_HOST_STORE_DIR/zenoh.config)
+* Transport benchmark: messages published by one session to a subscriber of a second session, for UDP multicast, UDP
+* unicast and TCP. A burst of BENCH_MESSAGES back to back gives the message rate (its latencies mostly measure the
+* queueing behind the burst), then BENCH_PACED_MESSAGES sent one per tick give the latency percentiles. Every message
+* carries the id of its phase, so burst messages arriving late are not counted in the paced phase. A transport
+* whose sessions cannot be opened (e.g. zenoh-pico built without it) is reported as skipped.
+*
+* Last modified: 10/19/2026
+* Version: 1
+* USAGE:
+1. idf.py --preview set-target linux, run the following code as the main function and check if any asserts are not met.
+2. Compare the reports to choose the transport of a deployment, then store it with zenoh_config_save() (or
+   cnode_apply_args() with save) on the nodes.
+***********************/
+
+#include "zenoh.h"
+#include "utils.h"
+
+#define BENCH_MESSAGES 2000
+#define BENCH_PACED_MESSAGES 500
+#define BENCH_MESSAGE_LEN 64
+#define BENCH_DRAIN_MS 2000
+#define BENCH_KEYEXPR "bench/transport"
+
+typedef struct {
+    const char* name;
+    const char* listen;     // locator of the subscriber session, "" for none
+    const char* connect;    // locator of the publisher session
+} bench_transport_t;
+
+static const bench_transport_t transports[] = {
+    {"udp-multicast", "", "udp/224.0.0.224:7450#iface=lo"},
+    {"udp", "udp/127.0.0.1:7451", "udp/127.0.0.1:7451"},
+    {"tcp", "tcp/127.0.0.1:7452", "tcp/127.0.0.1:7452"},
+};
+
+static int64_t latencies_us[BENCH_MESSAGES];
+static volatile uint8_t phase; // id of the running phase, carried by its messages after the send time and the index
+static volatile uint32_t received;
+static volatile int64_t last_received_us;
+
+static void bench_handler(z_loaned_sample_t* sample, void* arg) {
+    uint8_t message[BENCH_MESSAGE_LEN];
+    z_bytes_reader_t reader = z_bytes_get_reader(z_sample_payload(sample));
+    size_t len = z_bytes_reader_read(&reader, message, sizeof(message));
+    if (len < sizeof(int64_t) + sizeof(uint32_t) + 1 || message[sizeof(int64_t) + sizeof(uint32_t)] != phase ||
+        received >= BENCH_MESSAGES) {
+        return;
+    }
+    int64_t sent_us;
+    memcpy(&sent_us, message, sizeof(sent_us));
+    last_received_us = jam_time_us();
+    latencies_us[received++] = last_received_us - sent_us;
+}
+
+static int compare_latency(const void* a, const void* b) {
+    int64_t x = *(const int64_t*) a, y = *(const int64_t*) b;
+    return (x > y) - (x < y);
+}
+
+static int64_t percentile(uint32_t count, int p) {
+    return latencies_us[(count - 1) * p / 100];
+}
+
+static zenoh_t* open_session(const char* listen, const char* connect) {
+    zenoh_config_t config;
+    zenoh_config_default(&config);
+    strcpy(config.listen, listen);
+    strcpy(config.connect, connect);
+    zenoh_t* zn = zenoh_init_with_config(&config);
+    if (zn != NULL) {
+        zenoh_start_read_task(zn);
+        zenoh_start_lease_task(zn);
+    }
+    return zn;
+}
+
+/* Publishes messages, back to back or one per tick, waits for them and prints the report of the phase */
+static void bench_phase(const bench_transport_t* transport, zenoh_t* pub_zn, zenoh_pub_t* z_pub, uint32_t messages,
+                        bool paced) {
+    uint8_t message[BENCH_MESSAGE_LEN] = {0};
+    phase++;
+    received = 0;
+    message[sizeof(int64_t) + sizeof(uint32_t)] = phase;
+    int64_t start_us = jam_time_us();
+    for (uint32_t i = 0; i < messages; i++) {
+        int64_t now_us = jam_time_us();
+        memcpy(message, &now_us, sizeof(now_us));
+        memcpy(message + sizeof(now_us), &i, sizeof(i));
+        zenoh_publish_encoded(pub_zn, z_pub, message, sizeof(message));
+        if (paced) {
+            vTaskDelay(1);
+        }
+    }
+    for (int waited_ms = 0; received < messages && waited_ms < BENCH_DRAIN_MS; waited_ms += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    uint32_t count = received;
+    if (count == 0) {
+        printf("%-14s %-6s no message received \r\n", transport->name, paced ? "paced" : "burst");
+        return;
+    }
+    qsort(latencies_us, count, sizeof(int64_t), compare_latency);
+    if (paced) {
+        printf("%-14s paced  %5lu/%lu received, latency us p50 %lld p90 %lld p99 %lld max %lld \r\n",
+               transport->name, (unsigned long) count, (unsigned long) messages, (long long) percentile(count, 50),
+               (long long) percentile(count, 90), (long long) percentile(count, 99), (long long) latencies_us[count - 1]);
+    } else {
+        double seconds = (double) (last_received_us - start_us) / 1e6;
+        printf("%-14s burst  %5lu/%lu received, %8.0f msg/s, queueing us p50 %lld max %lld \r\n",
+               transport->name, (unsigned long) count, (unsigned long) messages, count / seconds,
+               (long long) percentile(count, 50), (long long) latencies_us[count - 1]);
+    }
+}
+
+static void bench_transport(const bench_transport_t* transport) {
+    /* The subscriber listens first (or joins the group), the publisher then connects to it */
+    zenoh_t* sub_zn = open_session(transport->listen, transport->listen[0] != '\0' ? "" : transport->connect);
+    zenoh_t* pub_zn = sub_zn != NULL ? open_session("", transport->connect) : NULL;
+    if (sub_zn == NULL || pub_zn == NULL) {
+        printf("%-14s skipped, the sessions could not be opened \r\n", transport->name);
+        zenoh_destroy(sub_zn);
+        return;
+    }
+    assert(zenoh_subscribe(sub_zn, BENCH_KEYEXPR, bench_handler, NULL) >= 0);
+    zenoh_pub_t z_pub;
+    assert(zenoh_declare_pub(pub_zn, BENCH_KEYEXPR, &z_pub));
+    sleep(1);
+
+    bench_phase(transport, pub_zn, &z_pub, BENCH_MESSAGES, false);
+    bench_phase(transport, pub_zn, &z_pub, BENCH_PACED_MESSAGES, true);
+
+    zenoh_undeclare_pub(pub_zn, &z_pub);
+    zenoh_destroy(pub_zn);
+    zenoh_destroy(sub_zn);
+}
+
+void app_main(void)
+{
+    assert(zenoh_locator_transport("udp/224.0.0.224:7446#iface=eth0") == ZENOH_TRANSPORT_UDP_MULTICAST);
+    assert(zenoh_locator_transport("udp/192.168.1.10:7447") == ZENOH_TRANSPORT_UDP_UNICAST);
+    assert(zenoh_locator_transport("udp/[ff02::1]:7446#iface=eth0") == ZENOH_TRANSPORT_UDP_MULTICAST);
+    assert(zenoh_locator_transport("udp/[fe80::1]:7447") == ZENOH_TRANSPORT_UDP_UNICAST);
+    assert(zenoh_locator_transport("udp/[ff::1]:7447") == ZENOH_TRANSPORT_UDP_UNICAST);
+    assert(zenoh_locator_transport("tcp/192.168.1.10:7447") == ZENOH_TRANSPORT_TCP);
+    assert(zenoh_locator_transport("serial/ttyUSB0") == ZENOH_TRANSPORT_UNKNOWN);
+    assert(zenoh_transport_from_str("udp-multicast") == ZENOH_TRANSPORT_UDP_MULTICAST);
+    assert(zenoh_transport_from_str("quic") == ZENOH_TRANSPORT_UNKNOWN);
+
+    zenoh_config_t config;
+    zenoh_config_default(&config);
+    assert(zenoh_config_set_endpoint(&config, ZENOH_TRANSPORT_TCP, "192.168.1.10", 7447, NULL));
+    assert(strcmp(config.connect, "tcp/192.168.1.10:7447") == 0);
+    assert(!zenoh_config_set_endpoint(&config, ZENOH_TRANSPORT_UDP_MULTICAST, "192.168.1.10", 7447, NULL));
+    assert(zenoh_config_set_endpoint(&config, ZENOH_TRANSPORT_UDP_MULTICAST, "224.0.0.224", 7446, "eth0"));
+    assert(strcmp(config.connect, ZENOH_DEFAULT_CONNECT) == 0);
+    assert(zenoh_config_set_endpoint(&config, ZENOH_TRANSPORT_UDP_MULTICAST, "ff02::1", 7446, "eth0"));
+    assert(strcmp(config.connect, "udp/[ff02::1]:7446#iface=eth0") == 0);
+    printf("Locator test passed \r\n");
+
+    zenoh_config_t original;
+    bool stored = zenoh_config_load(&original);
+    assert(zenoh_config_set_endpoint(&config, ZENOH_TRANSPORT_UDP_UNICAST, "10.0.0.1", 7447, NULL));
+    strcpy(config.mode, "client");
+    assert(zenoh_config_save(&config));
+    zenoh_config_t loaded;
+    assert(zenoh_config_load(&loaded));
+    assert(strcmp(loaded.mode, "client") == 0 && strcmp(loaded.connect, "udp/10.0.0.1:7447") == 0);
+    strcpy(config.mode, "router");
+    assert(!zenoh_config_save(&config));
+    /* Leave the storage as it was found */
+    assert(stored ? zenoh_config_save(&original) : zenoh_config_erase());
+    assert(zenoh_config_load(&loaded) == stored);
+    printf("Stored configuration test passed \r\n");
+
+    for (size_t i = 0; i < sizeof(transports) / sizeof(transports[0]); i++) {
+        bench_transport(&transports[i]);
+    }
+    printf("Transport benchmark done \r\n");
+
+    while (true) {
+        sleep(1);
+    }
+}